@@ -4,6 +4,7 @@
 #include "bltin/bltin.h"
 #include "parser/parse.h"
 #include "elf64.h"
+#include "optimize.h"
 
 char usageStr[] = 
 	"Usage: basque [options] file\n"
@@ -15,6 +16,10 @@ char usageStr[] =
 	"  -r,--run                Run the compiled code after compilation.\n"
 	"  -s,--silence-warnings   Silence warnings.\n"
 	"  -W,--warnings-as-errors Treat warnings as errors.\n"
+	"  -O<LEVEL>               Optimize the generated code: 0 for none, 1 for\n"
+	"                          cleaning up the generated code, 2 to also keep\n"
+	"                          variables in registers. -O is the same as -O2.\n"
+	"  --opt-stats             Display how often each optimization was applied.\n"
 	"  --disable-assertions    Disable compiling code for \"assert\" statements.\n"
 	"  --include-path <PATH>   Set paths for searching for included files.\n"
 	"  --page-size <SIZE>      Size in bytes of memory pages.\n"
@@ -69,6 +74,15 @@ int main(int argc, char* argv[]) {
 						case 'W':
 							ba_SetWarnsAsErrs();
 							break;
+						case 'O':
+						{
+							u8 level = BA_OPT_MAXLEVEL;
+							if (argv[i][j+1] >= '0' && argv[i][j+1] <= '9') {
+								level = argv[i][++j] - '0';
+							}
+							ba_SetOptLevel(level);
+							break;
+						}
 						default:
 							fprintf(stderr, "Error: Command line option %s "
 								"not found\n", argv[i]);
@@ -106,6 +120,10 @@ int main(int argc, char* argv[]) {
 			ba_SetPageSize(atoll(argv[i]));
 			goto BA_LBL_MAIN_ARGSLOOPEND;
 		}
+		else if (!strcmp(argv[i], "--opt-stats")) {
+			ba_SetOptStats(1);
+			goto BA_LBL_MAIN_ARGSLOOPEND;
+		}
 		else if (!strcmp(argv[i], "--disable-assertions")) {
 			ba_SetAssertions(0);
 			goto BA_LBL_MAIN_ARGSLOOPEND;
@@ -172,32 +190,31 @@ int main(int argc, char* argv[]) {
 	strcpy(ctr->dir, srcFileName);
 	ctr->dir = dirname(ctr->dir);
 
-	if (!ba_Tokenize(ctr, srcFile)) {
-		return 1;
-	}
-	fclose(srcFile);
-	
-	// DEBUG
-	/*
-	struct ba_Lexeme* lex = ctr->startLex;
-	while (lex) {
-		fprintf(stderr, "%llx %s\n", lex->type, lex->val);
-		lex = lex->next;
-	}
-	*/
+	// Lexing happens as the parser asks for lexemes
+	ba_LexPushFile(ctr, srcFile, srcFileName);
 
 	if (!ba_Parse(ctr)) {
 		return 1;
 	}
+	// Nothing refers to lexemes after parsing
+	ba_ArenaRelease(BA_ARENA_LEX);
+	ba_DelTkBuf(ctr->tks);
+	ctr->tks = 0;
+	ctr->lex = 0;
 
 	// ----- Optimization -----
-	// TODO: optimization
+	
+	ba_RunOptPasses(ctr, /* isAfterEmplace = */ 0);
+	ba_EmplaceIM(ctr);
+	ba_RunOptPasses(ctr, /* isAfterEmplace = */ 1);
+	ba_IsOptStats() && (ba_OptPrintStats(stderr), 1);
 
 	// ----- Binary generation -----
 	
 	if (!ba_WriteBinary(outFileName, ctr)) {
 		return 1;
 	}
+	ba_ArenaRelease(BA_ARENA_PARSE);
 
 	if (isRunCode) {
 		char* runFileName = outFileName;
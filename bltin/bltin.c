@@ -5,6 +5,8 @@
 #include "../common/symtable.h"
 
 u64 bltinLbls[BA_BLTIN__COUNT] = {0};
+// Registers written by built-ins that aren't funcs (ba_Func)
+u64 bltinClobbers[BA_BLTIN__COUNT] = {0};
 u64 bltinFlags[BA_BLTIN_FLAG_CNT] = {0};
 
 void ba_BltinFlagsSet(u64 flag) {
@@ -23,18 +25,28 @@ u64 ba_BltinLblGet(u64 bltin) {
 	return bltinLbls[bltin];
 }
 
+void ba_BltinClobberSet(u64 bltin, u64 regs) {
+	bltinClobbers[bltin] = regs;
+}
+
+u64 ba_BltinClobberGet(u64 bltin) {
+	return bltinClobbers[bltin];
+}
+
 struct ba_Func* ba_IncludeAddFunc(struct ba_Ctr* ctr, u64 line, u64 col, 
 	char* funcName) 
 {
-	struct ba_STVal* prevFuncIdVal = ba_HTGet(ctr->currScope->ht, funcName);
+	funcName = ba_Intern(funcName);
+	struct ba_STVal* prevFuncIdVal = ba_STGet(ctr->currScope, funcName);
 	if (prevFuncIdVal && (prevFuncIdVal->type.type != BA_TYPE_FUNC || 
 		prevFuncIdVal->isInited))
 	{
 		ba_ErrorVarRedef(funcName, line, col, ctr->currPath);
 	}
 
-	struct ba_STVal* funcIdVal = ba_MAlloc(sizeof(*funcIdVal));
-	ba_HTSet(ctr->currScope->ht, funcName, (void*)funcIdVal);
+	struct ba_STVal* funcIdVal = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*funcIdVal));
+	ba_STSet(ctr->currScope, funcName, (void*)funcIdVal);
 
 	funcIdVal->scope = ctr->currScope;
 	funcIdVal->type.type = BA_TYPE_FUNC;
@@ -42,6 +54,7 @@ struct ba_Func* ba_IncludeAddFunc(struct ba_Ctr* ctr, u64 line, u64 col,
 
 	struct ba_Func* func = ba_NewFunc();
 	funcIdVal->type.extraInfo = (void*)func;
+	func->isDefined = 1; // Its IM is generated by the caller
 	
 	return func;
 }
@@ -41,6 +41,8 @@ void ba_BltinFlagsSet(u64 flag);
 u64 ba_BltinFlagsTest(u64 flag);
 void ba_BltinLblSet(u64 bltin, u64 lbl);
 u64 ba_BltinLblGet(u64 bltin);
+void ba_BltinClobberSet(u64 bltin, u64 regs);
+u64 ba_BltinClobberGet(u64 bltin);
 struct ba_Func* ba_IncludeAddFunc(struct ba_Ctr* ctr, u64 line, u64 col, 
 	char* funcName);
 
@@ -1,25 +1,22 @@
 // See LICENSE for copyright/license information
 
 #include "bltin.h"
+#include "../common/reg.h"
 
-/* Params (stack): string buffer address (0x8), int to convert (0x8)
+/* Params: string buffer address (rsi), int to convert (rdi)
  * Returns (rax): string length */
 void ba_BltinU64ToStr(struct ba_Ctr* ctr) {
 	ba_BltinFlagsSet(BA_BLTIN_FormatU64ToStr);
 	ba_BltinLblSet(BA_BLTIN_FormatU64ToStr, ctr->labelCnt);
 	ctr->labelCnt += 7;
 	
-	struct ba_IM* oldIM = ctr->im;
-	struct ba_IM* oldStartIM = ctr->startIM;
-
-	ctr->startIM = ba_NewIM();
-	ctr->im = ctr->startIM;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = ba_NewIMBuf();
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-7); // U64ToStr
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBX);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RSI, BA_IM_ADRADD, BA_IM_RBP, 0x18); // str
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDI, BA_IM_ADRADD, BA_IM_RBP, 0x10); // int
 	ba_AddIM(ctr, 3, BA_IM_TEST, BA_IM_RDI, BA_IM_RDI);
 	ba_AddIM(ctr, 2, BA_IM_LABELJNZ, ctr->labelCnt-6); // MakeDigits
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_AL, BA_IM_IMM, 0x30);
@@ -77,35 +74,31 @@ void ba_BltinU64ToStr(struct ba_Ctr* ctr) {
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-1); // Epilogue
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBX);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64));
-	ctr->im->vals[0] = BA_IM_RET;
-	ctr->im->count = 1;
-	ctr->im->next = oldStartIM;
+	*ba_IMBufAdd(ctr->im) = (struct ba_IM){ 1, { BA_IM_RET } };
+	ba_BltinClobberSet(BA_BLTIN_FormatU64ToStr, ba_IMClobberRegs(ctr->im));
+	ba_IMBufPrepend(ctr->startIM, ctr->im);
 	ctr->im = oldIM;
 }
 
-/* Params (stack): string buffer address (0x8), int to convert (0x8)
+/* Params: string buffer address (rsi), int to convert (rdi)
  * Returns (rax): string length */
 void ba_BltinI64ToStr(struct ba_Ctr* ctr) {
 	ba_BltinFlagsSet(BA_BLTIN_FormatI64ToStr);
 	ba_BltinLblSet(BA_BLTIN_FormatI64ToStr, ctr->labelCnt);
 	ctr->labelCnt += 9;
 	
-	struct ba_IM* oldIM = ctr->im;
-	struct ba_IM* oldStartIM = ctr->startIM;
-
-	ctr->startIM = ba_NewIM();
-	ctr->im = ctr->startIM;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = ba_NewIMBuf();
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-9);
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_R8);
+	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBX);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
 	ba_AddIM(ctr, 3, BA_IM_XOR, BA_IM_R8, BA_IM_R8);
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RSI, BA_IM_ADRADD, BA_IM_RBP, 0x20); // str
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDI, BA_IM_ADRADD, BA_IM_RBP, 0x18); // int
 	ba_AddIM(ctr, 3, BA_IM_TEST, BA_IM_RDI, BA_IM_RDI);
 	ba_AddIM(ctr, 2, BA_IM_LABELJG, ctr->labelCnt-7);
 	ba_AddIM(ctr, 2, BA_IM_LABELJL, ctr->labelCnt-8);
@@ -168,38 +161,35 @@ void ba_BltinI64ToStr(struct ba_Ctr* ctr) {
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-1);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBX);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_R8);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64));
-	ctr->im->vals[0] = BA_IM_RET;
-	ctr->im->count = 1;
-	ctr->im->next = oldStartIM;
+	*ba_IMBufAdd(ctr->im) = (struct ba_IM){ 1, { BA_IM_RET } };
+	ba_BltinClobberSet(BA_BLTIN_FormatI64ToStr, ba_IMClobberRegs(ctr->im));
+	ba_IMBufPrepend(ctr->startIM, ctr->im);
 	ctr->im = oldIM;
 }
 
-/* Params (stack): string buffer address (0x8), int to convert (0x8)
+/* Params: string buffer address (rsi), int to convert (rdi)
  * Returns (rax): string length */
 void ba_BltinHexToStr(struct ba_Ctr* ctr) {
 	ba_BltinFlagsSet(BA_BLTIN_FormatHexToStr);
 	ba_BltinLblSet(BA_BLTIN_FormatHexToStr, ctr->labelCnt);
 	ctr->labelCnt += 7;
 	
-	struct ba_IM* oldIM = ctr->im;
-	struct ba_IM* oldStartIM = ctr->startIM;
-
-	ctr->startIM = ba_NewIM();
-	ctr->im = ctr->startIM;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = ba_NewIMBuf();
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-7); // HexToStr
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBX);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RAX, BA_IM_IMM, 0x6665646362613938);
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RAX);
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RAX, BA_IM_IMM, 0x3736353433323130);
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RAX);
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RSI, BA_IM_ADRADD, BA_IM_RBP, 0x18); // str
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDX, BA_IM_ADRADD, BA_IM_RBP, 0x10); // int
+	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDX, BA_IM_RDI); // int
 	ba_AddIM(ctr, 3, BA_IM_TEST, BA_IM_RDX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABELJNZ, ctr->labelCnt-6); // MakeDigits
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_AL, BA_IM_IMM, 0x30);
@@ -246,33 +236,30 @@ void ba_BltinHexToStr(struct ba_Ctr* ctr) {
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-1); // Epilogue
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBX);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64));
-	ctr->im->vals[0] = BA_IM_RET;
-	ctr->im->count = 1;
-	ctr->im->next = oldStartIM;
+	*ba_IMBufAdd(ctr->im) = (struct ba_IM){ 1, { BA_IM_RET } };
+	ba_BltinClobberSet(BA_BLTIN_FormatHexToStr, ba_IMClobberRegs(ctr->im));
+	ba_IMBufPrepend(ctr->startIM, ctr->im);
 	ctr->im = oldIM;
 }
 
-/* Params (stack): string buffer address (0x8), int to convert (0x8)
+/* Params: string buffer address (rsi), int to convert (rdi)
  * Returns (rax): string length */
 void ba_BltinOctToStr(struct ba_Ctr* ctr) {
 	ba_BltinFlagsSet(BA_BLTIN_FormatOctToStr);
 	ba_BltinLblSet(BA_BLTIN_FormatOctToStr, ctr->labelCnt);
 	ctr->labelCnt += 7;
 	
-	struct ba_IM* oldIM = ctr->im;
-	struct ba_IM* oldStartIM = ctr->startIM;
-
-	ctr->startIM = ba_NewIM();
-	ctr->im = ctr->startIM;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = ba_NewIMBuf();
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-7); // OctToStr
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBX);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RSI, BA_IM_ADRADD, BA_IM_RBP, 0x18); // str
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDX, BA_IM_ADRADD, BA_IM_RBP, 0x10); // int
+	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDX, BA_IM_RDI); // int
 	ba_AddIM(ctr, 3, BA_IM_TEST, BA_IM_RDX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABELJNZ, ctr->labelCnt-6); // MakeDigits
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_AL, BA_IM_IMM, 0x30);
@@ -317,33 +304,30 @@ void ba_BltinOctToStr(struct ba_Ctr* ctr) {
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-1); // Epilogue
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBX);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64));
-	ctr->im->vals[0] = BA_IM_RET;
-	ctr->im->count = 1;
-	ctr->im->next = oldStartIM;
+	*ba_IMBufAdd(ctr->im) = (struct ba_IM){ 1, { BA_IM_RET } };
+	ba_BltinClobberSet(BA_BLTIN_FormatOctToStr, ba_IMClobberRegs(ctr->im));
+	ba_IMBufPrepend(ctr->startIM, ctr->im);
 	ctr->im = oldIM;
 }
 
-/* Params (stack): string buffer address (0x8), int to convert (0x8)
+/* Params: string buffer address (rsi), int to convert (rdi)
  * Returns (rax): string length */
 void ba_BltinBinToStr(struct ba_Ctr* ctr) {
 	ba_BltinFlagsSet(BA_BLTIN_FormatBinToStr);
 	ba_BltinLblSet(BA_BLTIN_FormatBinToStr, ctr->labelCnt);
 	ctr->labelCnt += 7;
 	
-	struct ba_IM* oldIM = ctr->im;
-	struct ba_IM* oldStartIM = ctr->startIM;
-
-	ctr->startIM = ba_NewIM();
-	ctr->im = ctr->startIM;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = ba_NewIMBuf();
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-7); // BinToStr
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBX);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RSI, BA_IM_ADRADD, BA_IM_RBP, 0x18); // str
-	ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDX, BA_IM_ADRADD, BA_IM_RBP, 0x10); // int
+	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDX, BA_IM_RDI); // int
 	ba_AddIM(ctr, 3, BA_IM_TEST, BA_IM_RDX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABELJNZ, ctr->labelCnt-6); // MakeDigits
 	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_AL, BA_IM_IMM, 0x30);
@@ -388,12 +372,12 @@ void ba_BltinBinToStr(struct ba_Ctr* ctr) {
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
 	ba_AddIM(ctr, 2, BA_IM_LABEL, ctr->labelCnt-1); // Epilogue
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBX);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64));
-	ctr->im->vals[0] = BA_IM_RET;
-	ctr->im->count = 1;
-	ctr->im->next = oldStartIM;
+	*ba_IMBufAdd(ctr->im) = (struct ba_IM){ 1, { BA_IM_RET } };
+	ba_BltinClobberSet(BA_BLTIN_FormatBinToStr, ba_IMClobberRegs(ctr->im));
+	ba_IMBufPrepend(ctr->startIM, ctr->im);
 	ctr->im = oldIM;
 }
 
@@ -0,0 +1,47 @@
+// See LICENSE for copyright/license information
+
+#include "arena.h"
+
+struct ba_ArenaBlock* arenaBlocks[BA_ARENA_CNT] = {0};
+
+void* ba_ArenaAlloc(u8 arenaId, u64 size) {
+	// Keep everything 8 byte aligned
+	size = (size + 7) & ~7llu;
+
+	struct ba_ArenaBlock* block = arenaBlocks[arenaId];
+	if (!block || block->used + size > block->cap) {
+		u64 cap = size > BA_ARENA_BLOCK_SIZE ? size : BA_ARENA_BLOCK_SIZE;
+		// calloc'd, so memory from the arena is always zeroed
+		struct ba_ArenaBlock* newBlock = 
+			ba_CAlloc(1, sizeof(*newBlock) + cap);
+		newBlock->cap = cap;
+		newBlock->used = 0;
+
+		// Oversized blocks go under the current one so that the space left 
+		// in the current block isn't wasted
+		if (block && cap > BA_ARENA_BLOCK_SIZE) {
+			newBlock->prev = block->prev;
+			block->prev = newBlock;
+			newBlock->used = size;
+			return (u8*)(newBlock + 1);
+		}
+
+		newBlock->prev = block;
+		arenaBlocks[arenaId] = newBlock;
+		block = newBlock;
+	}
+
+	void* ptr = (u8*)(block + 1) + block->used;
+	block->used += size;
+	return ptr;
+}
+
+void ba_ArenaRelease(u8 arenaId) {
+	struct ba_ArenaBlock* block = arenaBlocks[arenaId];
+	while (block) {
+		struct ba_ArenaBlock* prev = block->prev;
+		free(block);
+		block = prev;
+	}
+	arenaBlocks[arenaId] = 0;
+}
@@ -0,0 +1,32 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__COMMON_ARENA_H
+#define BA__COMMON_ARENA_H
+
+#include "common.h"
+
+// Default size of a block allocated by an arena
+#define BA_ARENA_BLOCK_SIZE (1024 * 1024)
+
+/* Objects that live as long as a compiler phase are bump allocated from that 
+ * phase's arena, and the whole arena is released at once when the phase's 
+ * data is no longer needed. Memory returned by an arena is zeroed. */
+enum {
+	BA_ARENA_LEX    = 0, // Lexemes and their values, released after parsing
+	BA_ARENA_PARSE  = 1, // Symbol tables, IM, parser stack items
+	BA_ARENA_ENCODE = 2, // Binary generation
+	BA_ARENA_ATOM   = 3, // Interned strings, never released
+	BA_ARENA_CNT,
+};
+
+struct ba_ArenaBlock {
+	struct ba_ArenaBlock* prev;
+	u64 cap;
+	u64 used;
+	// Block data follows the header
+};
+
+void* ba_ArenaAlloc(u8 arenaId, u64 size);
+void ba_ArenaRelease(u8 arenaId);
+
+#endif
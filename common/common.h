@@ -31,6 +31,8 @@
 
 typedef unsigned long long u64;
 typedef signed long long i64;
+typedef unsigned int u32;
+typedef unsigned short u16;
 typedef _Bool bool;
 typedef unsigned char u8;
 typedef signed char i8;
@@ -8,8 +8,9 @@
 struct ba_Ctr* ba_NewCtr() {
 	struct ba_Ctr* ctr = ba_MAlloc(sizeof(struct ba_Ctr));
 
-	ctr->startLex = ba_NewLexeme();
-	ctr->lex = ctr->startLex;
+	ctr->lexSrc = 0;
+	ctr->tks = ba_NewTkBuf(0x100);
+	ctr->lex = 0;
 	ctr->dir = 0;
 	ctr->currPath = 0;
 
@@ -26,21 +27,24 @@ struct ba_Ctr* ba_NewCtr() {
 	ctr->funcFrameStk = ba_NewStk();
 	ctr->expCoercedTypeStk = ba_NewStk();
 
-	ctr->startIM = ba_NewIM();
+	ctr->startIM = ba_NewIMBuf();
 	ctr->im = ctr->startIM;
-	ctr->entryIM = ctr->startIM;
+	// Builtin functions may be put before this
+	ctr->entryIM = ctr->startIM->first->ims;
 
 	ctr->globalST = ba_NewSymTable();
 	ctr->globalST->frameScope = ctr->globalST;
+	ctr->globalST->isOpen = 1;
 	ctr->currScope = ctr->globalST;
 
-	ctr->labelTable = ba_NewHashTable();
+	ctr->labelTable = ba_NewAtomHashTable(BA_HASHTABLE_CAPACITY);
 	ctr->inclInodes = ba_NewDynArr64(0x400);
 	ctr->usedRegisters = 0;
 	ctr->imStackSize = 0;
 	ctr->statics = ba_NewDynArr64(0x400);
 	ctr->labelCnt = 1; // Starts at 1 since label 0 means no label found
 	ctr->isPermitArrLit = 0;
+	ctr->tailCallPos = 0;
 
 	ctr->paren = 0;
 	ctr->bracket = 0;
@@ -53,34 +57,24 @@ struct ba_Ctr* ba_NewCtr() {
 }
 
 void ba_DelCtr(struct ba_Ctr* ctr) {
-	ba_DelLexeme(ctr->startLex);
-	ba_DelLexeme(ctr->lex);
-
-	for (u64 i = 0; i < ctr->pTkStk->cap; i++) {
-		free(ctr->pTkStk->items[i]);
+	// Lexeme values, IM, symbol tables and parser stack items are owned by 
+	// arenas
+	if (ctr->tks) {
+		ba_DelTkBuf(ctr->tks);
 	}
 	ba_DelStk(ctr->pTkStk);
-	for (u64 i = 0; i < ctr->pOpStk->cap; i++) {
-		free(ctr->pOpStk->items[i]);
-	}
 	ba_DelStk(ctr->pOpStk);
-	for (u64 i = 0; i < ctr->pBreakStk->cap; i++) {
-		free(ctr->pBreakStk->items[i]);
-	}
 	ba_DelStk(ctr->pBreakStk);
-	for (u64 i = 0; i < ctr->shortCircLblStk->cap; i++) {
-		free(ctr->shortCircLblStk->items[i]);
-	}
 	ba_DelStk(ctr->shortCircLblStk);
 
-	ba_DelIM(ctr->startIM);
-	ba_DelIM(ctr->im);
-
 	ba_DelSymTable(ctr->globalST);
 	ba_DelHashTable(ctr->labelTable);
 	ba_DelDynArr64(ctr->inclInodes);
 	ba_DelDynArr64(ctr->statics);
 
+	ba_ArenaRelease(BA_ARENA_LEX);
+	ba_ArenaRelease(BA_ARENA_PARSE);
+
 	free(ctr);
 }
 
@@ -89,20 +83,17 @@ void ba_AddIM(struct ba_Ctr* ctr, u64 count, ...) {
 		return;
 	}
 
-	ctr->im->vals = ba_MAlloc(sizeof(u64) * count);
+	struct ba_IM* im = ba_IMBufAdd(ctr->im);
 	
 	va_list vals;
 	va_start(vals, count);
 	for (u64 i = 0; i < count; i++) {
-		ctr->im->vals[i] = va_arg(vals, u64);
+		im->vals[i] = va_arg(vals, u64);
 	}
 	va_end(vals);
 
-	ctr->im->count = count;
-	ctr->im->next = ba_NewIM();
+	im->count = count;
 	
-	//printf("%s\n", ba_IMToStr(ctr->im)); // DEBUG
-
-	ctr->im = ctr->im->next;
+	//printf("%s\n", ba_IMToStr(im)); // DEBUG
 }
 
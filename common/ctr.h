@@ -6,13 +6,17 @@
 #include "exitmsg.h"
 #include "stack.h"
 #include "im.h"
+#include "arena.h"
+#include "lexeme.h"
 
 struct ba_Func; // Forward declaration
+struct ba_LexSrc; // Forward declaration
 
 struct ba_Ctr { // Controller
 	// Lexer
-	struct ba_Lexeme* startLex;
-	struct ba_Lexeme* lex;
+	struct ba_LexSrc* lexSrc; // Source file currently being lexed
+	struct ba_TkBuf* tks;
+	u64 lex; // Index in tks of the lexeme being parsed
 
 	// Parser
 	struct ba_Stk* pTkStk; // Takes ba_PTkStkItem as items
@@ -31,15 +35,16 @@ struct ba_Ctr { // Controller
 	struct ba_Stk* cmpLblStk; // Takes u64 (label IDs) as items
 	struct ba_Stk* cmpRegStk; // Takes u64 (im enum for registers) as items
 	// Func stack frame
-	struct ba_Stk* funcFrameStk; // Takes u64 (usedRegisters) as items
+	// Takes u64 (usedRegisters, then the registers saved) as items
+	struct ba_Stk* funcFrameStk;
 	// For type coercion in array literals
 	struct ba_Stk* expCoercedTypeStk; // Takes struct ba_Type* as items
 	// For turning on and off intermediate instruction generation
 	struct ba_Stk* genImStk; // Takes u64 (bool) as items
 
 	// Code generation
-	struct ba_IM* startIM;
-	struct ba_IM* im;
+	struct ba_IMBuf* startIM; // IM of the whole program
+	struct ba_IMBuf* im; // Where IM is currently being added
 	struct ba_IM* entryIM;
 	
 	// Parser
@@ -48,12 +53,21 @@ struct ba_Ctr { // Controller
 	struct ba_DynArr64* statics; // takes ba_Static* as elements
 	u64 labelCnt;
 	bool isPermitArrLit;
+	u64 tailCallPos; // Position of the "(" of a call in tail position
 	
 	// Counts expression parentheses etc. to make sure they are balanced
 	i64 paren;
 	i64 bracket;
 };
 
+// Fields of the lexeme being parsed
+#define BA_LEX_SLOT(ctr) BA_TK_SLOT((ctr)->tks, (ctr)->lex)
+#define BA_LEX_TYPE(ctr) ((ctr)->tks->types[BA_LEX_SLOT(ctr)])
+#define BA_LEX_LINE(ctr) ((ctr)->tks->lineCols[BA_LEX_SLOT(ctr)] >> 32)
+#define BA_LEX_COL(ctr) ((ctr)->tks->lineCols[BA_LEX_SLOT(ctr)] & 0xffffffff)
+#define BA_LEX_VAL(ctr) ((ctr)->tks->vals[BA_LEX_SLOT(ctr)])
+#define BA_LEX_VALLEN(ctr) ((u64)(ctr)->tks->valLens[BA_LEX_SLOT(ctr)])
+
 struct ba_Ctr* ba_NewCtr();
 void ba_DelCtr(struct ba_Ctr* ctr);
 void ba_AddIM(struct ba_Ctr* ctr, u64 count, ...);
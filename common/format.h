@@ -8,9 +8,10 @@
 #include "types.h"
 
 struct ba_FStr { // Linked list
-	void* val; /* If !formatType, then char*, otherwise ba_Lexeme* */
-	u64 len; /* If formatType is BA_FTYPE_STR, then this is a ba_Lexeme*, a 
-	            pointer to the expression calculating the string's length. */
+	void* val; /* If !formatType, then char*, otherwise the index in ctr->tks 
+	              of the expression's first lexeme */
+	u64 len; /* If formatType is BA_FTYPE_STR, then this is the index in 
+	            ctr->tks of the expression calculating the string's length. */
 	struct ba_FStr* next;
 	struct ba_FStr* last;
 	u64 formatType; // If 0 then val is a char*
@@ -1,37 +1,68 @@
 // See LICENSE for copyright/license information
 
 #include "func.h"
+#include "reg.h"
 
 struct ba_FuncParam* ba_NewFuncParam() {
-	struct ba_FuncParam* param = ba_CAlloc(1, sizeof(*param));
+	struct ba_FuncParam* param = ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*param));
 	return param;
 }
+
+// Register of the idx-th argument passed in a register, or 0 if on the stack
+u64 ba_FuncArgReg(u64 idx) {
+	u64 regs[BA_FUNC_ARGREGCNT] = 
+		{ BA_IM_RDI, BA_IM_RSI, BA_IM_RDX, BA_IM_RCX, BA_IM_R8, BA_IM_R9 };
+	return idx < BA_FUNC_ARGREGCNT ? regs[idx] : 0;
+}
+
+/* Registers (BA_CTRREG_*) that may be changed by a call to func, which
+ * include its arg registers and rax. Unknown until the func is fully 
+ * defined, except for built-in funcs, which call nothing. */
+u64 ba_FuncClobberRegs(struct ba_Func* func) {
+	if (!func->isClobberKnown) {
+		if (func->childScope) {
+			return BA_CTRREG_ALL;
+		}
+		func->clobberRegs = ba_IMClobberRegs(func->im);
+		func->isClobberKnown = 1;
+	}
+	u64 regs = func->clobberRegs | BA_CTRREG_RAX;
+	struct ba_FuncParam* param = func->firstParam;
+	for (u64 i = 0; i < func->paramCnt; i++) {
+		regs |= ba_IMToCtrReg(param->reg);
+		param = param->next;
+	}
+	return regs;
+}
  
 struct ba_Func* ba_NewFunc() {
 	struct ba_Func* func = ba_MAlloc(sizeof(*func));
 	func->retType = (struct ba_Type){0};
 	func->lblStart = 0;
 	func->lblEnd = 0;
+	func->lblBody = 0;
+	func->lblCnt = 0;
 	func->childScope = 0;
 	func->firstParam = 0;
 	func->paramCnt = 0;
 	func->paramStackSize = 0;
 	func->contextSize = 0;
-	func->imBegin = ba_NewIM();
-	func->imEnd = 0;
+	func->im = ba_NewIMBuf();
+	func->clobberRegs = 0;
 	func->isCalled = 0;
 	func->doesReturn = 0;
+	func->isClobberKnown = 0;
+	func->isInline = 0;
+	func->isInlinable = 0;
+	func->inlineSize = 0;
+	func->isDefined = 0;
+	func->ctfeResults = 0;
+	func->isCTFEOutOfFuel = 0;
 	return func;
 }
  
 void ba_DelFunc(struct ba_Func* func) {
 	ba_DelSymTable(func->childScope);
-	struct ba_FuncParam* param = func->firstParam;
-	while (param) {
-		struct ba_FuncParam* next = param->next;
-		free(param);
-		param = next;
-	}
 	free(func);
 }
 
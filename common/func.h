@@ -12,6 +12,7 @@ struct ba_FuncParam {
 	struct ba_FuncParam* next;
 	void* defaultVal;
 	struct ba_STVal* stVal;
+	u64 reg; // Register the argument is passed in, or 0 if on the stack
 	bool hasDefaultVal;
 };
 
@@ -19,18 +20,33 @@ struct ba_Func {
 	struct ba_Type retType;
 	u64 lblStart;
 	u64 lblEnd;
+	u64 lblBody; // After the prologue, jumped to by tail calls
+	u64 lblCnt; // Labels used by the func's own IM, starting at lblStart
 	struct ba_SymTable* childScope;
 	struct ba_FuncParam* firstParam;
 	u64 paramCnt;
 	u64 paramStackSize;
 	u64 contextSize;
-	struct ba_IM* imBegin;
-	struct ba_IM* imEnd;
+	struct ba_IMBuf* im;
+	u64 clobberRegs; // Registers (BA_CTRREG_*) that calling it may change
 	bool isCalled;
 	bool doesReturn;
+	bool isClobberKnown; // clobberRegs is complete
+	bool isInline; // Declared with 'inline'
+	bool isInlinable; // Can be copied into callers (see inline.c)
+	u64 inlineSize; // IM in the body
+	bool isDefined; // Its whole body has been generated
+	struct ba_CTFEResult* ctfeResults; // Calls run while compiling
+	bool isCTFEOutOfFuel; // Calls to it are no longer run while compiling
 };
 
+/* The first few integer and pointer arguments of a func are passed in
+ * registers, in this order */
+#define BA_FUNC_ARGREGCNT 6
+
 struct ba_FuncParam* ba_NewFuncParam();
+u64 ba_FuncArgReg(u64 idx);
+u64 ba_FuncClobberRegs(struct ba_Func* func);
 struct ba_Func* ba_NewFunc();
 void ba_DelFunc(struct ba_Func* func);
 
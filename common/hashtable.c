@@ -2,73 +2,124 @@
 
 #include "hashtable.h"
 #include "exitmsg.h"
+#include "intern.h"
 
+// FNV-1a, with the high bits folded in since only the low bits index
 u64 ba_Hash(char* str) {
-	u64 hash = 0;
+	u64 hash = 0xcbf29ce484222325llu;
 	u64 c;
-	while ((c = *str)) {
-		hash = c + (hash << 6) + (hash << 16) - hash;
+	while ((c = (u8)*str)) {
+		hash = (hash ^ c) * 0x100000001b3llu;
 		++str;
 	}
-	return hash;
+	return hash ^ (hash >> 32);
 }
 
 struct ba_HashTable* ba_NewHashTable() {
+	return ba_NewHashTableCap(BA_HASHTABLE_CAPACITY);
+}
+
+// capacity must be a power of 2
+struct ba_HashTable* ba_NewHashTableCap(u64 capacity) {
 	struct ba_HashTable* ht = ba_MAlloc(sizeof(*ht));
 	
-	ht->entries = ba_CAlloc(BA_HASHTABLE_CAPACITY, sizeof(*ht->entries));
-	ht->capacity = BA_HASHTABLE_CAPACITY;
+	ht->entries = ba_CAlloc(capacity, sizeof(*ht->entries));
+	ht->capacity = capacity;
 	ht->count = 0;
+	ht->isAtomKeys = 0;
+
+	return ht;
+}
 
+// capacity must be a power of 2
+struct ba_HashTable* ba_NewAtomHashTable(u64 capacity) {
+	struct ba_HashTable* ht = ba_NewHashTableCap(capacity);
+	ht->isAtomKeys = 1;
 	return ht;
 }
 
 void ba_DelHashTable(struct ba_HashTable* ht) {
+	for (u64 i = 0; !ht->isAtomKeys && i < ht->capacity; i++) {
+		free(ht->entries[i].key);
+	}
 	free(ht->entries);
 	free(ht);
 }
 
-void* ba_HTGet(struct ba_HashTable* ht, char* key) {
-	u64 hash = ba_Hash(key);
-	u64 index = (u64)(hash & (u64)(ht->capacity - 1));
+u64 HTKeyHash(struct ba_HashTable* ht, char* key) {
+	return ht->isAtomKeys ? ba_AtomHash(key) : ba_Hash(key);
+}
 
-	while (ht->entries[index].key) {
-		if (!strcmp(key, ht->entries[index].key)) {
-			return ht->entries[index].val;
+// Distance of the entry at index from the slot its hash maps to
+u64 HTProbeDist(struct ba_HashTable* ht, u64 index) {
+	return (index - ht->entries[index].hash) & (ht->capacity - 1);
+}
+
+// Returns the index of key, or -1 if key isn't in the table
+u64 HTFind(struct ba_HashTable* ht, char* key, u64 hash) {
+	u64 mask = ht->capacity - 1;
+	u64 index = hash & mask;
+
+	for (u64 dist = 0; ht->entries[index].key; dist++) {
+		// key would have displaced this entry if it were in the table
+		if (HTProbeDist(ht, index) < dist) {
+			break;
 		}
-		++index;
-		if (index >= ht->capacity) {
-			index = 0;
+		if (ht->isAtomKeys ? key == ht->entries[index].key : 
+			ht->entries[index].hash == hash && 
+			!strcmp(key, ht->entries[index].key)) 
+		{
+			return index;
 		}
+		index = (index + 1) & mask;
 	}
 
-	return 0;
+	return -1;
 }
 
-char* ba_HTSetNoExpand(struct ba_HashTable* ht, char* key, void* val) {
-	u64 hash = ba_Hash(key);
-	u64 index = (u64)(hash & (u64)(ht->capacity - 1));
+// Inserts an entry whose key isn't in the table, there must be an empty slot
+void HTInsertEntry(struct ba_HashTable* ht, struct ba_HTEntry entry) {
+	u64 mask = ht->capacity - 1;
+	u64 index = entry.hash & mask;
+	u64 dist = 0;
 
 	while (ht->entries[index].key) {
-		if (!strcmp(key, ht->entries[index].key)) {
-			ht->entries[index].val = val;
-			return ht->entries[index].key;
-		}
-
-		++index;
-		if (index >= ht->capacity) {
-			index = 0;
+		u64 currDist = HTProbeDist(ht, index);
+		if (currDist < dist) {
+			struct ba_HTEntry tmp = ht->entries[index];
+			ht->entries[index] = entry;
+			entry = tmp;
+			dist = currDist;
 		}
+		index = (index + 1) & mask;
+		++dist;
 	}
 
-	key = strdup(key);
-	if (!key) {
-		return 0;
+	ht->entries[index] = entry;
+	++ht->count;
+}
+
+void* ba_HTGet(struct ba_HashTable* ht, char* key) {
+	u64 index = HTFind(ht, key, HTKeyHash(ht, key));
+	return index == -1llu ? 0 : ht->entries[index].val;
+}
+
+char* ba_HTSetNoExpand(struct ba_HashTable* ht, char* key, void* val) {
+	u64 hash = HTKeyHash(ht, key);
+	u64 index = HTFind(ht, key, hash);
+
+	if (index != -1llu) {
+		ht->entries[index].val = val;
+		return ht->entries[index].key;
 	}
-	++(ht->count);
 
-	ht->entries[index].key = key;
-	ht->entries[index].val = val;
+	if (!ht->isAtomKeys) {
+		key = strdup(key);
+		if (!key) {
+			return 0;
+		}
+	}
+	HTInsertEntry(ht, (struct ba_HTEntry){ key, val, hash });
 
 	return key;
 }
@@ -78,17 +129,21 @@ bool ba_HTExpand(struct ba_HashTable* ht) {
 		return 0;
 	}
 	
-	u64 newCapacity = ht->capacity << 1;
-	
-	struct ba_HTEntry* newEntries = ba_CAlloc(newCapacity, sizeof(*newEntries));
+	struct ba_HTEntry* oldEntries = ht->entries;
+	u64 oldCapacity = ht->capacity;
+
+	ht->capacity <<= 1;
+	ht->entries = ba_CAlloc(ht->capacity, sizeof(*ht->entries));
+	ht->count = 0;
 	
-	for (u64 i = 0; i < ht->capacity; i++) {
-		ba_HTSetNoExpand(ht, ht->entries[i].key, ht->entries[i].val);
+	// Stored hashes mean keys don't have to be hashed again
+	for (u64 i = 0; i < oldCapacity; i++) {
+		if (oldEntries[i].key) {
+			HTInsertEntry(ht, oldEntries[i]);
+		}
 	}
 
-	free(ht->entries);
-	ht->entries = newEntries;
-	ht->capacity = newCapacity;
+	free(oldEntries);
 	return 1;
 }
 
@@ -97,7 +152,8 @@ char* ba_HTSet(struct ba_HashTable* ht, char* key, void* val) {
 		return 0;
 	}
 
-	if (ht->count >= (ht->capacity >> 1)) {
+	// Maximum load factor of 3/4
+	if (ht->count >= ht->capacity - (ht->capacity >> 2)) {
 		if (!ba_HTExpand(ht)) {
 			return 0;
 		}
@@ -107,3 +163,30 @@ char* ba_HTSet(struct ba_HashTable* ht, char* key, void* val) {
 	return key;
 }
 
+/* Removes key from the table, returning its value, or 0 if it wasn't in the 
+ * table */
+void* ba_HTDel(struct ba_HashTable* ht, char* key) {
+	u64 index = HTFind(ht, key, HTKeyHash(ht, key));
+	if (index == -1llu) {
+		return 0;
+	}
+
+	void* val = ht->entries[index].val;
+	if (!ht->isAtomKeys) {
+		free(ht->entries[index].key);
+	}
+	--ht->count;
+
+	// Shift the following entries of the probe sequence back by one, so that 
+	// no tombstones are needed
+	u64 mask = ht->capacity - 1;
+	u64 next = (index + 1) & mask;
+	while (ht->entries[next].key && HTProbeDist(ht, next)) {
+		ht->entries[index] = ht->entries[next];
+		index = next;
+		next = (next + 1) & mask;
+	}
+	ht->entries[index] = (struct ba_HTEntry){0};
+
+	return val;
+}
@@ -6,22 +6,31 @@
 #include "common.h"
 
 struct ba_HTEntry {
-	char* key;
+	char* key; // Null if the entry is empty
 	void* val;
+	u64 hash; // Full hash of key
 };
 
+/* Open addressing with robin hood linear probing: an entry being inserted 
+ * takes the place of any entry it passes that is closer to its home slot, 
+ * which keeps probe sequences short even at high load factors. */
 struct ba_HashTable {
 	struct ba_HTEntry* entries;
-	u64 capacity;
+	u64 capacity; // Always a power of 2
 	u64 count;
+	// Keys are atoms (see intern.h), compared by pointer and not copied
+	bool isAtomKeys;
 };
 
 u64 ba_Hash(char* str);
 struct ba_HashTable* ba_NewHashTable();
+struct ba_HashTable* ba_NewHashTableCap(u64 capacity);
+struct ba_HashTable* ba_NewAtomHashTable(u64 capacity);
 void ba_DelHashTable(struct ba_HashTable* ht);
 void* ba_HTGet(struct ba_HashTable* ht, char* key);
 char* ba_HTSetNoExpand(struct ba_HashTable* ht, char* key, void* val);
 bool ba_HTExpand(struct ba_HashTable* ht);
 char* ba_HTSet(struct ba_HashTable* ht, char* key, void* val);
+void* ba_HTDel(struct ba_HashTable* ht, char* key);
 
 #endif
@@ -1,17 +1,59 @@
 // See LICENSE for copyright/license information
 
 #include "im.h"
+#include "arena.h"
 
-struct ba_IM* ba_NewIM() {
-	struct ba_IM* im = ba_CAlloc(1, sizeof(*im));
-	return im;
+// IM is owned by the parsing arena
+struct ba_IMChunk* NewIMChunk() {
+	return ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(struct ba_IMChunk));
+}
+
+struct ba_IMBuf* ba_NewIMBuf() {
+	struct ba_IMBuf* buf = ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*buf));
+	buf->first = NewIMChunk();
+	buf->last = buf->first;
+	return buf;
 }
 
-struct ba_IM* ba_DelIM(struct ba_IM* im) {
-	struct ba_IM* next = im->next;
-	free(im->vals);
-	free(im);
-	return next;
+// Returns a new IM at the end of buf
+struct ba_IM* ba_IMBufAdd(struct ba_IMBuf* buf) {
+	if (buf->last->cnt >= BA_IM_CHUNK_SIZE) {
+		buf->last->next = NewIMChunk();
+		buf->last = buf->last->next;
+	}
+	return &buf->last->ims[buf->last->cnt++];
+}
+
+// Moves the IM of src to the end of buf, leaving src empty
+void ba_IMBufAppend(struct ba_IMBuf* buf, struct ba_IMBuf* src) {
+	buf->last->next = src->first;
+	buf->last = src->last;
+	src->first = NewIMChunk();
+	src->last = src->first;
+}
+
+// Moves the IM of src to the start of buf, leaving src empty
+void ba_IMBufPrepend(struct ba_IMBuf* buf, struct ba_IMBuf* src) {
+	src->last->next = buf->first;
+	buf->first = src->first;
+	src->first = NewIMChunk();
+	src->last = src->first;
+}
+
+/* Returns the IM after im (or the first IM in *chunkPtr if im is 0), 
+ * moving *chunkPtr on to the chunk it is in. Returns 0 at the end. */
+struct ba_IM* ba_IMNext(struct ba_IMChunk** chunkPtr, struct ba_IM* im) {
+	struct ba_IMChunk* chunk = *chunkPtr;
+	im = im ? im + 1 : chunk->ims;
+	while (im >= chunk->ims + chunk->cnt) {
+		chunk = chunk->next;
+		if (!chunk) {
+			return 0;
+		}
+		im = chunk->ims;
+	}
+	*chunkPtr = chunk;
+	return im;
 }
 
 u64 ba_AdjRegSize(u64 reg, u64 size) {
@@ -44,6 +86,7 @@ char* ba_IMItemToStr(u64 val) {
 		case BA_IM_PUSH:         return "PUSH ";
 		case BA_IM_POP:          return "POP ";
 		case BA_IM_LEA:          return "LEA ";
+		case BA_IM_REGHINT:      return "REGHINT ";
 		case BA_IM_GOTO:         return "GOTO ";
 		case BA_IM_LABELJMP:     return "LABELJMP ";
 		case BA_IM_LABELJZ:      return "LABELJZ ";
@@ -70,6 +113,16 @@ char* ba_IMItemToStr(u64 val) {
 		case BA_IM_SETLE:        return "SETLE ";
 		case BA_IM_SETG:         return "SETG ";
 		case BA_IM_SETGE:        return "SETGE ";
+		case BA_IM_CMOVZ:        return "CMOVZ ";
+		case BA_IM_CMOVNZ:       return "CMOVNZ ";
+		case BA_IM_CMOVB:        return "CMOVB ";
+		case BA_IM_CMOVBE:       return "CMOVBE ";
+		case BA_IM_CMOVA:        return "CMOVA ";
+		case BA_IM_CMOVAE:       return "CMOVAE ";
+		case BA_IM_CMOVL:        return "CMOVL ";
+		case BA_IM_CMOVLE:       return "CMOVLE ";
+		case BA_IM_CMOVG:        return "CMOVG ";
+		case BA_IM_CMOVGE:       return "CMOVGE ";
 		case BA_IM_INC:          return "INC ";
 		case BA_IM_DEC:          return "DEC ";
 		case BA_IM_NOT:          return "NOT ";
@@ -49,6 +49,8 @@ enum {
 	BA_IM_PUSH         = 0x43,
 	BA_IM_POP          = 0x44,
 	BA_IM_LEA          = 0x45,
+	// Replaced or removed by the register allocator (regalloc.c)
+	BA_IM_REGHINT      = 0x46,
 	
 	BA_IM_GOTO         = 0x50,
 	BA_IM_LABELJMP     = 0x51,
@@ -78,6 +80,17 @@ enum {
 	BA_IM_SETG         = 0x6c,
 	BA_IM_SETGE        = 0x6d,
 
+	BA_IM_CMOVZ        = 0x70,
+	BA_IM_CMOVNZ       = 0x71,
+	BA_IM_CMOVB        = 0x72,
+	BA_IM_CMOVBE       = 0x73,
+	BA_IM_CMOVA        = 0x74,
+	BA_IM_CMOVAE       = 0x75,
+	BA_IM_CMOVL        = 0x76,
+	BA_IM_CMOVLE       = 0x77,
+	BA_IM_CMOVG        = 0x78,
+	BA_IM_CMOVGE       = 0x79,
+
 	// Registers must remain in order, otherwise binary generation messes up
 	// i.e. the last nibble of each value must stay the same as originally, 
 	// while the bits before those must be the same for each register
@@ -119,21 +132,50 @@ enum {
 	BA_IM_R15B         = 0x11f,
 };
 
+// Opcode and up to 5 operands
+#define BA_IM_MAXVALS 6
+// Number of IM in each chunk of a ba_IMBuf
+#define BA_IM_CHUNK_SIZE 0x80
+
 struct ba_IM {
-	u64* vals;
 	u64 count;
-	struct ba_IM* next;
+	u64 vals[BA_IM_MAXVALS];
+};
+
+struct ba_IMChunk {
+	u64 cnt;
+	struct ba_IMChunk* next;
+	struct ba_IM ims[BA_IM_CHUNK_SIZE];
 };
 
+/* IM for the main program or a function, in a list of chunks, so that 
+ * buffers can be joined without copying any IM */
+struct ba_IMBuf {
+	struct ba_IMChunk* first;
+	struct ba_IMChunk* last;
+};
+
+// Addresses while encoding don't include jumps or calls (ba_IMBranch)
 struct ba_IMLabel {
 	u64 addr;
-	struct ba_DynArr64* jmpOfsts;
-	struct ba_DynArr8* jmpOfstSizes;
+	u64 branchCnt; // Number of branches before the label
 	bool isFound;
 };
 
-struct ba_IM* ba_NewIM();
-struct ba_IM* ba_DelIM(struct ba_IM* im);
+struct ba_IMBranch {
+	u64 pos; // Where it goes in the code without branches
+	u64 labelID;
+	bool isJcc;
+	u8 size; // 2 for short, 5 (or 6 for Jcc) for near
+	u8 opCodeShort;
+	u8 opCodeNear;
+};
+
+struct ba_IMBuf* ba_NewIMBuf();
+struct ba_IM* ba_IMBufAdd(struct ba_IMBuf* buf);
+void ba_IMBufAppend(struct ba_IMBuf* buf, struct ba_IMBuf* src);
+void ba_IMBufPrepend(struct ba_IMBuf* buf, struct ba_IMBuf* src);
+struct ba_IM* ba_IMNext(struct ba_IMChunk** chunkPtr, struct ba_IM* im);
 u64 ba_AdjRegSize(u64 reg, u64 size);
 char* ba_IMItemToStr(u64 val);
 char* ba_IMToStr(struct ba_IM* im);
@@ -0,0 +1,75 @@
+// See LICENSE for copyright/license information
+
+#include "intern.h"
+#include "hashtable.h"
+#include "arena.h"
+
+// Open addressing set of atoms
+char** internAtoms = 0;
+u64 internCap = 0;
+u64 internCnt = 0;
+
+void InternExpand() {
+	char** oldAtoms = internAtoms;
+	u64 oldCap = internCap;
+
+	internCap = internCap ? internCap << 1 : BA_INTERN_CAPACITY;
+	internAtoms = ba_CAlloc(internCap, sizeof(*internAtoms));
+
+	for (u64 i = 0; i < oldCap; i++) {
+		if (oldAtoms[i]) {
+			u64 index = ba_AtomHash(oldAtoms[i]) & (internCap - 1);
+			while (internAtoms[index]) {
+				index = (index + 1) & (internCap - 1);
+			}
+			internAtoms[index] = oldAtoms[i];
+		}
+	}
+	free(oldAtoms);
+}
+
+char* ba_Intern(char* str) {
+	return ba_InternLen(str, strlen(str));
+}
+
+// str[len] must be 0
+char* ba_InternLen(char* str, u64 len) {
+	if (internCnt >= (internCap >> 1)) {
+		InternExpand();
+	}
+
+	u64 hash = ba_Hash(str);
+	u64 index = hash & (internCap - 1);
+	while (internAtoms[index]) {
+		char* atom = internAtoms[index];
+		if (ba_AtomHash(atom) == hash && ba_AtomLen(atom) == len && 
+			!memcmp(atom, str, len)) 
+		{
+			return atom;
+		}
+		index = (index + 1) & (internCap - 1);
+	}
+
+	struct ba_AtomHeader* header = ba_ArenaAlloc(BA_ARENA_ATOM, 
+		sizeof(*header) + len + 1);
+	header->hash = hash;
+	header->len = len;
+	char* atom = (char*)(header + 1);
+	memcpy(atom, str, len);
+
+	internAtoms[index] = atom;
+	++internCnt;
+	return atom;
+}
+
+u64 ba_AtomHash(char* atom) {
+	return ((struct ba_AtomHeader*)atom - 1)->hash;
+}
+
+u64 ba_AtomLen(char* atom) {
+	return ((struct ba_AtomHeader*)atom - 1)->len;
+}
+
+struct ba_STBinding** ba_AtomBindings(char* atom) {
+	return &((struct ba_AtomHeader*)atom - 1)->bindings;
+}
@@ -0,0 +1,28 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__COMMON_INTERN_H
+#define BA__COMMON_INTERN_H
+
+#include "common.h"
+
+#define BA_INTERN_CAPACITY 4096
+
+struct ba_STBinding; // Forward declaration
+
+/* An atom is a char* to a string stored in the interner, so two atoms with 
+ * the same contents are always the same pointer. The header below is stored 
+ * directly before the string. Atoms live until the compiler exits. */
+struct ba_AtomHeader {
+	u64 hash; // ba_Hash of the string
+	u64 len;
+	// Declarations of the name in open scopes, innermost first
+	struct ba_STBinding* bindings;
+};
+
+char* ba_Intern(char* str);
+char* ba_InternLen(char* str, u64 len);
+u64 ba_AtomHash(char* atom);
+u64 ba_AtomLen(char* atom);
+struct ba_STBinding** ba_AtomBindings(char* atom);
+
+#endif
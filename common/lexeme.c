@@ -3,20 +3,66 @@
 #include "lexeme.h"
 #include "exitmsg.h"
 
-struct ba_Lexeme* ba_NewLexeme() {
-	struct ba_Lexeme* lex = ba_CAlloc(1, sizeof(struct ba_Lexeme));
-	return lex;
+// initCap must be a power of 2
+struct ba_TkBuf* ba_NewTkBuf(u64 initCap) {
+	struct ba_TkBuf* tks = ba_CAlloc(1, sizeof(*tks));
+	tks->cap = initCap;
+	tks->types = ba_CAlloc(initCap, sizeof(*tks->types));
+	tks->lineCols = ba_CAlloc(initCap, sizeof(*tks->lineCols));
+	tks->vals = ba_CAlloc(initCap, sizeof(*tks->vals));
+	tks->valLens = ba_CAlloc(initCap, sizeof(*tks->valLens));
+	return tks;
 }
 
-struct ba_Lexeme* ba_DelLexeme(struct ba_Lexeme* lex) {
-	struct ba_Lexeme* next = lex->next;
-	if (lex->type == BA_TK_LITSTR || lex->type == BA_TK_LITINT || 
-		lex->type == BA_TK_IDENTIFIER)
+void ba_DelTkBuf(struct ba_TkBuf* tks) {
+	free(tks->types);
+	free(tks->lineCols);
+	free(tks->vals);
+	free(tks->valLens);
+	free(tks);
+}
+
+/* Returns the index of the new lexeme. The buffer grows if none of the 
+ * lexemes in it have been consumed. */
+u64 ba_TkBufPush(struct ba_TkBuf* tks, struct ba_Lexeme* lex) {
+	if (tks->cnt - tks->base >= tks->cap) {
+		struct ba_TkBuf old = *tks;
+		tks->cap <<= 1;
+		tks->types = ba_MAlloc(tks->cap * sizeof(*tks->types));
+		tks->lineCols = ba_MAlloc(tks->cap * sizeof(*tks->lineCols));
+		tks->vals = ba_MAlloc(tks->cap * sizeof(*tks->vals));
+		tks->valLens = ba_MAlloc(tks->cap * sizeof(*tks->valLens));
+		for (u64 i = tks->base; i < tks->cnt; i++) {
+			u64 oldSlot = BA_TK_SLOT(&old, i);
+			u64 slot = BA_TK_SLOT(tks, i);
+			tks->types[slot] = old.types[oldSlot];
+			tks->lineCols[slot] = old.lineCols[oldSlot];
+			tks->vals[slot] = old.vals[oldSlot];
+			tks->valLens[slot] = old.valLens[oldSlot];
+		}
+		free(old.types);
+		free(old.lineCols);
+		free(old.vals);
+		free(old.valLens);
+	}
+	u64 idx = tks->cnt++;
+	u64 slot = BA_TK_SLOT(tks, idx);
+	tks->types[slot] = lex->type;
+	tks->lineCols[slot] = (lex->line << 32) | (u32)lex->col;
+	tks->vals[slot] = lex->val;
+	tks->valLens[slot] = lex->valLen;
+	return idx;
+}
+
+// Index of the lexeme after the one at idx in the same stream
+u64 ba_TkNext(struct ba_TkBuf* tks, u64 idx) {
+	u64 slot = BA_TK_SLOT(tks, idx);
+	if (tks->types[slot] == BA_TK_FSTRING || 
+		tks->types[slot] == BA_TK_FILECHANGE) 
 	{
-		free(lex->val);
+		return tks->valLens[slot];
 	}
-	free(lex);
-	return next;
+	return idx + 1;
 }
 
 bool ba_IsLexemeCompoundAssign(u64 lexType) {
@@ -118,6 +164,8 @@ char* ba_GetLexemeStr(u64 lex) {
 		case BA_TK_KW_BOOL:     return "keyword 'bool'";
 		case BA_TK_KW_ASSERT:   return "keyword 'assert'";
 		case BA_TK_KW_STRUCT:   return "keyword 'struct'";
+		case BA_TK_KW_INLINE:   return "keyword 'inline'";
+		case BA_TK_KW_CONST:    return "keyword 'const'";
 	}
 	return 0;
 }
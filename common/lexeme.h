@@ -57,6 +57,8 @@ enum {
 	BA_TK_KW_BOOL     = 0x310,
 	BA_TK_KW_ASSERT   = 0x311,
 	BA_TK_KW_STRUCT   = 0x312,
+	BA_TK_KW_INLINE   = 0x313,
+	BA_TK_KW_CONST    = 0x314,
 
 	// Used to change ctr->currPath
 	BA_TK_FILECHANGE = 0xfff,
@@ -68,17 +70,38 @@ enum {
 	BA_TK_IMSTATIC   = 0x1002, // size varies
 };
 
+// Used by the lexer to build a lexeme before it is added to a ba_TkBuf
 struct ba_Lexeme {
 	u64 type;
 	u64 line;
 	u64 col;
 	char* val;
 	u64 valLen;
-	struct ba_Lexeme* next;
 };
 
-struct ba_Lexeme* ba_NewLexeme();
-struct ba_Lexeme* ba_DelLexeme(struct ba_Lexeme* lex);
+/* Lexemes, stored as parallel arrays in a ring buffer and referred to by 
+ * their index in the whole stream of lexemes. Each file and each formatted 
+ * string expression is a range ending in BA_TK_EOF, or BA_TK_FILECHANGE for 
+ * included files. BA_TK_FILECHANGE and BA_TK_FSTRING (which is followed by 
+ * the ranges of its expressions) lexemes store the index that the stream 
+ * continues from in valLens. */
+struct ba_TkBuf {
+	u64 cnt; // Lexemes lexed so far
+	u64 base; // Lexemes before this index have been consumed
+	u64 cap; // Always a power of 2
+	u16* types;
+	u64* lineCols; // Line in the upper 32 bits, column in the lower 32
+	char** vals;
+	u32* valLens;
+};
+
+// Position in the arrays of the lexeme at idx
+#define BA_TK_SLOT(tks, idx) ((idx) & ((tks)->cap - 1))
+
+struct ba_TkBuf* ba_NewTkBuf(u64 initCap);
+void ba_DelTkBuf(struct ba_TkBuf* tks);
+u64 ba_TkBufPush(struct ba_TkBuf* tks, struct ba_Lexeme* lex);
+u64 ba_TkNext(struct ba_TkBuf* tks, u64 idx);
 bool ba_IsLexemeCompoundAssign(u64 lexType);
 bool ba_IsLexemeCompare(u64 lexType);
 bool ba_IsLexemeLiteral(u64 lexType);
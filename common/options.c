@@ -5,6 +5,8 @@
 u64 pageSize = 0;
 char* includePath = 0;
 bool hasAssertions = 1;
+u8 optLevel = 0;
+bool isOptStats = 0;
 
 void ba_SetPageSize(u64 sz) {
 	pageSize = sz;
@@ -32,3 +34,19 @@ bool ba_HasAssertions() {
 	return hasAssertions;
 }
 
+
+void ba_SetOptLevel(u8 level) {
+	optLevel = level > BA_OPT_MAXLEVEL ? BA_OPT_MAXLEVEL : level;
+}
+
+u8 ba_GetOptLevel() {
+	return optLevel;
+}
+
+void ba_SetOptStats(bool is) {
+	isOptStats = is;
+}
+
+bool ba_IsOptStats() {
+	return isOptStats;
+}
@@ -11,5 +11,19 @@ void ba_SetIncludePath(char* path, bool isOverrideDefaults);
 char* ba_GetIncludePath();
 void ba_SetAssertions(bool has);
 bool ba_HasAssertions();
+// Highest optimization level; -O is the same as -O2
+#define BA_OPT_MAXLEVEL 2
+// Lowest optimization level that variables are kept in registers at
+#define BA_OPT_REGVARLEVEL 2
+// Lowest optimization level that funcs calling themselves in tail position
+// reuse their stack frame at (see tailcall.c)
+#define BA_OPT_TAILCALLLEVEL 1
+// Lowest optimization level that small funcs are inlined at (see inline.c)
+#define BA_OPT_INLINELEVEL 2
+
+void ba_SetOptLevel(u8 level);
+u8 ba_GetOptLevel();
+void ba_SetOptStats(bool is);
+bool ba_IsOptStats();
 
 #endif
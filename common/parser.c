@@ -10,7 +10,8 @@
 void ba_PTkStkPush(struct ba_Stk* stk, void* val, struct ba_Type type, 
 	u64 lexemeType, bool isLValue, bool isConst)
 {
-	struct ba_PTkStkItem* stkItem = ba_MAlloc(sizeof(*stkItem));
+	struct ba_PTkStkItem* stkItem = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*stkItem));
 	stkItem->val = val;
 	stkItem->typeInfo = type;
 	stkItem->lexemeType = lexemeType;
@@ -22,7 +23,8 @@ void ba_PTkStkPush(struct ba_Stk* stk, void* val, struct ba_Type type,
 void ba_POpStkPush(struct ba_Stk* stk, u64 line, u64 col, 
 	u64 lexemeType, u8 syntax)
 {
-	struct ba_POpStkItem* stkItem = ba_MAlloc(sizeof(*stkItem));
+	struct ba_POpStkItem* stkItem = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*stkItem));
 	stkItem->line = line;
 	stkItem->col = col;
 	stkItem->lexemeType = lexemeType;
@@ -30,10 +32,14 @@ void ba_POpStkPush(struct ba_Stk* stk, u64 line, u64 col,
 	ba_StkPush(stk, (void*)stkItem);
 }
 
-void ba_PBreakStkPush(struct ba_Stk* stk, u64 id, struct ba_SymTable* scope) {
-	struct ba_PLabel* stkItem = ba_MAlloc(sizeof(*stkItem));
+void ba_PBreakStkPush(struct ba_Stk* stk, u64 id, struct ba_SymTable* scope, 
+	u64 frameDataSize) 
+{
+	struct ba_PLabel* stkItem = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*stkItem));
 	stkItem->id = id;
 	stkItem->scope = scope;
+	stkItem->frameDataSize = frameDataSize;
 	ba_StkPush(stk, (void*)stkItem);
 }
 
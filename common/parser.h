@@ -25,6 +25,17 @@ struct ba_POpStkItem {
 struct ba_PLabel {
 	u64 id;
 	struct ba_SymTable* scope;
+	u64 frameDataSize; // See ba_STFrameDataSize, at the label
+};
+
+// A goto whose label is found after parsing (BA_IM_GOTO)
+struct ba_PGoto {
+	char* lblName;
+	struct ba_SymTable* scope;
+	u64 frameDataSize;
+	u64 line;
+	u64 col;
+	char* path;
 };
 
 enum {
@@ -37,6 +48,7 @@ void ba_PTkStkPush(struct ba_Stk* stk, void* val, struct ba_Type type,
 	u64 lexemeType, bool isLValue, bool isConst);
 void ba_POpStkPush(struct ba_Stk* stk, u64 line, u64 col, 
 	u64 lexemeType, u8 syntax);
-void ba_PBreakStkPush(struct ba_Stk* stk, u64 id, struct ba_SymTable* scope);
+void ba_PBreakStkPush(struct ba_Stk* stk, u64 id, struct ba_SymTable* scope, 
+	u64 frameDataSize);
 
 #endif
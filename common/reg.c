@@ -2,8 +2,8 @@
 
 #include "reg.h"
 #include "im.h"
-
-// TODO: assign some registers to variables rather than intermediate values
+#include "options.h"
+#include "func.h"
 
 u64 ba_IMToCtrReg(u64 reg) {
 	switch (reg) {
@@ -47,8 +47,10 @@ u64 ba_CtrRegToIM(u64 reg) {
 
 u64 ba_NextIMRegister(struct ba_Ctr* ctr) {
 	u64 ctrReg = BA_CTRREG_RAX;
+	u64 unavailable = ctr->usedRegisters | 
+		(ba_GetOptLevel() >= BA_OPT_REGVARLEVEL ? BA_CTRREG_VARS : 0);
 	while (ctrReg <= BA_CTRREG_R15) {
-		if (!(ctr->usedRegisters & ctrReg)) {
+		if (!(unavailable & ctrReg)) {
 			ctr->usedRegisters |= ctrReg;
 			return ba_CtrRegToIM(ctrReg);
 		}
@@ -59,11 +61,12 @@ u64 ba_NextIMRegister(struct ba_Ctr* ctr) {
 	return 0;
 }
 
-// Note: does not modify ctr->funcFrameStk, ctr->usedRegisters
-void ba_UsedRegPreserve(struct ba_Ctr* ctr) {
+/* Pushes the registers (BA_CTRREG_*) in regs
+ * Note: does not modify ctr->funcFrameStk, ctr->usedRegisters */
+void ba_UsedRegPreserve(struct ba_Ctr* ctr, u64 regs) {
 	u64 ctrReg = BA_CTRREG_RAX;
 	while (ctrReg <= BA_CTRREG_R15) {
-		if (ctr->usedRegisters & ctrReg) {
+		if (regs & ctrReg) {
 			ba_AddIM(ctr, 2, BA_IM_PUSH, ba_CtrRegToIM(ctrReg));
 			ctr->imStackSize += 8;
 		}
@@ -71,11 +74,13 @@ void ba_UsedRegPreserve(struct ba_Ctr* ctr) {
 	}
 }
 
-// Note: does not modify ctr->funcFrameStk, ctr->usedRegisters
-void ba_UsedRegRestore(struct ba_Ctr* ctr, u64 until) {
+/* Pops the registers in regs pushed by ba_UsedRegPreserve, except for the
+ * first until of them
+ * Note: does not modify ctr->funcFrameStk, ctr->usedRegisters */
+void ba_UsedRegRestore(struct ba_Ctr* ctr, u64 regs, u64 until) {
 	u64 ctrReg = BA_CTRREG_R15;
 	while (ctrReg >= (BA_CTRREG_RAX << until)) {
-		if (ctr->usedRegisters & ctrReg) {
+		if (regs & ctrReg) {
 			ba_AddIM(ctr, 2, BA_IM_POP, ba_CtrRegToIM(ctrReg));
 			ctr->imStackSize -= 8;
 		}
@@ -83,3 +88,55 @@ void ba_UsedRegRestore(struct ba_Ctr* ctr, u64 until) {
 	}
 }
 
+/* Registers (BA_CTRREG_*) written by the IM in buf, not counting the ones
+ * written by funcs that it calls */
+u64 ba_IMClobberRegs(struct ba_IMBuf* buf) {
+	u64 regs = 0;
+	struct ba_IMChunk* chunk = buf->first;
+	for (struct ba_IM* im = ba_IMNext(&chunk, 0); im; 
+		im = ba_IMNext(&chunk, im)) 
+	{
+		u64 op = im->vals[0];
+		if (op == BA_IM_SYSCALL) {
+			regs |= BA_CTRREG_RAX | BA_CTRREG_RCX | BA_CTRREG_R11;
+			continue;
+		}
+		if (op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV || 
+			op == BA_IM_CQO || (op == BA_IM_IMUL && im->count == 2)) 
+		{
+			regs |= BA_CTRREG_RAX | BA_CTRREG_RDX;
+			continue;
+		}
+		// Instructions that write to their first operand
+		bool isWrite = (op >= BA_IM_MOV && op <= BA_IM_IMUL && 
+			op != BA_IM_CMP && op != BA_IM_TEST && op != BA_IM_MUL) || 
+			op == BA_IM_POP || op == BA_IM_LEA || op == BA_IM_MOVZX || 
+			(op >= BA_IM_SETS && op <= BA_IM_SETGE) || 
+			(op >= BA_IM_CMOVZ && op <= BA_IM_CMOVGE);
+		if (!isWrite || im->count < 2) {
+			continue;
+		}
+		u64 reg = im->vals[1];
+		(reg >= BA_IM_AL && reg <= BA_IM_R15B) && 
+			(reg = reg - BA_IM_AL + BA_IM_RAX);
+		regs |= ba_IMToCtrReg(reg);
+	}
+	return regs;
+}
+
+// Adds regs to the registers written by the func being parsed, if any
+void ba_AddCallClobbers(struct ba_Ctr* ctr, u64 regs) {
+	struct ba_Func* func = ctr->currScope->func;
+	func && (func->clobberRegs |= regs);
+}
+
+/* Tells the register allocator about a variable (or a func's prologue or 
+ * epilogue). Uses in loops are weighted as being more frequent. */
+void ba_AddRegHint(struct ba_Ctr* ctr, u64 kind, void* val) {
+	if (ba_GetOptLevel() < BA_OPT_REGVARLEVEL) {
+		return;
+	}
+	u64 depth = ctr->pBreakStk->count;
+	ba_AddIM(ctr, 4, BA_IM_REGHINT, kind, (u64)val, 
+		1llu << (depth < 10 ? 3 * depth : 30));
+}
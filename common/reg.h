@@ -24,10 +24,32 @@ enum {
 	BA_CTRREG_R15 = 1 << 13
 };
 
+#define BA_CTRREG_ALL ((BA_CTRREG_R15 << 1) - 1)
+
+/* When optimizing, these are kept for variables (see regalloc.c) and are 
+ * not used for intermediate values. Funcs save the ones they use. */
+#define BA_CTRREG_VARS (BA_CTRREG_RBX | BA_CTRREG_R12 | BA_CTRREG_R13 | \
+	BA_CTRREG_R14 | BA_CTRREG_R15)
+#define BA_REGVAR_CNT 5
+// Space for saving them, between the return location and the dynamic link
+#define BA_REGVAR_SAVESIZE (8 * BA_REGVAR_CNT)
+
+// Kinds of REGHINT IM: { REGHINT, kind, val, weight }
+enum {
+	BA_REGHINT_DECL = 1, // val: var, initialized by the PUSH after the hint
+	BA_REGHINT_PARAM,    // val: func param
+	BA_REGHINT_ACCESS,   // val: var, loaded or stored by the IM after the hint
+	BA_REGHINT_SAVE,     // Save registers used for vars in the func
+	BA_REGHINT_RESTORE,  // Restore them
+};
+
 u64 ba_IMToCtrReg(u64 reg);
 u64 ba_CtrRegToIM(u64 reg);
 u64 ba_NextIMRegister(struct ba_Ctr* ctr);
-void ba_UsedRegPreserve(struct ba_Ctr* ctr);
-void ba_UsedRegRestore(struct ba_Ctr* ctr, u64 until);
+void ba_UsedRegPreserve(struct ba_Ctr* ctr, u64 regs);
+void ba_UsedRegRestore(struct ba_Ctr* ctr, u64 regs, u64 until);
+u64 ba_IMClobberRegs(struct ba_IMBuf* buf);
+void ba_AddCallClobbers(struct ba_Ctr* ctr, u64 regs);
+void ba_AddRegHint(struct ba_Ctr* ctr, u64 kind, void* val);
 
 #endif
@@ -5,8 +5,9 @@
 #include "func.h"
 
 struct ba_SymTable* ba_NewSymTable() {
-	struct ba_SymTable* st = ba_MAlloc(sizeof(*st));
-	st->ht = ba_NewHashTable();
+	struct ba_SymTable* st = ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*st));
+	st->ht = 0;
+	st->symCnt = 0;
 	st->parent = 0;
 	st->frameScope = 0;
 	st->children = 0;
@@ -15,13 +16,14 @@ struct ba_SymTable* ba_NewSymTable() {
 	st->depth = 0;
 	st->dataSize = 0;
 	st->func = 0;
-	st->hasFramePtrLink = 0;
+	st->isOpen = 0;
 	return st;
 }
 
 void ba_DelSymTable(struct ba_SymTable* st) {
-	ba_DelHashTable(st->ht);
-	free(st);
+	if (st->ht) {
+		ba_DelHashTable(st->ht);
+	}
 }
 
 struct ba_SymTable* ba_SymTableAddChild(struct ba_SymTable* parent) {
@@ -31,10 +33,10 @@ struct ba_SymTable* ba_SymTableAddChild(struct ba_SymTable* parent) {
 	child->func = parent->func;
 	child->frameScope = parent->frameScope;
 	if (!parent->childCap) {
-		parent->childCap = 0x20;
-		parent->children = ba_MAlloc(0x20 * sizeof(*parent->children));
+		parent->childCap = 4;
+		parent->children = ba_MAlloc(4 * sizeof(*parent->children));
 	}
-	else if (parent->childCap >= parent->childCnt) {
+	else if (parent->childCnt >= parent->childCap) {
 		parent->childCap <<= 1;
 		parent->children = ba_Realloc(parent->children, 
 			parent->childCap * sizeof(*parent->children));
@@ -43,12 +45,120 @@ struct ba_SymTable* ba_SymTableAddChild(struct ba_SymTable* parent) {
 	return child;
 }
 
+struct ba_STVal* ba_STGet(struct ba_SymTable* st, char* key) {
+	if (st->ht) {
+		return ba_HTGet(st->ht, key);
+	}
+	for (u64 i = 0; i < st->symCnt; i++) {
+		if (key == st->inlEntries[i].key) {
+			return st->inlEntries[i].val;
+		}
+	}
+	return 0;
+}
+
+void STBind(struct ba_SymTable* st, char* key, struct ba_STVal* val) {
+	struct ba_STBinding** bindingPtr = ba_AtomBindings(key);
+	for (struct ba_STBinding* binding = *bindingPtr; binding; 
+		binding = binding->next) 
+	{
+		if (binding->scope == st) {
+			binding->val = val;
+			return;
+		}
+	}
+	struct ba_STBinding* binding = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*binding));
+	*binding = (struct ba_STBinding){ val, st, *bindingPtr };
+	*bindingPtr = binding;
+}
+
+void ba_STSet(struct ba_SymTable* st, char* key, struct ba_STVal* val) {
+	STBind(st, key, val);
+	if (!st->ht) {
+		for (u64 i = 0; i < st->symCnt; i++) {
+			if (key == st->inlEntries[i].key) {
+				st->inlEntries[i].val = val;
+				return;
+			}
+		}
+		if (st->symCnt < BA_SYMTABLE_INLINE_CNT) {
+			st->inlEntries[st->symCnt++] = 
+				(struct ba_HTEntry){ key, val, ba_AtomHash(key) };
+			return;
+		}
+
+		// Scope has outgrown its inline storage
+		st->ht = ba_NewAtomHashTable(BA_SYMTABLE_HT_CAPACITY);
+		for (u64 i = 0; i < st->symCnt; i++) {
+			ba_HTSet(st->ht, st->inlEntries[i].key, st->inlEntries[i].val);
+		}
+	}
+	ba_HTSet(st->ht, key, val);
+	st->symCnt = st->ht->count;
+}
+
+/* Returns the array of entries to iterate over to visit every symbol of the 
+ * scope, and sets *cntPtr to its length. Entries in a hash table may be empty 
+ * (key is null). Its length is proportional to the number of symbols. */
+struct ba_HTEntry* ba_STEntries(struct ba_SymTable* st, u64* cntPtr) {
+	if (st->ht) {
+		*cntPtr = st->ht->capacity;
+		return st->ht->entries;
+	}
+	*cntPtr = st->symCnt;
+	return st->inlEntries;
+}
+
+// Makes scope, a child of the current scope, the current scope
+void ba_STEnter(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
+	scope->isOpen = 1;
+	ctr->currScope = scope;
+}
+
+// Makes the parent of the current scope the current scope
+void ba_STLeave(struct ba_Ctr* ctr) {
+	struct ba_SymTable* scope = ctr->currScope;
+
+	u64 entryCnt = 0;
+	struct ba_HTEntry* entries = ba_STEntries(scope, &entryCnt);
+	for (u64 i = 0; i < entryCnt; i++) {
+		if (!entries[i].key) {
+			continue;
+		}
+		struct ba_STBinding** bindingPtr = ba_AtomBindings(entries[i].key);
+		while (*bindingPtr && (*bindingPtr)->scope != scope) {
+			bindingPtr = &(*bindingPtr)->next;
+		}
+		*bindingPtr && (*bindingPtr = (*bindingPtr)->next);
+	}
+
+	scope->isOpen = 0;
+	ctr->currScope = scope->parent;
+}
+
 // stFoundInPtr must be a real pointer otherwise null pointer dereferencing
 struct ba_STVal* ba_STParentFind(struct ba_SymTable* st, 
 	struct ba_SymTable** stFoundInPtr, char* key)
 {
+	/* Open scopes form a chain, so a binding in an open scope no deeper than 
+	 * st is in st or one of its ancestors. Shadowing is an error, so there is 
+	 * at most one such binding, and it is nearly always the first. */
+	if (st->isOpen) {
+		struct ba_STBinding* binding = *ba_AtomBindings(key);
+		while (binding && 
+			!(binding->scope->isOpen && binding->scope->depth <= st->depth))
+		{
+			binding = binding->next;
+		}
+		if (binding && stFoundInPtr) {
+			*stFoundInPtr = binding->scope;
+		}
+		return binding ? binding->val : 0;
+	}
+
 	while (st) {
-		struct ba_STVal* get = ba_HTGet(st->ht, key);
+		struct ba_STVal* get = ba_STGet(st, key);
 		if (get) {
 			if (stFoundInPtr) {
 				*stFoundInPtr = st;
@@ -60,51 +170,50 @@ struct ba_STVal* ba_STParentFind(struct ba_SymTable* st,
 	return 0;
 }
 
+/* Size of the data in scope's frame, up to and including that of scope. The 
+ * variables of a func (or of the program) all go in one frame, so this is 
+ * also how far RSP is below RBP between statements. */
+u64 ba_STFrameDataSize(struct ba_SymTable* scope) {
+	u64 size = scope->dataSize;
+	while (scope != scope->frameScope) {
+		scope = scope->parent;
+		size += scope->dataSize;
+	}
+	return size;
+}
+
+// Moves RSP from having fromSize bytes of frame data to having toSize bytes
+void ba_STAdjStack(struct ba_Ctr* ctr, u64 fromSize, u64 toSize) {
+	if (fromSize > toSize) {
+		ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, fromSize - toSize);
+	}
+	else if (fromSize < toSize) {
+		ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, toSize - fromSize);
+	}
+}
+
 i64 ba_CalcVarOffset(struct ba_Ctr* ctr, struct ba_STVal* id, bool* isPushRbp) {
 	*isPushRbp = 0;
-	i64 address = -id->address;
-	struct ba_SymTable* lastScope = 0;
 	struct ba_SymTable* scope = ctr->currScope;
-	i64 linksPassed = 0;
 
-	while (scope && scope != id->scope) {
-		lastScope = scope;
-		scope = scope->parent;
-		if (!scope) {
+	while (scope != id->scope) {
+		if (!scope->parent) {
 			fprintf(stderr, "Error: identifier used in scope that is not a "
 				"descendant of its own scope\n");
 			exit(1);
 		}
-
-		if (!lastScope->func || lastScope != lastScope->func->childScope) {
-			if (!linksPassed && lastScope->hasFramePtrLink) {
-				++linksPassed;
-			}
-			if (linksPassed) {
-				address += scope->dataSize + 8 * lastScope->hasFramePtrLink;
-			}
-		}
-		else { // outermost scope of a func
+		// Leaving a func, so follow its static link
+		if (scope == scope->frameScope) {
+			id->isMemOnly = 1;
 			if (!*isPushRbp) {
 				*isPushRbp = 1;
 				ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
 			}
-			++linksPassed;
-			while (linksPassed) {
-				ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RBP, BA_IM_ADR, BA_IM_RBP);
-				--linksPassed;
-			}
-			address = -id->address;
-		}
-	}
-
-	if (!linksPassed) {
-		while (scope && !scope->hasFramePtrLink) {
-			scope = scope->parent;
-			address -= scope ? scope->dataSize : 0;
+			ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RBP, BA_IM_ADR, BA_IM_RBP);
 		}
+		scope = scope->parent;
 	}
 
-	return address;
+	// The data of the scopes around the var's scope comes before it
+	return -id->address - (ba_STFrameDataSize(scope) - scope->dataSize);
 }
-
@@ -6,12 +6,22 @@
 #include "types.h"
 #include "hashtable.h"
 #include "ctr.h"
+#include "intern.h"
+
+// Symbols of a scope are stored inline until there are more than this many
+#define BA_SYMTABLE_INLINE_CNT 8
+// Initial capacity of the hash table a scope's symbols are moved into
+#define BA_SYMTABLE_HT_CAPACITY 32
 
 struct ba_Func; // forward declaration
 
 struct ba_SymTable {
+	// Null until the scope has more than BA_SYMTABLE_INLINE_CNT symbols
 	struct ba_HashTable* ht;
+	struct ba_HTEntry inlEntries[BA_SYMTABLE_INLINE_CNT];
+	u64 symCnt;
 	struct ba_SymTable* parent;
+	// Outermost scope of the func (or the program) that this scope is in
 	struct ba_SymTable* frameScope;
 	struct ba_SymTable** children;
 	u64 childCnt;
@@ -19,7 +29,17 @@ struct ba_SymTable {
 	u64 depth;
 	u64 dataSize;
 	struct ba_Func* func;
-	bool hasFramePtrLink;
+	// Is the current scope or one of its ancestors
+	bool isOpen;
+};
+
+/* Declaration of a name in a scope. Each atom keeps a list of the bindings it 
+ * has, so that names can be resolved without searching every enclosing scope. 
+ * A scope's bindings are removed when it is left. */
+struct ba_STBinding {
+	struct ba_STVal* val;
+	struct ba_SymTable* scope;
+	struct ba_STBinding* next;
 };
 
 struct ba_STVal {
@@ -27,14 +47,27 @@ struct ba_STVal {
 	struct ba_SymTable* scope;
 	i64 address;
 	bool isInited;
-//	void* initVal; // A relic of ancient code. TODO: use this for consts
+	// Must stay in memory, e.g. if used by a nested func (see regalloc.c)
+	bool isMemOnly;
+	u64 reg; // Register the var is kept in, or 0
+	u64 regWeight; // How much the var is used, for choosing which to keep
+	bool isConst; // Defined with const, so it has no address
+	u64 constVal; // Value of a const, already converted to its type
 };
 
 struct ba_SymTable* ba_NewSymTable();
 void ba_DelSymTable(struct ba_SymTable* st);
 struct ba_SymTable* ba_SymTableAddChild(struct ba_SymTable* parent);
+void ba_STEnter(struct ba_Ctr* ctr, struct ba_SymTable* scope);
+void ba_STLeave(struct ba_Ctr* ctr);
+// Symbol table keys are atoms (see intern.h)
+struct ba_STVal* ba_STGet(struct ba_SymTable* st, char* key);
+void ba_STSet(struct ba_SymTable* st, char* key, struct ba_STVal* val);
+struct ba_HTEntry* ba_STEntries(struct ba_SymTable* st, u64* cntPtr);
 struct ba_STVal* ba_STParentFind(struct ba_SymTable* st, 
 	struct ba_SymTable** stFoundInPtr, char* key);
+u64 ba_STFrameDataSize(struct ba_SymTable* scope);
+void ba_STAdjStack(struct ba_Ctr* ctr, u64 fromSize, u64 toSize);
 i64 ba_CalcVarOffset(struct ba_Ctr* ctr, struct ba_STVal* id, bool* isPushRbp);
 
 #endif
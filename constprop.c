@@ -0,0 +1,750 @@
+// See LICENSE for copyright/license information
+
+#include "constprop.h"
+#include "dataflow.h"
+
+// Most stack slots whose values are followed at once
+#define BA_CP_MAXSLOTS 0x20
+
+#define BA_CP_RSP (BA_IM_RSP - BA_IM_RAX)
+#define BA_CP_RBP (BA_IM_RBP - BA_IM_RAX)
+// Registers that funcs must preserve (RBX, RBP, R12 - R15)
+#define BA_CP_CALLEESAVED 0xf028llu
+
+#define BA_CP_ISGPR(val) (BA_IM_RAX <= (val) && BA_IM_R15 >= (val))
+#define BA_CP_ISGPRB(val) (BA_IM_AL <= (val) && BA_IM_R15B >= (val))
+#define BA_CP_ISJCC(op) (BA_IM_LABELJZ <= (op) && BA_IM_LABELJGE >= (op))
+#define BA_CP_ISSET(op) (BA_IM_SETS <= (op) && BA_IM_SETGE >= (op))
+#define BA_CP_ISCMOV(op) (BA_IM_CMOVZ <= (op) && BA_IM_CMOVGE >= (op))
+#define BA_CP_ISSHIFT(op) (BA_IM_ROL <= (op) && BA_IM_SAR >= (op))
+
+u64 cpBranchCnt = 0;
+u64 cpImmCnt = 0;
+u64 cpFoldCnt = 0;
+
+// What is known about the registers, stack and flags at a point
+struct ba_CPState {
+	bool isReached;
+	u64 vals[16];
+	u64 isKnown; // Registers whose whole value is in vals
+	u64 isLowKnown; // Registers whose lowest byte is in vals
+	bool isRspKnown;
+	i64 rspOfst; // RSP - RBP
+	// 8 byte stack slots with known values, by their offset from RBP
+	u64 slotCnt;
+	i64 slotOfsts[BA_CP_MAXSLOTS];
+	u64 slotVals[BA_CP_MAXSLOTS];
+	// Operands of the CMP or TEST that last set the flags, if known
+	u64 flagOp;
+	u64 flagLhs;
+	u64 flagRhs;
+};
+
+enum {
+	BA_CP_NONE = 0,
+	BA_CP_REG,
+	BA_CP_REGB,
+	BA_CP_IMM,
+	BA_CP_MEM,
+	BA_CP_OTHER, // Static address
+};
+
+struct ba_CPOperand {
+	u8 kind;
+	u64 idx; // Index of the operand in the IM
+	u64 reg; // Register number, or base register of memory
+	u64 imm;
+	bool isMem64;
+	bool isIndexed; // Memory with ADRADDREGMUL
+	i64 disp; // Offset of memory from its base
+	bool isSlot; // Memory at a known offset from RBP
+	i64 ofst; // That offset
+};
+
+// ----- State -----
+
+void CPKillReg(struct ba_CPState* state, u64 reg) {
+	state->isKnown &= ~(1llu << reg);
+	state->isLowKnown &= ~(1llu << reg);
+}
+
+void CPSetReg(struct ba_CPState* state, u64 reg, u64 val) {
+	state->vals[reg] = val;
+	state->isKnown |= 1llu << reg;
+	state->isLowKnown |= 1llu << reg;
+}
+
+void CPSetLow(struct ba_CPState* state, u64 reg, u64 val) {
+	state->vals[reg] = (state->vals[reg] & ~0xffllu) | (val & 0xff);
+	state->isLowKnown |= 1llu << reg;
+}
+
+i64 CPFindSlot(struct ba_CPState* state, i64 ofst) {
+	for (u64 i = 0; i < state->slotCnt; i++) {
+		if (state->slotOfsts[i] == ofst) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Forgets the slots that overlap size bytes at ofst
+void CPKillSlots(struct ba_CPState* state, i64 ofst, u64 size) {
+	u64 cnt = 0;
+	for (u64 i = 0; i < state->slotCnt; i++) {
+		i64 slot = state->slotOfsts[i];
+		if (slot + 8 <= ofst || slot >= ofst + (i64)size) {
+			state->slotOfsts[cnt] = slot;
+			state->slotVals[cnt++] = state->slotVals[i];
+		}
+	}
+	state->slotCnt = cnt;
+}
+
+void CPSetSlot(struct ba_CPState* state, i64 ofst, u64 val) {
+	CPKillSlots(state, ofst, 8);
+	if (state->slotCnt < BA_CP_MAXSLOTS) {
+		state->slotOfsts[state->slotCnt] = ofst;
+		state->slotVals[state->slotCnt++] = val;
+	}
+}
+
+// Moves RSP by diff, forgetting slots that end up below it
+void CPMoveRsp(struct ba_CPState* state, i64 diff) {
+	if (!state->isRspKnown) {
+		return;
+	}
+	state->rspOfst += diff;
+	u64 cnt = 0;
+	for (u64 i = 0; i < state->slotCnt; i++) {
+		if (state->slotOfsts[i] >= state->rspOfst) {
+			state->slotOfsts[cnt] = state->slotOfsts[i];
+			state->slotVals[cnt++] = state->slotVals[i];
+		}
+	}
+	state->slotCnt = cnt;
+}
+
+void CPSetRsp(struct ba_CPState* state, i64 rspOfst) {
+	state->isRspKnown = 1;
+	state->rspOfst = rspOfst;
+	CPMoveRsp(state, 0);
+}
+
+// Reached with nothing known
+void CPSetUnknown(struct ba_CPState* state) {
+	*state = (struct ba_CPState){ 0 };
+	state->isReached = 1;
+}
+
+/* Keeps only what is known the same way in both states, returns whether
+ * anything in state changed */
+bool CPMeet(struct ba_CPState* state, struct ba_CPState* other) {
+	if (!other->isReached) {
+		return 0;
+	}
+	if (!state->isReached) {
+		*state = *other;
+		return 1;
+	}
+
+	bool isChanged = 0;
+	for (u64 reg = 0; reg < 16; reg++) {
+		u64 bit = 1llu << reg;
+		u64 diff = state->vals[reg] ^ other->vals[reg];
+		if ((state->isKnown & bit) && (!(other->isKnown & bit) || diff)) {
+			state->isKnown &= ~bit;
+			isChanged = 1;
+		}
+		if ((state->isLowKnown & bit) &&
+			(!(other->isLowKnown & bit) || (diff & 0xff)))
+		{
+			state->isLowKnown &= ~bit;
+			isChanged = 1;
+		}
+	}
+
+	if (state->isRspKnown && (!other->isRspKnown ||
+		state->rspOfst != other->rspOfst))
+	{
+		state->isRspKnown = 0;
+		isChanged = 1;
+	}
+
+	u64 cnt = 0;
+	for (u64 i = 0; i < state->slotCnt; i++) {
+		i64 j = CPFindSlot(other, state->slotOfsts[i]);
+		if (j >= 0 && other->slotVals[j] == state->slotVals[i]) {
+			state->slotOfsts[cnt] = state->slotOfsts[i];
+			state->slotVals[cnt++] = state->slotVals[i];
+		}
+	}
+	(cnt != state->slotCnt) && (isChanged = 1);
+	state->slotCnt = cnt;
+
+	if (state->flagOp && (state->flagOp != other->flagOp ||
+		state->flagLhs != other->flagLhs || state->flagRhs != other->flagRhs))
+	{
+		state->flagOp = 0;
+		isChanged = 1;
+	}
+
+	return isChanged;
+}
+
+// ----- Operands -----
+
+// Reads the operand at im->vals[*idxPtr] and moves *idxPtr past it
+struct ba_CPOperand CPReadOperand(struct ba_CPState* state, struct ba_IM* im,
+	u64* idxPtr)
+{
+	u64 idx = *idxPtr;
+	struct ba_CPOperand opd = { .idx = idx };
+	if (idx >= im->count) {
+		return opd;
+	}
+	u64 val = im->vals[idx];
+
+	if (BA_CP_ISGPR(val) || BA_CP_ISGPRB(val)) {
+		opd.kind = BA_CP_ISGPR(val) ? BA_CP_REG : BA_CP_REGB;
+		opd.reg = ba_IMRegNum(val);
+		*idxPtr = idx + 1;
+		return opd;
+	}
+	if (val == BA_IM_IMM || val == BA_IM_STATIC) {
+		opd.kind = val == BA_IM_IMM ? BA_CP_IMM : BA_CP_OTHER;
+		opd.imm = im->vals[idx+1];
+		*idxPtr = idx + 2;
+		return opd;
+	}
+	if (val < BA_IM_ADR || val > BA_IM_64ADRSUB) {
+		*idxPtr = im->count;
+		return opd;
+	}
+
+	opd.kind = BA_CP_MEM;
+	opd.reg = ba_IMRegNum(im->vals[idx+1]);
+	opd.isMem64 = val >= BA_IM_64ADR;
+	opd.isIndexed = val == BA_IM_ADRADDREGMUL;
+	if (val == BA_IM_ADRADD || val == BA_IM_64ADRADD) {
+		opd.disp = im->vals[idx+2];
+	}
+	else if (val == BA_IM_ADRSUB || val == BA_IM_64ADRSUB) {
+		opd.disp = -(i64)im->vals[idx+2];
+	}
+	*idxPtr = idx + 2 + (val != BA_IM_ADR && val != BA_IM_64ADR) +
+		opd.isIndexed;
+
+	if (!opd.isIndexed && opd.reg == BA_CP_RBP) {
+		opd.isSlot = 1;
+		opd.ofst = opd.disp;
+	}
+	else if (!opd.isIndexed && opd.reg == BA_CP_RSP && state->isRspKnown) {
+		opd.isSlot = 1;
+		opd.ofst = state->rspOfst + opd.disp;
+	}
+	return opd;
+}
+
+/* Gets the value of opd into *valPtr if it is known, only its lowest byte
+ * if isByte */
+bool CPOperandVal(struct ba_CPState* state, struct ba_CPOperand* opd,
+	bool isByte, u64* valPtr)
+{
+	if (opd->kind == BA_CP_IMM) {
+		*valPtr = opd->imm;
+		return 1;
+	}
+	if (opd->kind == BA_CP_REG || opd->kind == BA_CP_REGB) {
+		u64 isKnown = (isByte || opd->kind == BA_CP_REGB)
+			? state->isLowKnown : state->isKnown;
+		*valPtr = state->vals[opd->reg];
+		return opd->reg != BA_CP_RSP && opd->reg != BA_CP_RBP &&
+			(isKnown & (1llu << opd->reg));
+	}
+	if (opd->kind == BA_CP_MEM && opd->isSlot) {
+		i64 slot = CPFindSlot(state, opd->ofst);
+		(slot >= 0) && (*valPtr = state->slotVals[slot]);
+		return slot >= 0;
+	}
+	return 0;
+}
+
+// Whether imm sign extends from 32 bits
+bool IsCPImm32(u64 imm) {
+	return (i64)imm >= -(1ll << 31) && (i64)imm < (1ll << 31);
+}
+
+/* Whether the condition of a Jcc, SETcc or CMOVcc holds, or -1 if that
+ * isn't known */
+i64 CPEvalCond(struct ba_CPState* state, u64 op) {
+	if (!state->flagOp) {
+		return -1;
+	}
+	// Position in the order of SETcc
+	u64 cond = BA_CP_ISJCC(op) ? op - BA_IM_LABELJZ + 2
+		: BA_CP_ISCMOV(op) ? op - BA_IM_CMOVZ + 2 : op - BA_IM_SETS;
+
+	u64 lhs = state->flagLhs;
+	u64 rhs = state->flagRhs;
+	bool isCmp = state->flagOp == BA_IM_CMP;
+	u64 res = isCmp ? lhs - rhs : lhs & rhs;
+	bool zf = !res;
+	bool sf = (i64)res < 0;
+	bool cf = isCmp && lhs < rhs;
+	bool lt = isCmp ? (i64)lhs < (i64)rhs : sf;
+	bool conds[] = { sf, !sf, zf, !zf, cf, cf || zf, !cf && !zf, !cf,
+		lt, lt || zf, !lt && !zf, !lt };
+	return cond < sizeof(conds) / sizeof(*conds) ? conds[cond] : -1;
+}
+
+// ----- Transfer -----
+
+// Result of op on lhs and rhs (rhs unused by unary ops)
+u64 CPCompute(u64 op, u64 lhs, u64 rhs) {
+	u64 cnt = rhs & 0x3f;
+	switch (op) {
+		case BA_IM_ADD: return lhs + rhs;
+		case BA_IM_SUB: return lhs - rhs;
+		case BA_IM_AND: return lhs & rhs;
+		case BA_IM_OR:  return lhs | rhs;
+		case BA_IM_XOR: return lhs ^ rhs;
+		case BA_IM_IMUL: return lhs * rhs;
+		case BA_IM_INC: return lhs + 1;
+		case BA_IM_DEC: return lhs - 1;
+		case BA_IM_NOT: return ~lhs;
+		case BA_IM_NEG: return -lhs;
+		case BA_IM_SHL: return lhs << cnt;
+		case BA_IM_SHR: return lhs >> cnt;
+		case BA_IM_SAR: return (i64)lhs >> cnt;
+		case BA_IM_ROL: return cnt ? (lhs << cnt) | (lhs >> (64 - cnt)) : lhs;
+		case BA_IM_ROR: return cnt ? (lhs >> cnt) | (lhs << (64 - cnt)) : lhs;
+	}
+	return 0;
+}
+
+// Whether the value that op writes can be followed
+bool IsCPComputable(u64 op) {
+	return op == BA_IM_ADD || op == BA_IM_SUB || op == BA_IM_AND ||
+		op == BA_IM_OR || op == BA_IM_XOR || op == BA_IM_IMUL ||
+		op == BA_IM_INC || op == BA_IM_DEC || op == BA_IM_NOT ||
+		op == BA_IM_NEG || BA_CP_ISSHIFT(op);
+}
+
+// Whether im leaves the flags as they were
+bool IsCPFlagsKept(u64 op) {
+	return op == BA_IM_NOP || op == BA_IM_MOV || op == BA_IM_LEA ||
+		op == BA_IM_PUSH || op == BA_IM_POP || op == BA_IM_MOVZX ||
+		op == BA_IM_NOT || op == BA_IM_CQO || op == BA_IM_LABEL ||
+		op == BA_IM_REGHINT || op == BA_IM_LABELJMP || BA_CP_ISJCC(op) ||
+		BA_CP_ISSET(op) || BA_CP_ISCMOV(op);
+}
+
+// Writes to RSP or RBP
+void CPWriteStackReg(struct ba_CPState* state, struct ba_IM* im,
+	struct ba_CPOperand* dst, struct ba_CPOperand* src)
+{
+	u64 op = im->vals[0];
+	if (dst->reg == BA_CP_RBP) {
+		bool isNewFrame = op == BA_IM_MOV && src->kind == BA_CP_REG &&
+			src->reg == BA_CP_RSP;
+		state->slotCnt = 0;
+		state->isRspKnown = 0;
+		isNewFrame && (CPSetRsp(state, 0), 1);
+		return;
+	}
+
+	if ((op == BA_IM_ADD || op == BA_IM_SUB) && src->kind == BA_CP_IMM) {
+		CPMoveRsp(state, op == BA_IM_ADD ? src->imm : -src->imm);
+	}
+	else if (op == BA_IM_MOV && src->kind == BA_CP_REG &&
+		src->reg == BA_CP_RBP)
+	{
+		CPSetRsp(state, 0);
+	}
+	else if (op == BA_IM_LEA && src->kind == BA_CP_MEM && src->isSlot) {
+		CPSetRsp(state, src->ofst);
+	}
+	else {
+		state->isRspKnown = 0;
+	}
+}
+
+// Updates state to what is known after im
+void CPTransfer(struct ba_CPState* state, struct ba_IM* im) {
+	u64 op = im->vals[0];
+	if (op == BA_IM_NOP || op == BA_IM_LABEL || op == BA_IM_REGHINT ||
+		op == BA_IM_LABELJMP || BA_CP_ISJCC(op) || op == BA_IM_RET)
+	{
+		return;
+	}
+	if (op == BA_IM_LABELCALL || op == BA_IM_SYSCALL) {
+		u64 kept = op == BA_IM_LABELCALL ? BA_CP_CALLEESAVED
+			: ~((1llu << 0) | (1llu << 1) | (1llu << 11));
+		state->isKnown &= kept;
+		state->isLowKnown &= kept;
+		state->slotCnt = 0;
+		state->flagOp = 0;
+		return;
+	}
+	if (op == BA_IM_CQO) {
+		state->isKnown & 1
+			? CPSetReg(state, 2, (i64)state->vals[0] >> 63)
+			: CPKillReg(state, 2);
+		return;
+	}
+
+	u64 idx = 1;
+	struct ba_CPOperand dst = CPReadOperand(state, im, &idx);
+	struct ba_CPOperand src = CPReadOperand(state, im, &idx);
+	struct ba_CPOperand src2 = CPReadOperand(state, im, &idx);
+	bool isByte = dst.kind == BA_CP_REGB || src.kind == BA_CP_REGB ||
+		BA_CP_ISSET(op);
+
+	if (op == BA_IM_CMP || op == BA_IM_TEST) {
+		u64 lhs = 0;
+		u64 rhs = 0;
+		bool isKnown = !isByte && CPOperandVal(state, &dst, 0, &lhs) &&
+			CPOperandVal(state, &src, 0, &rhs);
+		state->flagOp = isKnown ? op : 0;
+		state->flagLhs = lhs;
+		state->flagRhs = rhs;
+		return;
+	}
+	IsCPFlagsKept(op) || (state->flagOp = 0);
+
+	if (op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV ||
+		(op == BA_IM_IMUL && dst.kind == BA_CP_MEM) ||
+		(op == BA_IM_IMUL && src.kind == BA_CP_NONE))
+	{
+		CPKillReg(state, 0);
+		CPKillReg(state, 2);
+		return;
+	}
+
+	if (op == BA_IM_PUSH) {
+		u64 val;
+		bool isKnown = CPOperandVal(state, &dst, 0, &val);
+		if (!state->isRspKnown) {
+			state->slotCnt = 0;
+			return;
+		}
+		CPMoveRsp(state, -8);
+		isKnown ? CPSetSlot(state, state->rspOfst, val)
+			: CPKillSlots(state, state->rspOfst, 8);
+		return;
+	}
+
+	if (op == BA_IM_POP) {
+		struct ba_CPOperand top = { .kind = BA_CP_MEM, .isSlot = 1,
+			.ofst = state->rspOfst };
+		u64 val;
+		bool isKnown = state->isRspKnown &&
+			CPOperandVal(state, &top, 0, &val);
+		CPMoveRsp(state, 8);
+		if (dst.reg == BA_CP_RBP || dst.reg == BA_CP_RSP) {
+			CPWriteStackReg(state, im, &dst, &src);
+			return;
+		}
+		isKnown ? CPSetReg(state, dst.reg, val) : CPKillReg(state, dst.reg);
+		return;
+	}
+
+	// Value written to dst
+	u64 val = 0;
+	bool isKnown = 0;
+	u64 lhs = 0;
+	u64 rhs = 0;
+	bool isLhsKnown = CPOperandVal(state, &dst, isByte, &lhs);
+	bool isRhsKnown = CPOperandVal(state, &src, isByte, &rhs);
+	if (op == BA_IM_MOV) {
+		isKnown = isRhsKnown;
+		val = rhs;
+	}
+	else if (op == BA_IM_MOVZX) {
+		isKnown = src.kind == BA_CP_REGB && isRhsKnown;
+		val = rhs & 0xff;
+	}
+	else if (op == BA_IM_LEA) {
+		isKnown = src.kind == BA_CP_MEM && !src.isIndexed &&
+			src.reg != BA_CP_RSP &&
+			src.reg != BA_CP_RBP && (state->isKnown & (1llu << src.reg));
+		val = state->vals[src.reg] + src.disp;
+	}
+	else if ((op == BA_IM_XOR || op == BA_IM_SUB) && dst.kind == src.kind &&
+		(dst.kind == BA_CP_REG || dst.kind == BA_CP_REGB) &&
+		dst.reg == src.reg)
+	{
+		isKnown = 1;
+	}
+	else if (op == BA_IM_IMUL && src2.kind == BA_CP_IMM) {
+		isKnown = isRhsKnown;
+		val = rhs * src2.imm;
+	}
+	else if (BA_CP_ISSET(op)) {
+		i64 cond = CPEvalCond(state, op);
+		isKnown = cond >= 0;
+		val = cond;
+	}
+	else if (BA_CP_ISCMOV(op)) {
+		i64 cond = CPEvalCond(state, op);
+		isKnown = (cond == 1 && isRhsKnown) || (!cond && isLhsKnown) ||
+			(isLhsKnown && isRhsKnown && lhs == rhs);
+		val = cond == 1 ? rhs : lhs;
+	}
+	else if (IsCPComputable(op)) {
+		bool isUnary = op == BA_IM_INC || op == BA_IM_DEC ||
+			op == BA_IM_NOT || op == BA_IM_NEG;
+		isKnown = isLhsKnown && (isUnary || isRhsKnown);
+		val = CPCompute(op, lhs, rhs);
+	}
+
+	if (dst.kind == BA_CP_REG) {
+		if (dst.reg == BA_CP_RSP || dst.reg == BA_CP_RBP) {
+			CPWriteStackReg(state, im, &dst, &src);
+			return;
+		}
+		isKnown ? CPSetReg(state, dst.reg, val) : CPKillReg(state, dst.reg);
+	}
+	else if (dst.kind == BA_CP_REGB) {
+		if (dst.reg == BA_CP_RSP || dst.reg == BA_CP_RBP) {
+			CPWriteStackReg(state, im, &dst, &src);
+			return;
+		}
+		isKnown ? CPSetLow(state, dst.reg, val) : CPKillReg(state, dst.reg);
+	}
+	else if (dst.kind == BA_CP_MEM && dst.isSlot) {
+		(isKnown && !isByte) ? CPSetSlot(state, dst.ofst, val)
+			: CPKillSlots(state, dst.ofst, isByte ? 1 : 8);
+	}
+	else if (dst.kind == BA_CP_MEM) {
+		state->slotCnt = 0;
+	}
+	else if (dst.kind == BA_CP_NONE) {
+		// Not understood, so anything may have changed
+		CPSetUnknown(state);
+	}
+}
+
+// ----- Rewriting -----
+
+// Makes the memory operand at idx 64 bit and puts IMM val after it
+void CPStoreImm(struct ba_IM* im, u64 idx, u64 val) {
+	u64 mark = im->vals[idx];
+	(mark < BA_IM_64ADR) && (im->vals[idx] = mark + 4);
+	im->vals[im->count-1] = BA_IM_IMM;
+	im->vals[im->count++] = val;
+}
+
+/* Replaces parts of im that are known in state before it with immediates,
+ * or removes it if it does nothing */
+void CPRewriteIM(struct ba_CPState* state, struct ba_IM* im) {
+	u64 op = im->vals[0];
+	if (BA_CP_ISJCC(op)) {
+		i64 cond = CPEvalCond(state, op);
+		(cond == 1) && (im->vals[0] = BA_IM_LABELJMP);
+		(!cond) && (im->count = 0);
+		(cond >= 0) && ++cpBranchCnt;
+		return;
+	}
+	if (op == BA_IM_NOP || op == BA_IM_LABEL || op == BA_IM_REGHINT ||
+		op == BA_IM_LABELJMP || op == BA_IM_LABELCALL ||
+		op == BA_IM_SYSCALL || op == BA_IM_RET || op == BA_IM_CQO)
+	{
+		return;
+	}
+
+	u64 idx = 1;
+	struct ba_CPOperand dst = CPReadOperand(state, im, &idx);
+	struct ba_CPOperand src = CPReadOperand(state, im, &idx);
+	struct ba_CPOperand src2 = CPReadOperand(state, im, &idx);
+	u64 val;
+
+	if (BA_CP_ISSET(op) && dst.kind == BA_CP_REGB) {
+		i64 cond = CPEvalCond(state, op);
+		if (cond >= 0) {
+			*im = (struct ba_IM){ 4, { BA_IM_MOV, im->vals[1], BA_IM_IMM,
+				cond } };
+			++cpBranchCnt;
+		}
+		return;
+	}
+	if (BA_CP_ISCMOV(op)) {
+		i64 cond = CPEvalCond(state, op);
+		(cond == 1) && (im->vals[0] = BA_IM_MOV);
+		(!cond) && (im->count = 0);
+		(cond >= 0) && ++cpBranchCnt;
+		return;
+	}
+
+	if (op == BA_IM_PUSH) {
+		if (dst.kind == BA_CP_REG && CPOperandVal(state, &dst, 0, &val) &&
+			IsCPImm32(val))
+		{
+			*im = (struct ba_IM){ 3, { BA_IM_PUSH, BA_IM_IMM, val } };
+			++cpImmCnt;
+		}
+		return;
+	}
+
+	bool isSrcReplaceable = src.kind == BA_CP_REG ||
+		src.kind == BA_CP_REGB || (src.kind == BA_CP_MEM && src.isSlot);
+	if (!isSrcReplaceable || src2.kind != BA_CP_NONE ||
+		!CPOperandVal(state, &src, dst.kind == BA_CP_REGB, &val))
+	{
+		return;
+	}
+
+	// Registers: any value can be moved in, other ops take 32 bit immediates
+	bool isAlu = op == BA_IM_ADD || op == BA_IM_SUB || op == BA_IM_AND ||
+		op == BA_IM_OR || op == BA_IM_XOR || op == BA_IM_CMP;
+	if (dst.kind == BA_CP_REG || dst.kind == BA_CP_REGB) {
+		bool isSameReg = src.kind == dst.kind && src.reg == dst.reg;
+		if (op == BA_IM_MOV || (op == BA_IM_MOVZX && src.kind == BA_CP_REGB)) {
+			val = op == BA_IM_MOVZX ? val & 0xff : val;
+			*im = (struct ba_IM){ 4, { BA_IM_MOV, im->vals[1], BA_IM_IMM,
+				val } };
+		}
+		else if (dst.kind == BA_CP_REG && (isAlu || op == BA_IM_TEST) &&
+			src.kind != BA_CP_REGB && !isSameReg && IsCPImm32(val))
+		{
+			*im = (struct ba_IM){ 4, { op, im->vals[1], BA_IM_IMM, val } };
+		}
+		else if (op == BA_IM_IMUL && dst.kind == BA_CP_REG &&
+			src.kind != BA_CP_REGB && IsCPImm32(val))
+		{
+			*im = (struct ba_IM){ 5, { op, im->vals[1], im->vals[1],
+				BA_IM_IMM, val } };
+		}
+		else if (BA_CP_ISSHIFT(op) && src.kind == BA_CP_REGB) {
+			*im = (struct ba_IM){ 4, { op, im->vals[1], BA_IM_IMM,
+				val & 0x3f } };
+		}
+		else if (dst.kind == BA_CP_REGB && isAlu && src.kind == BA_CP_REGB &&
+			!isSameReg)
+		{
+			*im = (struct ba_IM){ 4, { op, im->vals[1], BA_IM_IMM,
+				val & 0xff } };
+		}
+		else {
+			return;
+		}
+		++cpImmCnt;
+		return;
+	}
+
+	// Memory: 64 bit stores of 32 bit immediates
+	if (dst.kind == BA_CP_MEM && !dst.isIndexed && src.kind == BA_CP_REG &&
+		(op == BA_IM_MOV || isAlu) && IsCPImm32(val))
+	{
+		CPStoreImm(im, dst.idx, val);
+		++cpImmCnt;
+	}
+}
+
+/* Replaces im by a move of its result to its register if that is known and
+ * nothing needs the flags it sets */
+void CPFoldIM(struct ba_CPState* state, struct ba_IM* im, u64 liveAfter) {
+	u64 op = im->vals[0];
+	u64 reg = ba_IMRegNum(im->vals[1]);
+	bool isFlagsKept = op == BA_IM_NOT || op == BA_IM_LEA ||
+		op == BA_IM_MOVZX;
+	bool isZeroing = op == BA_IM_XOR && im->count == 3 &&
+		im->vals[1] == im->vals[2];
+	if (!(IsCPComputable(op) || op == BA_IM_LEA || op == BA_IM_MOVZX) ||
+		isZeroing || !BA_CP_ISGPR(im->vals[1]) || reg == BA_CP_RSP ||
+		reg == BA_CP_RBP || !(state->isKnown & (1llu << reg)) ||
+		(!isFlagsKept && (liveAfter & BA_DF_FLAGS)) ||
+		(op == BA_IM_IMUL && im->count < 3))
+	{
+		return;
+	}
+	*im = (struct ba_IM){ 4, { BA_IM_MOV, im->vals[1], BA_IM_IMM,
+		state->vals[reg] } };
+	++cpFoldCnt;
+}
+
+// ----- Pass -----
+
+void ba_ConstProp(struct ba_Ctr* ctr) {
+	struct ba_DFGraph* graph = ba_NewDFGraph(ctr);
+	ba_DFLiveness(graph);
+	if (!graph->blockCnt) {
+		ba_DelDFGraph(graph);
+		return;
+	}
+
+	// The program and funcs start with nothing known
+	struct ba_CPState* ins = ba_CAlloc(graph->blockCnt, sizeof(*ins));
+	CPSetUnknown(&ins[graph->entry]);
+	for (u64 i = 0; i < graph->imCnt; i++) {
+		struct ba_IM* im = graph->ims[i];
+		if (im->vals[0] == BA_IM_LABELCALL && im->vals[1] <= ctr->labelCnt &&
+			graph->labelBlocks[im->vals[1]] >= 0)
+		{
+			CPSetUnknown(&ins[graph->labelBlocks[im->vals[1]]]);
+		}
+	}
+
+	struct ba_CPState* state = ba_MAlloc(sizeof(*state));
+	bool isChanged = 1;
+	while (isChanged) {
+		isChanged = 0;
+		for (u64 i = 0; i < graph->blockCnt; i++) {
+			struct ba_DFBlock* block = &graph->blocks[i];
+			if (!block->isReachable || !ins[i].isReached) {
+				continue;
+			}
+			*state = ins[i];
+			for (u64 j = block->start; j < block->end; j++) {
+				CPTransfer(state, graph->ims[j]);
+			}
+			for (u64 j = 0; j < 2; j++) {
+				(block->succs[j] >= 0) &&
+					CPMeet(&ins[block->succs[j]], state) && (isChanged = 1);
+			}
+		}
+	}
+
+	u64 liveCap = 0x40;
+	u64* liveAfters = ba_MAlloc(liveCap * sizeof(*liveAfters));
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		if (!block->isReachable || !ins[i].isReached) {
+			continue;
+		}
+		u64 len = block->end - block->start;
+		if (len > liveCap) {
+			liveCap = len;
+			liveAfters = ba_Realloc(liveAfters, liveCap * sizeof(*liveAfters));
+		}
+		u64 live = block->liveOut;
+		for (u64 j = len; j-- > 0;) {
+			liveAfters[j] = live;
+			live = ba_DFLiveBefore(graph->ims[block->start+j], live);
+		}
+
+		*state = ins[i];
+		for (u64 j = 0; j < len; j++) {
+			struct ba_IM* im = graph->ims[block->start+j];
+			CPRewriteIM(state, im);
+			if (!im->count) {
+				continue;
+			}
+			CPTransfer(state, im);
+			CPFoldIM(state, im, liveAfters[j]);
+		}
+	}
+
+	free(liveAfters);
+	free(state);
+	free(ins);
+	ba_DelDFGraph(graph);
+	ba_CompactIM(ctr);
+}
+
+void ba_ConstPropPrintStats(FILE* file) {
+	fprintf(file, "constprop: %-14s %llu\n", "branches", cpBranchCnt);
+	fprintf(file, "constprop: %-14s %llu\n", "immediates", cpImmCnt);
+	fprintf(file, "constprop: %-14s %llu\n", "folded", cpFoldCnt);
+}
@@ -0,0 +1,18 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__CONSTPROP_H
+#define BA__CONSTPROP_H
+
+#include "common/ctr.h"
+
+/* Follows the values of registers and stack slots that are known at compile
+ * time through the control flow graph (dataflow.c). Branches on known
+ * conditions become jumps or are removed, known operands become immediates
+ * and instructions with known results become moves, leaving the code that
+ * no longer runs or is no longer used to DCE (dce.c). Functions must already
+ * be emplaced (ba_EmplaceIM). */
+
+void ba_ConstProp(struct ba_Ctr* ctr);
+void ba_ConstPropPrintStats(FILE* file);
+
+#endif
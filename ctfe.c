@@ -0,0 +1,597 @@
+// See LICENSE for copyright/license information
+
+#include "ctfe.h"
+#include "common/parser.h"
+#include "common/symtable.h"
+
+/* Address of the bottom of the stack, as seen by the code being run. It is in
+ * the kernel's half of the address space so that no address a program could
+ * use at runtime is mistaken for it. */
+#define BA_CTFE_STACKBASE 0xffffc7fe00000000llu
+// Pushed as the return address of a call, along with the depth of the call
+#define BA_CTFE_RETMARK 0xc7fe000000000000llu
+
+#define BA_CTFE_ISJCC(op) (BA_IM_LABELJZ <= (op) && BA_IM_LABELJGE >= (op))
+#define BA_CTFE_ISSET(op) (BA_IM_SETS <= (op) && BA_IM_SETGE >= (op))
+#define BA_CTFE_ISCMOV(op) (BA_IM_CMOVZ <= (op) && BA_IM_CMOVGE >= (op))
+
+u64 ctfeCallCnt = 0;
+u64 ctfeNoFuelCnt = 0;
+u64 ctfeFallbackCnt = 0;
+u64 ctfeCachedCnt = 0;
+
+// Fuel left for all calls in the program
+u64 ctfeTotalFuel = BA_CTFE_TOTALFUEL;
+
+// Reused by every call that is run
+u8* ctfeStack = 0;
+
+struct ba_CTFE {
+	struct ba_Ctr* ctr;
+	u64 regs[16];
+	bool zf;
+	bool sf;
+	bool cf;
+	bool of;
+	// Where each label of the funcs loaded so far is
+	struct ba_IMChunk** labelChunks;
+	struct ba_IM** labelIMs;
+	// The IM being run
+	struct ba_IMChunk* chunk;
+	struct ba_IM* im;
+	// Where each call in progress returns to
+	struct ba_IMChunk* retChunks[BA_CTFE_MAXDEPTH];
+	struct ba_IM* retIMs[BA_CTFE_MAXDEPTH];
+	u64 depth;
+};
+
+enum {
+	BA_CTFE_REG = 1,
+	BA_CTFE_REGB,
+	BA_CTFE_IMM,
+	BA_CTFE_MEM,
+};
+
+struct ba_CTFEOperand {
+	u8 kind;
+	u64 reg;
+	u64 val; // Immediate, or address of memory
+};
+
+// ----- Funcs and labels -----
+
+// Defined func whose IM starts with label lbl, or 0
+struct ba_Func* CTFEFindFunc(struct ba_SymTable* scope, u64 lbl) {
+	u64 entryCnt = 0;
+	struct ba_HTEntry* entries = ba_STEntries(scope, &entryCnt);
+	for (u64 i = 0; i < entryCnt; i++) {
+		struct ba_STVal* val = (struct ba_STVal*)entries[i].val;
+		if (val && entries[i].key && val->type.type == BA_TYPE_FUNC) {
+			struct ba_Func* func = val->type.extraInfo;
+			if (func->isDefined && func->lblStart == lbl) {
+				return func;
+			}
+		}
+	}
+	for (u64 i = 0; i < scope->childCnt; i++) {
+		struct ba_Func* func = CTFEFindFunc(scope->children[i], lbl);
+		if (func) {
+			return func;
+		}
+	}
+	return 0;
+}
+
+// Records where the labels in the IM of func are
+void CTFELoadFunc(struct ba_CTFE* ctfe, struct ba_Func* func) {
+	struct ba_IMChunk* chunk = func->im->first;
+	for (struct ba_IM* im = ba_IMNext(&chunk, 0); im;
+		im = ba_IMNext(&chunk, im))
+	{
+		if (im->vals[0] == BA_IM_LABEL && im->vals[1] <= ctfe->ctr->labelCnt) {
+			ctfe->labelChunks[im->vals[1]] = chunk;
+			ctfe->labelIMs[im->vals[1]] = im;
+		}
+	}
+}
+
+// Continues after label lbl, returns 0 if it isn't in a defined func
+bool CTFEJump(struct ba_CTFE* ctfe, u64 lbl) {
+	if (lbl > ctfe->ctr->labelCnt) {
+		return 0;
+	}
+	if (!ctfe->labelIMs[lbl]) {
+		struct ba_Func* func = CTFEFindFunc(ctfe->ctr->globalST, lbl);
+		func && (CTFELoadFunc(ctfe, func), 1);
+	}
+	ctfe->chunk = ctfe->labelChunks[lbl];
+	ctfe->im = ctfe->labelIMs[lbl];
+	return !!ctfe->im;
+}
+
+// ----- Memory and operands -----
+
+bool CTFELoad(u64 addr, u64 size, u64* valPtr) {
+	if (addr < BA_CTFE_STACKBASE ||
+		addr > BA_CTFE_STACKBASE + BA_CTFE_STACKSIZE - size)
+	{
+		return 0;
+	}
+	u64 val = 0;
+	memcpy(&val, ctfeStack + (addr - BA_CTFE_STACKBASE), size);
+	*valPtr = val;
+	return 1;
+}
+
+bool CTFEStore(u64 addr, u64 size, u64 val) {
+	if (addr < BA_CTFE_STACKBASE ||
+		addr > BA_CTFE_STACKBASE + BA_CTFE_STACKSIZE - size)
+	{
+		return 0;
+	}
+	memcpy(ctfeStack + (addr - BA_CTFE_STACKBASE), &val, size);
+	return 1;
+}
+
+/* Reads the operand at im->vals[*idxPtr] and moves *idxPtr past it.
+ * Returns 0 for operands that can't be run, such as static addresses. */
+bool CTFEReadOperand(struct ba_CTFE* ctfe, struct ba_IM* im, u64* idxPtr,
+	struct ba_CTFEOperand* opd)
+{
+	u64 idx = *idxPtr;
+	u64 val = im->vals[idx];
+	if (BA_IM_RAX <= val && BA_IM_R15 >= val) {
+		*opd = (struct ba_CTFEOperand){ BA_CTFE_REG, val - BA_IM_RAX, 0 };
+		*idxPtr = idx + 1;
+		return 1;
+	}
+	if (BA_IM_AL <= val && BA_IM_R15B >= val) {
+		*opd = (struct ba_CTFEOperand){ BA_CTFE_REGB, val - BA_IM_AL, 0 };
+		*idxPtr = idx + 1;
+		return 1;
+	}
+	if (val == BA_IM_IMM && idx + 1 < im->count) {
+		*opd = (struct ba_CTFEOperand){ BA_CTFE_IMM, 0, im->vals[idx+1] };
+		*idxPtr = idx + 2;
+		return 1;
+	}
+	if (val < BA_IM_ADR || val > BA_IM_64ADRSUB) {
+		return 0;
+	}
+
+	u64 argCnt = 1 + (val != BA_IM_ADR && val != BA_IM_64ADR) +
+		(val == BA_IM_ADRADDREGMUL);
+	u64 base = im->vals[idx+1];
+	if (idx + argCnt >= im->count || base < BA_IM_RAX || base > BA_IM_R15) {
+		return 0;
+	}
+	u64 addr = ctfe->regs[base - BA_IM_RAX];
+	if (val == BA_IM_ADRADDREGMUL) {
+		u64 index = im->vals[idx+3];
+		if (index < BA_IM_RAX || index > BA_IM_R15) {
+			return 0;
+		}
+		addr += im->vals[idx+2] * ctfe->regs[index - BA_IM_RAX];
+	}
+	(val == BA_IM_ADRADD || val == BA_IM_64ADRADD) &&
+		(addr += im->vals[idx+2]);
+	(val == BA_IM_ADRSUB || val == BA_IM_64ADRSUB) &&
+		(addr -= im->vals[idx+2]);
+	*opd = (struct ba_CTFEOperand){ BA_CTFE_MEM, 0, addr };
+	*idxPtr = idx + argCnt + 1;
+	return 1;
+}
+
+bool CTFEGet(struct ba_CTFE* ctfe, struct ba_CTFEOperand* opd, u64 size,
+	u64* valPtr)
+{
+	if (opd->kind == BA_CTFE_MEM) {
+		return CTFELoad(opd->val, size, valPtr);
+	}
+	u64 val = opd->kind == BA_CTFE_IMM ? opd->val : ctfe->regs[opd->reg];
+	*valPtr = size == 1 ? val & 0xff : val;
+	return 1;
+}
+
+bool CTFESet(struct ba_CTFE* ctfe, struct ba_CTFEOperand* opd, u64 size,
+	u64 val)
+{
+	if (opd->kind == BA_CTFE_MEM) {
+		return CTFEStore(opd->val, size, val);
+	}
+	if (opd->kind == BA_CTFE_IMM) {
+		return 0;
+	}
+	u64* reg = &ctfe->regs[opd->reg];
+	*reg = size == 1 ? (*reg & ~0xffllu) | (val & 0xff) : val;
+	return 1;
+}
+
+bool CTFEPush(struct ba_CTFE* ctfe, u64 val) {
+	ctfe->regs[BA_IM_RSP - BA_IM_RAX] -= 8;
+	return CTFEStore(ctfe->regs[BA_IM_RSP - BA_IM_RAX], 8, val);
+}
+
+bool CTFEPop(struct ba_CTFE* ctfe, u64* valPtr) {
+	u64 addr = ctfe->regs[BA_IM_RSP - BA_IM_RAX];
+	ctfe->regs[BA_IM_RSP - BA_IM_RAX] += 8;
+	return CTFELoad(addr, 8, valPtr);
+}
+
+// ----- Running -----
+
+// Whether a condition holds, by its position in the order of SETcc
+bool CTFECond(struct ba_CTFE* ctfe, u64 cond) {
+	bool lt = ctfe->sf != ctfe->of;
+	bool conds[] = { ctfe->sf, !ctfe->sf, ctfe->zf, !ctfe->zf, ctfe->cf,
+		ctfe->cf || ctfe->zf, !ctfe->cf && !ctfe->zf, !ctfe->cf,
+		lt, lt || ctfe->zf, !lt && !ctfe->zf, !lt };
+	return conds[cond];
+}
+
+void CTFESetResultFlags(struct ba_CTFE* ctfe, u64 res, u64 size) {
+	u64 signBit = size == 1 ? 0x80 : 1llu << 63;
+	ctfe->zf = !(size == 1 ? res & 0xff : res);
+	ctfe->sf = !!(res & signBit);
+}
+
+// Runs im, returns 0 if it can't be run, 2 once the call has returned
+u8 CTFEStep(struct ba_CTFE* ctfe, struct ba_IM* im) {
+	u64 op = im->vals[0];
+	u64* regs = ctfe->regs;
+
+	if (op == BA_IM_NOP || op == BA_IM_LABEL || op == BA_IM_REGHINT) {
+		return 1;
+	}
+	if (op == BA_IM_LABELJMP || BA_CTFE_ISJCC(op)) {
+		bool isTaken = op == BA_IM_LABELJMP ||
+			CTFECond(ctfe, op - BA_IM_LABELJZ + 2);
+		return !isTaken || CTFEJump(ctfe, im->vals[1]);
+	}
+	if (op == BA_IM_LABELCALL) {
+		if (ctfe->depth >= BA_CTFE_MAXDEPTH ||
+			!CTFEPush(ctfe, BA_CTFE_RETMARK | ctfe->depth))
+		{
+			return 0;
+		}
+		ctfe->retChunks[ctfe->depth] = ctfe->chunk;
+		ctfe->retIMs[ctfe->depth++] = im;
+		return CTFEJump(ctfe, im->vals[1]);
+	}
+	if (op == BA_IM_RET) {
+		u64 mark;
+		if (!CTFEPop(ctfe, &mark) || !ctfe->depth ||
+			mark != (BA_CTFE_RETMARK | --ctfe->depth))
+		{
+			return 0;
+		}
+		if (!ctfe->depth) {
+			return 2;
+		}
+		ctfe->chunk = ctfe->retChunks[ctfe->depth];
+		ctfe->im = ctfe->retIMs[ctfe->depth];
+		return 1;
+	}
+	if (op == BA_IM_CQO) {
+		regs[2] = (i64)regs[0] >> 63;
+		return 1;
+	}
+
+	struct ba_CTFEOperand opds[3] = {0};
+	u64 opdCnt = 0;
+	for (u64 idx = 1; idx < im->count; opdCnt++) {
+		if (opdCnt == 3 || !CTFEReadOperand(ctfe, im, &idx, &opds[opdCnt])) {
+			return 0;
+		}
+	}
+	struct ba_CTFEOperand* dst = &opds[0];
+	struct ba_CTFEOperand* src = &opds[1];
+
+	u64 size = BA_CTFE_ISSET(op) ? 1 : 8;
+	for (u64 i = 0; i < opdCnt; i++) {
+		(opds[i].kind == BA_CTFE_REGB) && (size = 1);
+	}
+	// Shifts are only on 64 bit registers, even when the count is in CL
+	(op >= BA_IM_ROL && op <= BA_IM_SAR) && (size = 8);
+	u64 mask = size == 1 ? 0xff : ~0llu;
+	u64 signBit = size == 1 ? 0x80 : 1llu << 63;
+
+	if (op == BA_IM_PUSH) {
+		u64 val;
+		return opdCnt == 1 && CTFEGet(ctfe, dst, 8, &val) &&
+			CTFEPush(ctfe, val);
+	}
+	if (op == BA_IM_POP) {
+		u64 val;
+		return opdCnt == 1 && CTFEPop(ctfe, &val) && CTFESet(ctfe, dst, 8, val);
+	}
+	if (op == BA_IM_LEA) {
+		return opdCnt == 2 && src->kind == BA_CTFE_MEM &&
+			CTFESet(ctfe, dst, 8, src->val);
+	}
+	if (op == BA_IM_MOVZX) {
+		u64 val;
+		return opdCnt == 2 && CTFEGet(ctfe, src, 1, &val) &&
+			CTFESet(ctfe, dst, 8, val);
+	}
+	if (BA_CTFE_ISSET(op)) {
+		return opdCnt == 1 &&
+			CTFESet(ctfe, dst, 1, CTFECond(ctfe, op - BA_IM_SETS));
+	}
+	if (BA_CTFE_ISCMOV(op)) {
+		u64 val;
+		return opdCnt == 2 && CTFEGet(ctfe, src, 8, &val) &&
+			(!CTFECond(ctfe, op - BA_IM_CMOVZ + 2) ||
+			CTFESet(ctfe, dst, 8, val));
+	}
+
+	// Ops on RDX:RAX
+	bool isWide = op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV ||
+		(op == BA_IM_IMUL && opdCnt == 1);
+	if (isWide) {
+		u64 val;
+		if (opdCnt != 1 || !CTFEGet(ctfe, dst, 8, &val)) {
+			return 0;
+		}
+		unsigned __int128 wide = ((unsigned __int128)regs[2] << 64) | regs[0];
+		if (op == BA_IM_MUL) {
+			wide = (unsigned __int128)regs[0] * val;
+			ctfe->cf = ctfe->of = !!(u64)(wide >> 64);
+		}
+		else if (op == BA_IM_IMUL) {
+			__int128 prod = (__int128)(i64)regs[0] * (i64)val;
+			wide = prod;
+			ctfe->cf = ctfe->of = prod != (i64)prod;
+		}
+		else if (op == BA_IM_DIV) {
+			if (!val || (wide / val) >> 64) {
+				return 0;
+			}
+			wide = ((wide % val) << 64) | (u64)(wide / val);
+		}
+		else {
+			__int128 num = wide;
+			if (!val || (i64)val == -1) {
+				// Dividing by -1 is only done at runtime, in case of overflow
+				return 0;
+			}
+			__int128 quot = num / (i64)val;
+			if (quot != (i64)quot) {
+				return 0;
+			}
+			wide = ((unsigned __int128)(u64)(i64)(num % (i64)val) << 64) |
+				(u64)quot;
+		}
+		regs[0] = (u64)wide;
+		regs[2] = (u64)(wide >> 64);
+		return 1;
+	}
+
+	if (opdCnt < 2 && op != BA_IM_INC && op != BA_IM_DEC &&
+		op != BA_IM_NOT && op != BA_IM_NEG)
+	{
+		return 0;
+	}
+
+	u64 lhs = 0;
+	u64 rhs = 0;
+	bool isMovOnly = op == BA_IM_MOV ||
+		(op == BA_IM_IMUL && opdCnt == 3);
+	if ((!isMovOnly && !CTFEGet(ctfe, dst, size, &lhs)) ||
+		(opdCnt >= 2 && !CTFEGet(ctfe, src, size, &rhs)))
+	{
+		return 0;
+	}
+
+	u64 res = 0;
+	bool isWrite = op != BA_IM_CMP && op != BA_IM_TEST;
+	switch (op) {
+		case BA_IM_MOV:
+			res = rhs;
+			break;
+		case BA_IM_ADD:
+		case BA_IM_INC:
+			(op == BA_IM_INC) && (rhs = 1);
+			res = (lhs + rhs) & mask;
+			(op == BA_IM_ADD) && (ctfe->cf = res < lhs);
+			ctfe->of = !!(~(lhs ^ rhs) & (lhs ^ res) & signBit);
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		case BA_IM_SUB:
+		case BA_IM_CMP:
+		case BA_IM_DEC:
+			(op == BA_IM_DEC) && (rhs = 1);
+			res = (lhs - rhs) & mask;
+			(op != BA_IM_DEC) && (ctfe->cf = lhs < rhs);
+			ctfe->of = !!((lhs ^ rhs) & (lhs ^ res) & signBit);
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		case BA_IM_AND:
+		case BA_IM_TEST:
+		case BA_IM_OR:
+		case BA_IM_XOR:
+			res = op == BA_IM_OR ? lhs | rhs
+				: op == BA_IM_XOR ? lhs ^ rhs : lhs & rhs;
+			ctfe->cf = ctfe->of = 0;
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		case BA_IM_NOT:
+			res = ~lhs & mask;
+			break;
+		case BA_IM_NEG:
+			res = -lhs & mask;
+			ctfe->cf = !!lhs;
+			ctfe->of = lhs == signBit;
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		case BA_IM_SHL:
+		case BA_IM_SHR:
+		case BA_IM_SAR:
+		case BA_IM_ROL:
+		case BA_IM_ROR:
+		{
+			u64 cnt = rhs & 0x3f;
+			res = lhs;
+			if (!cnt) {
+				break;
+			}
+			if (op == BA_IM_SHL) {
+				res = lhs << cnt;
+				ctfe->cf = (lhs >> (64 - cnt)) & 1;
+			}
+			else if (op == BA_IM_SHR || op == BA_IM_SAR) {
+				res = op == BA_IM_SHR ? lhs >> cnt : (u64)((i64)lhs >> cnt);
+				ctfe->cf = (lhs >> (cnt - 1)) & 1;
+			}
+			else {
+				res = op == BA_IM_ROL ? (lhs << cnt) | (lhs >> (64 - cnt))
+					: (lhs >> cnt) | (lhs << (64 - cnt));
+				ctfe->cf = op == BA_IM_ROL ? res & 1 : res >> 63;
+				break;
+			}
+			ctfe->of = 0;
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		}
+		case BA_IM_IMUL:
+		{
+			u64 factor = rhs;
+			if (opdCnt == 3) {
+				if (opds[2].kind != BA_CTFE_IMM) {
+					return 0;
+				}
+				lhs = opds[2].val;
+			}
+			__int128 prod = (__int128)(i64)lhs * (i64)factor;
+			res = (u64)prod;
+			ctfe->cf = ctfe->of = prod != (i64)prod;
+			CTFESetResultFlags(ctfe, res, size);
+			break;
+		}
+		default:
+			return 0;
+	}
+
+	return !isWrite || CTFESet(ctfe, dst, size, res);
+}
+
+// ----- Calls -----
+
+/* Runs a call to func with the args in argsStk (as they are left by the
+ * parser, 0 for default args) and puts the value it returns in *valPtr.
+ * Returns 0 if the call has to be made at runtime instead. */
+bool ba_CTFECall(struct ba_Ctr* ctr, struct ba_Func* func,
+	struct ba_Stk* argsStk, u64* valPtr)
+{
+	if (!func->isDefined || func->paramStackSize || func->isCTFEOutOfFuel ||
+		argsStk->count != func->paramCnt ||
+		!ba_IsTypeInt(func->retType) || func->retType.type == BA_TYPE_PTR)
+	{
+		return 0;
+	}
+
+	// Args, first one last on the stack
+	u64 args[BA_FUNC_ARGREGCNT] = {0};
+	struct ba_FuncParam* param = func->firstParam;
+	for (u64 i = 0; i < argsStk->count; i++) {
+		struct ba_PTkStkItem* arg = argsStk->items[argsStk->count-1-i];
+		if (!param || !param->reg || !ba_IsTypeNum(param->type) ||
+			(arg && (arg->lexemeType != BA_TK_LITINT ||
+			!ba_IsTypeNum(arg->typeInfo))))
+		{
+			return 0;
+		}
+		u64 val = arg ? (u64)arg->val : (u64)param->defaultVal;
+		// Converted as ba_POpFuncCallMovArgRegs does
+		u64 argSize = arg ? ba_GetSizeOfType(arg->typeInfo) : 8;
+		(arg && param->type.type == BA_TYPE_BOOL &&
+			arg->typeInfo.type != BA_TYPE_BOOL) && (val = (bool)val);
+		(argSize < 8) && (val &= (1llu << (argSize*8))-1);
+		args[i] = val;
+		param = param->next;
+	}
+
+	bool isCounted = !!ba_StkTop(ctr->genImStk);
+	for (struct ba_CTFEResult* res = func->ctfeResults; res; res = res->next) {
+		if (!memcmp(res->args, args, sizeof(args))) {
+			isCounted && ++ctfeCachedCnt;
+			*valPtr = res->val;
+			return res->isDone;
+		}
+	}
+	if (!ctfeTotalFuel) {
+		return 0;
+	}
+
+	struct ba_CTFE* ctfe = ba_CAlloc(1, sizeof(*ctfe));
+	ctfe->ctr = ctr;
+	ctfe->labelChunks = ba_CAlloc(ctr->labelCnt + 1,
+		sizeof(*ctfe->labelChunks));
+	ctfe->labelIMs = ba_CAlloc(ctr->labelCnt + 1, sizeof(*ctfe->labelIMs));
+	ctfeStack || (ctfeStack = ba_MAlloc(BA_CTFE_STACKSIZE));
+
+	/* The caller's frame (and so the static link) is outside the stack, so
+	 * funcs that use variables of other funcs are run at runtime */
+	memset(ctfeStack + BA_CTFE_STACKSIZE - 0x100, 0, 0x100);
+	ctfe->regs[BA_IM_RSP - BA_IM_RAX] = BA_CTFE_STACKBASE + BA_CTFE_STACKSIZE;
+	param = func->firstParam;
+	for (u64 i = 0; i < argsStk->count; i++) {
+		ctfe->regs[param->reg - BA_IM_RAX] = args[i];
+		param = param->next;
+	}
+
+	CTFELoadFunc(ctfe, func);
+	u8 step = CTFEPush(ctfe, BA_CTFE_RETMARK) &&
+		CTFEJump(ctfe, func->lblStart);
+	ctfe->depth = 1;
+	u64 fuel = BA_CTFE_FUEL < ctfeTotalFuel ? BA_CTFE_FUEL : ctfeTotalFuel;
+	ctfeTotalFuel -= fuel;
+	while (step == 1 && fuel) {
+		--fuel;
+		ctfe->im = ba_IMNext(&ctfe->chunk, ctfe->im);
+		step = ctfe->im ? CTFEStep(ctfe, ctfe->im) : 0;
+	}
+	ctfeTotalFuel += fuel;
+
+	/* Callers use RAX as the func leaves it, which for narrow types may hold
+	 * more than the value, so only results that any use reads the same way
+	 * are turned into literals */
+	u64 val = ctfe->regs[0];
+	u64 maxVal = func->retType.type == BA_TYPE_BOOL ? 1
+		: func->retType.type == BA_TYPE_U8 ? 0xff
+		: func->retType.type == BA_TYPE_I8 ? 0x7f : ~0llu;
+	bool isDone = step == 2 && val <= maxVal;
+	*valPtr = val;
+
+	if (isCounted) {
+		isDone && ++ctfeCallCnt;
+		step == 1 && ++ctfeNoFuelCnt;
+		!isDone && step != 1 && ++ctfeFallbackCnt;
+	}
+
+	if (step == 1) {
+		// A func that ran out of fuel is likely to again, with other args
+		func->isCTFEOutOfFuel = 1;
+	}
+	else {
+		struct ba_CTFEResult* res = ba_ArenaAlloc(BA_ARENA_PARSE,
+			sizeof(*res));
+		memcpy(res->args, args, sizeof(args));
+		res->val = val;
+		res->isDone = isDone;
+		res->next = func->ctfeResults;
+		func->ctfeResults = res;
+	}
+
+	free(ctfe->labelChunks);
+	free(ctfe->labelIMs);
+	free(ctfe);
+	return isDone;
+}
+
+void ba_CTFEPrintStats(FILE* file) {
+	fprintf(file, "ctfe: %-13s %llu\n", "calls", ctfeCallCnt);
+	fprintf(file, "ctfe: %-13s %llu\n", "out of fuel", ctfeNoFuelCnt);
+	fprintf(file, "ctfe: %-13s %llu\n", "runtime", ctfeFallbackCnt);
+	fprintf(file, "ctfe: %-13s %llu\n", "cached", ctfeCachedCnt);
+}
@@ -0,0 +1,39 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__CTFE_H
+#define BA__CTFE_H
+
+#include "common/ctr.h"
+#include "common/func.h"
+#include "common/stack.h"
+
+/* Runs calls whose args are all literals while compiling, by interpreting
+ * the IM of the called func (and of any funcs it calls) on a stack of its
+ * own, so that the call is replaced with a literal of its result. Anything
+ * that could have an effect outside that stack, such as a syscall or a
+ * memory access outside it, as well as running out of fuel, makes the call
+ * be compiled as usual instead. Only funcs that take all their args in
+ * registers and return an integer or bool are run. */
+
+// Most IM run for one call
+#define BA_CTFE_FUEL 0x100000
+// Most IM run for all calls in the program
+#define BA_CTFE_TOTALFUEL 0x2000000
+// Size of the stack calls are run on
+#define BA_CTFE_STACKSIZE 0x40000
+// Most calls in progress at once
+#define BA_CTFE_MAXDEPTH 0x400
+
+// A call that was run, so that calls with the same args aren't run again
+struct ba_CTFEResult {
+	struct ba_CTFEResult* next;
+	u64 args[BA_FUNC_ARGREGCNT];
+	u64 val;
+	bool isDone; // 0 if the call has to be made at runtime
+};
+
+bool ba_CTFECall(struct ba_Ctr* ctr, struct ba_Func* func,
+	struct ba_Stk* argsStk, u64* valPtr);
+void ba_CTFEPrintStats(FILE* file);
+
+#endif
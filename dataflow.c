@@ -0,0 +1,317 @@
+// See LICENSE for copyright/license information
+
+#include "dataflow.h"
+
+#define BA_DF_ISGPR(val) (BA_IM_RAX <= (val) && BA_IM_R15 >= (val))
+#define BA_DF_ISGPRB(val) (BA_IM_AL <= (val) && BA_IM_R15B >= (val))
+#define BA_DF_ISJCC(op) (BA_IM_LABELJZ <= (op) && BA_IM_LABELJGE >= (op))
+#define BA_DF_ISSET(op) (BA_IM_SETS <= (op) && BA_IM_SETGE >= (op))
+#define BA_DF_ISCMOV(op) (BA_IM_CMOVZ <= (op) && BA_IM_CMOVGE >= (op))
+
+// ----- Uses of registers and flags -----
+
+// Register number of a GPR or GPRb, or -1
+i64 ba_IMRegNum(u64 val) {
+	if (BA_DF_ISGPR(val)) {
+		return val - BA_IM_RAX;
+	}
+	if (BA_DF_ISGPRB(val)) {
+		return val - BA_IM_AL;
+	}
+	return -1;
+}
+
+u8 ba_IMRegUse(struct ba_IM* im, u8 reg) {
+	u64 op = im->vals[0];
+	if (op == BA_IM_LABELCALL || op == BA_IM_RET || op == BA_IM_SYSCALL) {
+		return BA_DF_READ;
+	}
+	// Operands are label IDs, not registers
+	if (op == BA_IM_LABEL || op == BA_IM_GOTO || op == BA_IM_LABELJMP ||
+		BA_DF_ISJCC(op))
+	{
+		return BA_DF_UNUSED;
+	}
+	// Implicitly use rax and rdx
+	if ((op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV ||
+		op == BA_IM_CQO || (op == BA_IM_IMUL && im->count == 2)) && 
+		(reg == 0 || reg == 2))
+	{
+		return BA_DF_READ;
+	}
+	// Zeroing idiom
+	if (op == BA_IM_XOR && im->count == 3 && im->vals[1] == im->vals[2] &&
+		ba_IMRegNum(im->vals[1]) == reg)
+	{
+		return BA_IM_R15 >= im->vals[1] ? BA_DF_KILL : BA_DF_READ;
+	}
+
+	bool isWriteOnly = op == BA_IM_MOV || op == BA_IM_LEA ||
+		op == BA_IM_MOVZX || op == BA_IM_POP;
+	u8 use = BA_DF_UNUSED;
+	for (u64 i = 1; i < im->count; i++) {
+		u64 val = im->vals[i];
+		if (val == BA_IM_IMM) {
+			++i;
+		}
+		else if (val == BA_IM_ADR || val == BA_IM_64ADR) {
+			if (ba_IMRegNum(im->vals[i+1]) == reg) {
+				return BA_DF_READ;
+			}
+			++i;
+		}
+		else if (val == BA_IM_ADRADD || val == BA_IM_ADRSUB ||
+			val == BA_IM_64ADRADD || val == BA_IM_64ADRSUB)
+		{
+			if (ba_IMRegNum(im->vals[i+1]) == reg) {
+				return BA_DF_READ;
+			}
+			i += 2;
+		}
+		else if (val == BA_IM_ADRADDREGMUL) {
+			if (ba_IMRegNum(im->vals[i+1]) == reg ||
+				ba_IMRegNum(im->vals[i+3]) == reg)
+			{
+				return BA_DF_READ;
+			}
+			i += 3;
+		}
+		else if (ba_IMRegNum(val) == reg) {
+			// Writing only the low byte doesn't kill the register
+			if (i == 1 && isWriteOnly && BA_DF_ISGPR(val)) {
+				use = BA_DF_KILL;
+			}
+			else {
+				return BA_DF_READ;
+			}
+		}
+	}
+	return use;
+}
+
+u8 ba_IMFlagUse(struct ba_IM* im) {
+	u64 op = im->vals[0];
+	if (BA_DF_ISJCC(op) || BA_DF_ISSET(op) || BA_DF_ISCMOV(op)) {
+		return BA_DF_READ;
+	}
+	if (op == BA_IM_ADD || op == BA_IM_SUB || op == BA_IM_CMP ||
+		op == BA_IM_AND || op == BA_IM_XOR || op == BA_IM_OR ||
+		op == BA_IM_TEST || op == BA_IM_NEG || op == BA_IM_IMUL ||
+		op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV)
+	{
+		return BA_DF_KILL;
+	}
+	// Generated code never keeps flags across these
+	if (op == BA_IM_LABELCALL || op == BA_IM_RET || op == BA_IM_SYSCALL) {
+		return BA_DF_KILL;
+	}
+	// Shifting by 0 leaves the flags as they are
+	if ((op == BA_IM_SHL || op == BA_IM_SHR || op == BA_IM_SAR) &&
+		im->count >= 4 && im->vals[2] == BA_IM_IMM && (im->vals[3] & 0x3f))
+	{
+		return BA_DF_KILL;
+	}
+	return BA_DF_UNUSED;
+}
+
+// Registers and flags live before im, given those live after it
+u64 ba_DFLiveBefore(struct ba_IM* im, u64 liveAfter) {
+	u64 live = liveAfter;
+	for (u64 reg = 0; reg < 16; reg++) {
+		u8 use = ba_IMRegUse(im, reg);
+		(use == BA_DF_READ) && (live |= 1llu << reg);
+		(use == BA_DF_KILL) && (live &= ~(1llu << reg));
+	}
+	u8 use = ba_IMFlagUse(im);
+	(use == BA_DF_READ) && (live |= BA_DF_FLAGS);
+	(use == BA_DF_KILL) && (live &= ~BA_DF_FLAGS);
+	return live;
+}
+
+// ----- Control flow graph -----
+
+// Whether nothing after im runs before a jump somewhere else
+bool IsBlockEnd(struct ba_IM* im) {
+	u64 op = im->vals[0];
+	return op == BA_IM_LABELJMP || op == BA_IM_RET || BA_DF_ISJCC(op);
+}
+
+struct ba_DFGraph* ba_NewDFGraph(struct ba_Ctr* ctr) {
+	struct ba_DFGraph* graph = ba_MAlloc(sizeof(*graph));
+
+	u64 imCap = 0x400;
+	graph->ims = ba_MAlloc(imCap * sizeof(*graph->ims));
+	graph->imCnt = 0;
+	u64 blockCap = 0x100;
+	graph->blocks = ba_MAlloc(blockCap * sizeof(*graph->blocks));
+	graph->blockCnt = 0;
+	graph->labelBlocks = ba_MAlloc((ctr->labelCnt + 1) *
+		sizeof(*graph->labelBlocks));
+	for (u64 i = 0; i <= ctr->labelCnt; i++) {
+		graph->labelBlocks[i] = -1;
+	}
+	graph->entry = 0;
+
+	// Split the IM into blocks
+	bool isLeader = 1;
+	struct ba_IMChunk* chunk = ctr->startIM->first;
+	for (struct ba_IM* im = ba_IMNext(&chunk, 0); im;
+		im = ba_IMNext(&chunk, im))
+	{
+		if (!im->count) {
+			continue;
+		}
+		if (im == ctr->entryIM || im->vals[0] == BA_IM_LABEL) {
+			isLeader = 1;
+		}
+		if (isLeader) {
+			if (graph->blockCnt == blockCap) {
+				blockCap <<= 1;
+				graph->blocks = ba_Realloc(graph->blocks,
+					blockCap * sizeof(*graph->blocks));
+			}
+			graph->blocks[graph->blockCnt++] = (struct ba_DFBlock){
+				.start = graph->imCnt, .succs = { -1, -1 } };
+			(im == ctr->entryIM) && (graph->entry = graph->blockCnt - 1);
+			isLeader = 0;
+		}
+		if (im->vals[0] == BA_IM_LABEL && im->vals[1] <= ctr->labelCnt) {
+			graph->labelBlocks[im->vals[1]] = graph->blockCnt - 1;
+		}
+		if (graph->imCnt == imCap) {
+			imCap <<= 1;
+			graph->ims = ba_Realloc(graph->ims, imCap * sizeof(*graph->ims));
+		}
+		graph->ims[graph->imCnt++] = im;
+		graph->blocks[graph->blockCnt-1].end = graph->imCnt;
+		IsBlockEnd(im) && (isLeader = 1);
+	}
+
+	// Link each block to the blocks that can run after it
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		struct ba_IM* last = graph->ims[block->end-1];
+		u64 op = last->vals[0];
+		bool isFallThrough = op != BA_IM_LABELJMP && op != BA_IM_RET;
+		u64 succCnt = 0;
+		if (op == BA_IM_LABELJMP || BA_DF_ISJCC(op)) {
+			u64 label = last->vals[1];
+			block->succs[succCnt++] = label <= ctr->labelCnt ?
+				graph->labelBlocks[label] : -1;
+		}
+		if (isFallThrough && i + 1 < graph->blockCnt) {
+			block->succs[succCnt++] = i + 1;
+		}
+	}
+
+	// Find what can run, following calls as well as jumps
+	struct ba_Stk* stk = ba_NewStk();
+	graph->blockCnt && (ba_StkPush(stk, (void*)graph->entry), 1);
+	while (stk->count) {
+		struct ba_DFBlock* block = &graph->blocks[(u64)ba_StkPop(stk)];
+		if (block->isReachable) {
+			continue;
+		}
+		block->isReachable = 1;
+		for (u64 i = 0; i < 2; i++) {
+			(block->succs[i] >= 0) &&
+				ba_StkPush(stk, (void*)block->succs[i]);
+		}
+		for (u64 i = block->start; i < block->end; i++) {
+			struct ba_IM* im = graph->ims[i];
+			if (im->vals[0] == BA_IM_LABELCALL &&
+				im->vals[1] <= ctr->labelCnt &&
+				graph->labelBlocks[im->vals[1]] >= 0)
+			{
+				ba_StkPush(stk, (void*)graph->labelBlocks[im->vals[1]]);
+			}
+		}
+	}
+	ba_DelStk(stk);
+
+	return graph;
+}
+
+void ba_DelDFGraph(struct ba_DFGraph* graph) {
+	free(graph->ims);
+	free(graph->blocks);
+	free(graph->labelBlocks);
+	free(graph);
+}
+
+/* Finds the registers and flags live at the start and end of each block.
+ * Anything may be live where control leaves the graph. */
+void ba_DFLiveness(struct ba_DFGraph* graph) {
+	// What each block reads before writing, and what it kills
+	u64* uses = ba_MAlloc(graph->blockCnt * sizeof(*uses));
+	u64* kills = ba_MAlloc(graph->blockCnt * sizeof(*kills));
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		uses[i] = 0;
+		kills[i] = 0;
+		for (u64 j = block->end; j-- > block->start;) {
+			u64 live = ba_DFLiveBefore(graph->ims[j], BA_DF_ALL);
+			u64 read = ba_DFLiveBefore(graph->ims[j], 0);
+			kills[i] |= ~live & BA_DF_ALL;
+			uses[i] = read | (uses[i] & live);
+		}
+		block->liveIn = uses[i];
+		block->liveOut = 0;
+	}
+
+	bool isChanged = 1;
+	while (isChanged) {
+		isChanged = 0;
+		for (u64 i = graph->blockCnt; i-- > 0;) {
+			struct ba_DFBlock* block = &graph->blocks[i];
+			struct ba_IM* last = graph->ims[block->end-1];
+			u64 out = 0;
+			bool isExit = last->vals[0] == BA_IM_RET ||
+				(block->succs[0] < 0 && block->succs[1] < 0);
+			for (u64 j = 0; j < 2; j++) {
+				if (block->succs[j] >= 0) {
+					out |= graph->blocks[block->succs[j]].liveIn;
+				}
+				// Jumps to a label that isn't in the graph
+				else if (!j && (last->vals[0] == BA_IM_LABELJMP ||
+					BA_DF_ISJCC(last->vals[0])))
+				{
+					isExit = 1;
+				}
+			}
+			isExit && (out = BA_DF_ALL);
+			u64 in = uses[i] | (out & ~kills[i]);
+			if (out != block->liveOut || in != block->liveIn) {
+				block->liveOut = out;
+				block->liveIn = in;
+				isChanged = 1;
+			}
+		}
+	}
+
+	free(uses);
+	free(kills);
+}
+
+// Removes deleted IM, keeping ctr->entryIM on the IM it was on (or after)
+void ba_CompactIM(struct ba_Ctr* ctr) {
+	bool isEntryPending = 0;
+	for (struct ba_IMChunk* chunk = ctr->startIM->first; chunk;
+		chunk = chunk->next)
+	{
+		u64 cnt = 0;
+		for (u64 i = 0; i < chunk->cnt; i++) {
+			struct ba_IM* im = &chunk->ims[i];
+			(im == ctr->entryIM) && (isEntryPending = 1);
+			if (!im->count) {
+				continue;
+			}
+			if (isEntryPending) {
+				ctr->entryIM = &chunk->ims[cnt];
+				isEntryPending = 0;
+			}
+			chunk->ims[cnt++] = *im;
+		}
+		chunk->cnt = cnt;
+	}
+}
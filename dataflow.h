@@ -0,0 +1,52 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__DATAFLOW_H
+#define BA__DATAFLOW_H
+
+#include "common/ctr.h"
+
+/* Control flow graph and register liveness over the IM of the whole program,
+ * for passes that need to know more than what is next to an IM. Functions
+ * must already be emplaced (ba_EmplaceIM). IM with a count of 0 have been
+ * deleted by a pass and are skipped; ba_CompactIM removes them. */
+
+// How an IM uses a register or the flags
+enum {
+	BA_DF_UNUSED = 0,
+	BA_DF_READ, // Read, or partly written
+	BA_DF_KILL, // Fully written without being read
+};
+
+// Bit for the flags in liveness masks, after the bits of the 16 GPRs
+#define BA_DF_FLAGS (1llu << 16)
+#define BA_DF_ALL ((BA_DF_FLAGS << 1) - 1)
+
+struct ba_DFBlock {
+	u64 start; // Index in ims of the first IM
+	u64 end; // Index after the last IM
+	i64 succs[2]; // Blocks that can run next, or -1
+	u64 liveIn;
+	u64 liveOut;
+	bool isReachable;
+};
+
+struct ba_DFGraph {
+	struct ba_IM** ims;
+	u64 imCnt;
+	struct ba_DFBlock* blocks;
+	u64 blockCnt;
+	i64* labelBlocks; // Block that starts with each label, or -1
+	u64 entry; // Block that the program starts at
+};
+
+struct ba_DFGraph* ba_NewDFGraph(struct ba_Ctr* ctr);
+void ba_DelDFGraph(struct ba_DFGraph* graph);
+void ba_DFLiveness(struct ba_DFGraph* graph);
+u64 ba_DFLiveBefore(struct ba_IM* im, u64 liveAfter);
+
+i64 ba_IMRegNum(u64 val);
+u8 ba_IMRegUse(struct ba_IM* im, u8 reg);
+u8 ba_IMFlagUse(struct ba_IM* im);
+void ba_CompactIM(struct ba_Ctr* ctr);
+
+#endif
@@ -0,0 +1,86 @@
+// See LICENSE for copyright/license information
+
+#include "dce.h"
+#include "dataflow.h"
+
+// Most times the graph is rebuilt after removing something
+#define BA_DCE_MAXPASSES 4
+
+u64 dceUnreachableCnt = 0;
+u64 dceDeadCnt = 0;
+
+/* Whether im only writes to a register (and maybe the flags), none of which
+ * are in live */
+bool IsDeadIM(struct ba_IM* im, u64 live) {
+	u64 op = im->vals[0];
+	bool isFlagsKept = op == BA_IM_MOV || op == BA_IM_MOVZX ||
+		op == BA_IM_LEA || (BA_IM_SETS <= op && BA_IM_SETGE >= op) ||
+		(BA_IM_CMOVZ <= op && BA_IM_CMOVGE >= op);
+	if (!isFlagsKept && (live & BA_DF_FLAGS)) {
+		return 0;
+	}
+	if (op == BA_IM_CMP || op == BA_IM_TEST) {
+		return 1;
+	}
+
+	bool isOneOperand = op == BA_IM_INC || op == BA_IM_DEC ||
+		op == BA_IM_NOT || op == BA_IM_NEG ||
+		(BA_IM_SETS <= op && BA_IM_SETGE >= op);
+	bool isTwoOperand = op == BA_IM_MOV || op == BA_IM_MOVZX ||
+		op == BA_IM_LEA || op == BA_IM_ADD || op == BA_IM_SUB ||
+		op == BA_IM_AND || op == BA_IM_XOR || op == BA_IM_OR ||
+		op == BA_IM_ROL || op == BA_IM_ROR || op == BA_IM_SHL ||
+		op == BA_IM_SHR || op == BA_IM_SAR || op == BA_IM_IMUL ||
+		(BA_IM_CMOVZ <= op && BA_IM_CMOVGE >= op);
+	if (!(isOneOperand || (isTwoOperand && im->count >= 3))) {
+		return 0;
+	}
+
+	i64 reg = ba_IMRegNum(im->vals[1]);
+	return reg >= 0 && reg != BA_IM_RSP - BA_IM_RAX &&
+		reg != BA_IM_RBP - BA_IM_RAX && !(live & (1llu << reg));
+}
+
+// Returns whether anything was removed
+bool DCEPass(struct ba_Ctr* ctr) {
+	struct ba_DFGraph* graph = ba_NewDFGraph(ctr);
+	ba_DFLiveness(graph);
+
+	bool isChanged = 0;
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		if (!block->isReachable) {
+			for (u64 j = block->start; j < block->end; j++) {
+				graph->ims[j]->count = 0;
+				++dceUnreachableCnt;
+			}
+			isChanged = 1;
+			continue;
+		}
+
+		u64 live = block->liveOut;
+		for (u64 j = block->end; j-- > block->start;) {
+			struct ba_IM* im = graph->ims[j];
+			if (IsDeadIM(im, live)) {
+				im->count = 0;
+				++dceDeadCnt;
+				isChanged = 1;
+				continue;
+			}
+			live = ba_DFLiveBefore(im, live);
+		}
+	}
+
+	ba_DelDFGraph(graph);
+	return isChanged;
+}
+
+void ba_DCE(struct ba_Ctr* ctr) {
+	for (u64 pass = 0; pass < BA_DCE_MAXPASSES && DCEPass(ctr); pass++);
+	ba_CompactIM(ctr);
+}
+
+void ba_DCEPrintStats(FILE* file) {
+	fprintf(file, "dce: %-14s %llu\n", "unreachable", dceUnreachableCnt);
+	fprintf(file, "dce: %-14s %llu\n", "dead", dceDeadCnt);
+}
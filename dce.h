@@ -0,0 +1,16 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__DCE_H
+#define BA__DCE_H
+
+#include "common/ctr.h"
+
+/* Removes code that can never run (including funcs only called from such
+ * code) and instructions whose results are never used, using the liveness
+ * of registers and flags over the whole program (dataflow.c). Functions
+ * must already be emplaced (ba_EmplaceIM). */
+
+void ba_DCE(struct ba_Ctr* ctr);
+void ba_DCEPrintStats(FILE* file);
+
+#endif
@@ -30,6 +30,7 @@ syn keyword baConditional if elif else
 syn keyword baRepeat while
 syn keyword baStatement fwrite swrite break goto return include exit assert
 syn keyword baType u64 i64 u8 i8 bool void struct
+syn keyword baStorageClass inline const
 syn keyword baOperator lengthof
 
 syn match baLabel "\<[a-zA-Z_][a-zA-Z0-9_]*:"
@@ -45,6 +46,7 @@ hi def link baRepeat Repeat
 hi def link baStatement Statement
 hi def link baLabel Label
 hi def link baType Type
+hi def link baStorageClass StorageClass
 hi def link baTodo Todo
 hi def link baOperator Operator
 
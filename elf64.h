@@ -6,7 +6,7 @@
 #include "common/ctr.h"
 #include "common/options.h"
 
+void ba_EmplaceIM(struct ba_Ctr* ctr);
 u8 ba_WriteBinary(char* fileName, struct ba_Ctr* ctr);
-u8 ba_PessimalInstrSize(struct ba_IM* im);
 
 #endif
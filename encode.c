@@ -0,0 +1,436 @@
+// See LICENSE for copyright/license information
+
+#include "encode.h"
+#include "common/exitmsg.h"
+
+// Operand kinds, an operand has every kind that it fits
+#define BA_ENC_R64    0x1
+#define BA_ENC_R8     0x2
+#define BA_ENC_MEM    0x4   // Memory operand
+#define BA_ENC_MEM64  0x8   // Memory operand marked as 64 bit (64ADR...)
+#define BA_ENC_IMM    0x10  // Any immediate, truncated to the form's size
+#define BA_ENC_IMM8   0x20  // Immediate that sign extends from 8 bits
+#define BA_ENC_IMM32  0x40  // Immediate that sign extends from 32 bits
+#define BA_ENC_UIMM32 0x80  // Immediate that zero extends from 32 bits
+#define BA_ENC_ONE    0x100
+#define BA_ENC_RAX    0x200
+#define BA_ENC_AL     0x400
+#define BA_ENC_CL     0x800
+
+// Flags
+#define BA_ENC_REXW    0x1
+#define BA_ENC_SAMEREG 0x2 // Both operands are the same register
+
+// How operands are put into the instruction
+enum {
+	BA_ENC_NOMODRM = 0, // Opcode and immediate only
+	BA_ENC_OPREG,       // Register of the first operand added to the opcode
+	BA_ENC_RMREG,       // ModRM, first operand r/m and second reg
+	BA_ENC_REGRM,       // ModRM, first operand reg and second r/m
+	BA_ENC_RMEXT,       // ModRM, first operand r/m and the extension in reg
+};
+
+struct ba_EncForm {
+	u64 imOp;
+	u16 ops[3];
+	u8 flags;
+	u8 modRM;
+	u8 ext;
+	u8 immSize;
+	u8 opCodeLen;
+	u8 opCode[3];
+};
+
+struct ba_EncOperand {
+	u16 kinds;
+	u8 reg; // Register, or base register of memory
+	u8 index;
+	u8 scale; // log2 of the index factor
+	bool hasIndex;
+	i64 disp;
+	u64 imm;
+};
+
+/* ADD, OR, AND, SUB, XOR and CMP differ only by ext, which is also the
+ * opcode of the GPRb r/m, GPRb reg form over 8 */
+#define BA_ENC_ALU(imOp, ext) \
+	{ imOp, { BA_ENC_R64, BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMREG, 0, 0, \
+		1, { (ext)*8 + 1 } }, \
+	{ imOp, { BA_ENC_R64, BA_ENC_IMM8 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 1, \
+		1, { 0x83 } }, \
+	{ imOp, { BA_ENC_RAX, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_NOMODRM, 0, 4, \
+		1, { (ext)*8 + 5 } }, \
+	{ imOp, { BA_ENC_R64, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 4, \
+		1, { 0x81 } }, \
+	{ imOp, { BA_ENC_R64, BA_ENC_MEM }, BA_ENC_REXW, BA_ENC_REGRM, 0, 0, \
+		1, { (ext)*8 + 3 } }, \
+	{ imOp, { BA_ENC_MEM, BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMREG, 0, 0, \
+		1, { (ext)*8 + 1 } }, \
+	{ imOp, { BA_ENC_MEM64, BA_ENC_IMM8 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 1, \
+		1, { 0x83 } }, \
+	{ imOp, { BA_ENC_MEM64, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 4, \
+		1, { 0x81 } }, \
+	{ imOp, { BA_ENC_R8, BA_ENC_R8 }, 0, BA_ENC_RMREG, 0, 0, \
+		1, { (ext)*8 } }, \
+	{ imOp, { BA_ENC_AL, BA_ENC_IMM }, 0, BA_ENC_NOMODRM, 0, 1, \
+		1, { (ext)*8 + 4 } }, \
+	{ imOp, { BA_ENC_R8, BA_ENC_IMM }, 0, BA_ENC_RMEXT, ext, 1, \
+		1, { 0x80 } }, \
+	{ imOp, { BA_ENC_R8, BA_ENC_MEM }, 0, BA_ENC_REGRM, 0, 0, \
+		1, { (ext)*8 + 2 } }, \
+	{ imOp, { BA_ENC_MEM, BA_ENC_R8 }, 0, BA_ENC_RMREG, 0, 0, \
+		1, { (ext)*8 } }
+
+// Unary operations on GPR or 64 bit memory
+#define BA_ENC_UNARY(imOp, opCode, ext) \
+	{ imOp, { BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 0, 1, { opCode } }, \
+	{ imOp, { BA_ENC_MEM64 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 0, 1, { opCode } }
+
+#define BA_ENC_SHIFT(imOp, ext) \
+	{ imOp, { BA_ENC_R64, BA_ENC_CL }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 0, \
+		1, { 0xd3 } }, \
+	{ imOp, { BA_ENC_R64, BA_ENC_ONE }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 0, \
+		1, { 0xd1 } }, \
+	{ imOp, { BA_ENC_R64, BA_ENC_IMM8 }, BA_ENC_REXW, BA_ENC_RMEXT, ext, 1, \
+		1, { 0xc1 } }
+
+#define BA_ENC_CMOV(imOp, cc) \
+	{ imOp, { BA_ENC_R64, BA_ENC_R64 | BA_ENC_MEM }, BA_ENC_REXW, \
+		BA_ENC_REGRM, 0, 0, 2, { 0x0f, 0x40 + (cc) } }
+
+#define BA_ENC_SET(imOp, cc) \
+	{ imOp, { BA_ENC_R8 | BA_ENC_MEM }, 0, BA_ENC_RMEXT, 0, 0, \
+		2, { 0x0f, 0x90 + (cc) } }
+
+/* Instruction forms, grouped by IM opcode, shortest first within each
+ * opcode since the first one that fits is used */
+struct ba_EncForm encForms[] = {
+	{ BA_IM_NOP, { 0 }, 0, BA_ENC_NOMODRM, 0, 0, 1, { 0x90 } },
+
+	{ BA_IM_MOV, { BA_ENC_R64, BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMREG, 0, 0,
+		1, { 0x89 } },
+	{ BA_IM_MOV, { BA_ENC_R64, BA_ENC_MEM }, BA_ENC_REXW, BA_ENC_REGRM, 0, 0,
+		1, { 0x8b } },
+	// The upper half of the register is zeroed by 32 bit moves
+	{ BA_IM_MOV, { BA_ENC_R64, BA_ENC_UIMM32 }, 0, BA_ENC_OPREG, 0, 4,
+		1, { 0xb8 } },
+	{ BA_IM_MOV, { BA_ENC_R64, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_RMEXT, 0, 4,
+		1, { 0xc7 } },
+	// ba_WriteBinary relies on this being the form for MOV STATIC
+	{ BA_IM_MOV, { BA_ENC_R64, BA_ENC_IMM }, BA_ENC_REXW, BA_ENC_OPREG, 0, 8,
+		1, { 0xb8 } },
+	{ BA_IM_MOV, { BA_ENC_R8, BA_ENC_R8 }, 0, BA_ENC_RMREG, 0, 0, 1, { 0x88 } },
+	{ BA_IM_MOV, { BA_ENC_R8, BA_ENC_MEM }, 0, BA_ENC_REGRM, 0, 0, 1, { 0x8a } },
+	{ BA_IM_MOV, { BA_ENC_R8, BA_ENC_IMM }, 0, BA_ENC_OPREG, 0, 1, 1, { 0xb0 } },
+	{ BA_IM_MOV, { BA_ENC_MEM, BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMREG, 0, 0,
+		1, { 0x89 } },
+	{ BA_IM_MOV, { BA_ENC_MEM, BA_ENC_R8 }, 0, BA_ENC_RMREG, 0, 0, 1, { 0x88 } },
+	{ BA_IM_MOV, { BA_ENC_MEM64, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_RMEXT, 0, 4,
+		1, { 0xc7 } },
+
+	{ BA_IM_LEA, { BA_ENC_R64, BA_ENC_MEM }, BA_ENC_REXW, BA_ENC_REGRM, 0, 0,
+		1, { 0x8d } },
+
+	BA_ENC_ALU(BA_IM_ADD, 0),
+	BA_ENC_ALU(BA_IM_OR, 1),
+	BA_ENC_ALU(BA_IM_AND, 4),
+	BA_ENC_ALU(BA_IM_SUB, 5),
+	// Zeroing a register doesn't need REX.W
+	{ BA_IM_XOR, { BA_ENC_R64, BA_ENC_R64 }, BA_ENC_SAMEREG, BA_ENC_RMREG, 0, 0,
+		1, { 0x31 } },
+	BA_ENC_ALU(BA_IM_XOR, 6),
+	BA_ENC_ALU(BA_IM_CMP, 7),
+
+	BA_ENC_UNARY(BA_IM_INC, 0xff, 0),
+	BA_ENC_UNARY(BA_IM_DEC, 0xff, 1),
+	BA_ENC_UNARY(BA_IM_NOT, 0xf7, 2),
+	BA_ENC_UNARY(BA_IM_NEG, 0xf7, 3),
+	BA_ENC_UNARY(BA_IM_MUL, 0xf7, 4),
+	BA_ENC_UNARY(BA_IM_DIV, 0xf7, 6),
+	BA_ENC_UNARY(BA_IM_IDIV, 0xf7, 7),
+
+	{ BA_IM_TEST, { BA_ENC_R64, BA_ENC_R64 }, BA_ENC_REXW, BA_ENC_RMREG, 0, 0,
+		1, { 0x85 } },
+	{ BA_IM_TEST, { BA_ENC_RAX, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_NOMODRM,
+		0, 4, 1, { 0xa9 } },
+	{ BA_IM_TEST, { BA_ENC_R64, BA_ENC_IMM32 }, BA_ENC_REXW, BA_ENC_RMEXT, 0, 4,
+		1, { 0xf7 } },
+	{ BA_IM_TEST, { BA_ENC_R8, BA_ENC_R8 }, 0, BA_ENC_RMREG, 0, 0, 1, { 0x84 } },
+
+	BA_ENC_SHIFT(BA_IM_ROL, 0),
+	BA_ENC_SHIFT(BA_IM_ROR, 1),
+	BA_ENC_SHIFT(BA_IM_SHL, 4),
+	BA_ENC_SHIFT(BA_IM_SHR, 5),
+	BA_ENC_SHIFT(BA_IM_SAR, 7),
+
+	// One operand: rdx:rax = rax * operand
+	BA_ENC_UNARY(BA_IM_IMUL, 0xf7, 5),
+	{ BA_IM_IMUL, { BA_ENC_R64, BA_ENC_R64 | BA_ENC_MEM }, BA_ENC_REXW,
+		BA_ENC_REGRM, 0, 0, 2, { 0x0f, 0xaf } },
+	{ BA_IM_IMUL, { BA_ENC_R64, BA_ENC_R64 | BA_ENC_MEM, BA_ENC_IMM8 },
+		BA_ENC_REXW, BA_ENC_REGRM, 0, 1, 1, { 0x6b } },
+	{ BA_IM_IMUL, { BA_ENC_R64, BA_ENC_R64 | BA_ENC_MEM, BA_ENC_IMM32 },
+		BA_ENC_REXW, BA_ENC_REGRM, 0, 4, 1, { 0x69 } },
+
+	{ BA_IM_SYSCALL, { 0 }, 0, BA_ENC_NOMODRM, 0, 0, 2, { 0x0f, 0x05 } },
+	{ BA_IM_RET, { 0 }, 0, BA_ENC_NOMODRM, 0, 0, 1, { 0xc3 } },
+
+	{ BA_IM_PUSH, { BA_ENC_R64 }, 0, BA_ENC_OPREG, 0, 0, 1, { 0x50 } },
+	{ BA_IM_PUSH, { BA_ENC_IMM8 }, 0, BA_ENC_NOMODRM, 0, 1, 1, { 0x6a } },
+	{ BA_IM_PUSH, { BA_ENC_IMM32 }, 0, BA_ENC_NOMODRM, 0, 4, 1, { 0x68 } },
+	{ BA_IM_POP, { BA_ENC_R64 }, 0, BA_ENC_OPREG, 0, 0, 1, { 0x58 } },
+
+	{ BA_IM_MOVZX, { BA_ENC_R64, BA_ENC_R8 | BA_ENC_MEM }, BA_ENC_REXW,
+		BA_ENC_REGRM, 0, 0, 2, { 0x0f, 0xb6 } },
+	{ BA_IM_CQO, { 0 }, BA_ENC_REXW, BA_ENC_NOMODRM, 0, 0, 1, { 0x99 } },
+
+	BA_ENC_SET(BA_IM_SETS, 0x8),
+	BA_ENC_SET(BA_IM_SETNS, 0x9),
+	BA_ENC_SET(BA_IM_SETZ, 0x4),
+	BA_ENC_SET(BA_IM_SETNZ, 0x5),
+	BA_ENC_SET(BA_IM_SETB, 0x2),
+	BA_ENC_SET(BA_IM_SETBE, 0x6),
+	BA_ENC_SET(BA_IM_SETA, 0x7),
+	BA_ENC_SET(BA_IM_SETAE, 0x3),
+	BA_ENC_SET(BA_IM_SETL, 0xc),
+	BA_ENC_SET(BA_IM_SETLE, 0xe),
+	BA_ENC_SET(BA_IM_SETG, 0xf),
+	BA_ENC_SET(BA_IM_SETGE, 0xd),
+
+	BA_ENC_CMOV(BA_IM_CMOVZ, 0x4),
+	BA_ENC_CMOV(BA_IM_CMOVNZ, 0x5),
+	BA_ENC_CMOV(BA_IM_CMOVB, 0x2),
+	BA_ENC_CMOV(BA_IM_CMOVBE, 0x6),
+	BA_ENC_CMOV(BA_IM_CMOVA, 0x7),
+	BA_ENC_CMOV(BA_IM_CMOVAE, 0x3),
+	BA_ENC_CMOV(BA_IM_CMOVL, 0xc),
+	BA_ENC_CMOV(BA_IM_CMOVLE, 0xe),
+	BA_ENC_CMOV(BA_IM_CMOVG, 0xf),
+	BA_ENC_CMOV(BA_IM_CMOVGE, 0xd),
+};
+
+#define BA_ENC_FORMCNT (sizeof(encForms) / sizeof(*encForms))
+// IM opcodes are below this
+#define BA_ENC_IMOPCNT 0x80
+
+// Where each IM opcode's forms start in encForms, and how many there are
+u16 formStarts[BA_ENC_IMOPCNT];
+u16 formCnts[BA_ENC_IMOPCNT];
+bool isFormIdxInit = 0;
+
+void FormIdxInit() {
+	for (u64 i = BA_ENC_FORMCNT; i-- > 0;) {
+		formStarts[encForms[i].imOp] = i;
+		++formCnts[encForms[i].imOp];
+	}
+	isFormIdxInit = 1;
+}
+
+/* Reads the operand at im->vals[*idxPtr] and moves *idxPtr past it.
+ * Returns 0 if it isn't an operand that can be encoded. */
+u8 DecodeOperand(struct ba_IM* im, u64* idxPtr, struct ba_EncOperand* op) {
+	u64 idx = *idxPtr;
+	u64 val = im->vals[idx];
+	*op = (struct ba_EncOperand){ 0 };
+
+	if (BA_IM_RAX <= val && BA_IM_R15 >= val) {
+		op->reg = val - BA_IM_RAX;
+		op->kinds = BA_ENC_R64 | (val == BA_IM_RAX) * BA_ENC_RAX;
+		*idxPtr = idx + 1;
+		return 1;
+	}
+
+	if (BA_IM_AL <= val && BA_IM_R15B >= val) {
+		op->reg = val - BA_IM_AL;
+		op->kinds = BA_ENC_R8 | (val == BA_IM_AL) * BA_ENC_AL |
+			(val == BA_IM_CL) * BA_ENC_CL;
+		*idxPtr = idx + 1;
+		return 1;
+	}
+
+	u64 argCnt = 0;
+	((val == BA_IM_IMM || val == BA_IM_ADR || val == BA_IM_64ADR) &&
+		(argCnt = 1)) ||
+	((val == BA_IM_ADRADD || val == BA_IM_ADRSUB ||
+		val == BA_IM_64ADRADD || val == BA_IM_64ADRSUB) && (argCnt = 2)) ||
+	((val == BA_IM_ADRADDREGMUL) && (argCnt = 3));
+
+	if (!argCnt) {
+		return 0;
+	}
+	if (idx + argCnt >= im->count) {
+		return ba_ErrorIMArgCount(idx + argCnt + 1, im);
+	}
+	*idxPtr = idx + argCnt + 1;
+
+	if (val == BA_IM_IMM) {
+		u64 imm = im->vals[idx+1];
+		op->imm = imm;
+		op->kinds = BA_ENC_IMM |
+			((i64)imm >= -0x80 && (i64)imm < 0x80) * BA_ENC_IMM8 |
+			((i64)imm >= -(1ll << 31) && (i64)imm < (1ll << 31)) * BA_ENC_IMM32 |
+			(imm < (1llu << 32)) * BA_ENC_UIMM32 |
+			(imm == 1) * BA_ENC_ONE;
+		return 1;
+	}
+
+	u64 base = im->vals[idx+1];
+	if (!(BA_IM_RAX <= base) || !(BA_IM_R15 >= base)) {
+		return 0;
+	}
+	op->reg = base - BA_IM_RAX;
+	op->kinds = BA_ENC_MEM | (val == BA_IM_64ADR ||
+		val == BA_IM_64ADRADD || val == BA_IM_64ADRSUB) * BA_ENC_MEM64;
+
+	if (val == BA_IM_ADRADDREGMUL) {
+		u64 fact = im->vals[idx+2];
+		u64 index = im->vals[idx+3];
+		if (!(BA_IM_RAX <= index) || !(BA_IM_R15 >= index) ||
+			index == BA_IM_RSP ||
+			(fact != 1 && fact != 2 && fact != 4 && fact != 8))
+		{
+			return 0;
+		}
+		op->hasIndex = 1;
+		op->index = index - BA_IM_RAX;
+		// log2(fact)
+		op->scale = (fact >= 2) + (fact >= 4) + (fact == 8);
+	}
+	else if (argCnt == 2) {
+		u64 offset = im->vals[idx+2];
+		if (offset >= (1llu << 31)) {
+			fprintf(stderr, "Error: Effective address cannot have a more "
+				"than 32 bit offset in instruction %s\n", ba_IMToStr(im));
+			exit(1);
+		}
+		op->disp = (val == BA_IM_ADRSUB || val == BA_IM_64ADRSUB)
+			? -(i64)offset : (i64)offset;
+	}
+
+	return 1;
+}
+
+// Writes the encoding of form with operands ops to instr, returns its size
+u8 EncodeForm(u8* instr, struct ba_EncForm* form, struct ba_EncOperand* ops) {
+	u8* start = instr;
+	struct ba_EncOperand* rm = 0;
+	u8 reg = form->ext;
+	u8 opReg = 0;
+
+	(form->modRM == BA_ENC_OPREG) && (opReg = ops[0].reg);
+	if (form->modRM == BA_ENC_RMREG) {
+		rm = &ops[0];
+		reg = ops[1].reg;
+	}
+	else if (form->modRM == BA_ENC_REGRM) {
+		rm = &ops[1];
+		reg = ops[0].reg;
+	}
+	else if (form->modRM == BA_ENC_RMEXT) {
+		rm = &ops[0];
+	}
+
+	// REX
+	u8 rex = 0x40 | ((form->flags & BA_ENC_REXW) << 3) |
+		((form->modRM == BA_ENC_RMREG || form->modRM == BA_ENC_REGRM) &&
+			reg >= 8) << 2 |
+		(rm && rm->hasIndex && rm->index >= 8) << 1 |
+		((rm && rm->reg >= 8) || opReg >= 8);
+	// SPL, BPL, SIL and DIL are AH, CH, DH and BH without a REX prefix
+	bool hasRex = rex != 0x40;
+	for (u64 i = 0; i < 3; i++) {
+		hasRex |= (ops[i].kinds & BA_ENC_R8) && ops[i].reg >= 4;
+	}
+	hasRex && (*instr++ = rex);
+
+	// Opcode
+	for (u64 i = 0; i < form->opCodeLen; i++) {
+		*instr++ = form->opCode[i];
+	}
+	instr[-1] += opReg & 7;
+
+	// ModRM, SIB and displacement
+	if (rm && !(rm->kinds & BA_ENC_MEM)) {
+		*instr++ = 0xc0 | ((reg & 7) << 3) | (rm->reg & 7);
+	}
+	else if (rm) {
+		u8 base = rm->reg & 7;
+		bool hasSib = rm->hasIndex || base == 4; // RSP or R12
+		u8 dispSize = (rm->disp || base == 5) + // RBP or R13
+			(rm->disp < -0x80 || rm->disp >= 0x80) * 3;
+		*instr++ = (dispSize ? (dispSize == 1 ? 0x40 : 0x80) : 0) |
+			((reg & 7) << 3) | (hasSib ? 4 : base);
+		hasSib && (*instr++ = (rm->scale << 6) |
+			((rm->hasIndex ? rm->index & 7 : 4) << 3) | base);
+		u64 disp = rm->disp;
+		for (u64 i = 0; i < dispSize; i++) {
+			*instr++ = disp & 0xff;
+			disp >>= 8;
+		}
+	}
+
+	// Immediate, which is always the last operand
+	if (form->immSize) {
+		u64 imm = 0;
+		for (u64 i = 0; i < 3; i++) {
+			(ops[i].kinds & BA_ENC_IMM) && (imm = ops[i].imm);
+		}
+		for (u64 i = 0; i < form->immSize; i++) {
+			*instr++ = imm & 0xff;
+			imm >>= 8;
+		}
+	}
+
+	return instr - start;
+}
+
+// Encodes im to instr, returns its size
+u8 EncodeIM(u8* instr, struct ba_IM* im) {
+	(!isFormIdxInit) && (FormIdxInit(), 1);
+
+	u64 imOp = im->vals[0];
+	if (imOp >= BA_ENC_IMOPCNT || !formCnts[imOp]) {
+		fprintf(stderr, "Error: unrecognized intermediate "
+			"instruction: %#llx\n", imOp);
+		exit(1);
+	}
+
+	struct ba_EncOperand ops[3] = { 0 };
+	u64 opCnt = 0;
+	u64 idx = 1;
+	while (idx < im->count) {
+		if (opCnt >= 3 || !DecodeOperand(im, &idx, &ops[opCnt])) {
+			return ba_ErrorIMArgInvalid(im);
+		}
+		++opCnt;
+	}
+
+	struct ba_EncForm* form = &encForms[formStarts[imOp]];
+	struct ba_EncForm* formsEnd = form + formCnts[imOp];
+	for (; form < formsEnd; form++) {
+		bool isMatch = 1;
+		for (u64 i = 0; i < 3; i++) {
+			isMatch &= form->ops[i] ? (bool)(form->ops[i] & ops[i].kinds) :
+				i >= opCnt;
+		}
+		(form->flags & BA_ENC_SAMEREG) && (isMatch &= ops[0].reg == ops[1].reg);
+		if (isMatch) {
+			return EncodeForm(instr, form, ops);
+		}
+	}
+
+	return ba_ErrorIMArgInvalid(im);
+}
+
+// Appends the machine code for im to code
+u8 ba_EncodeIM(struct ba_DynArr8* code, struct ba_IM* im) {
+	(code->cnt + BA_ENC_MAXSIZE > code->cap) && ba_ResizeDynArr8(code);
+	code->cnt += EncodeIM(code->arr + code->cnt, im);
+	return 1;
+}
+
+// Size of the machine code for im
+u8 ba_EncodedSize(struct ba_IM* im) {
+	u8 instr[BA_ENC_MAXSIZE];
+	return EncodeIM(instr, im);
+}
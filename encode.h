@@ -0,0 +1,20 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__ENCODE_H
+#define BA__ENCODE_H
+
+#include "common/im.h"
+#include "common/dynarr.h"
+
+/* x86-64 encoding of IM. Each instruction form (operand kinds, opcode,
+ * REX.W, ModRM usage, immediate size) is an entry in a table in encode.c,
+ * and the first entry for an IM opcode that its operands fit is used.
+ * Jumps, calls and labels aren't encoded here (see ba_WriteBinary). */
+
+// Longest instruction that can be encoded
+#define BA_ENC_MAXSIZE 15
+
+u8 ba_EncodeIM(struct ba_DynArr8* code, struct ba_IM* im);
+u8 ba_EncodedSize(struct ba_IM* im);
+
+#endif
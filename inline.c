@@ -0,0 +1,169 @@
+// See LICENSE for copyright/license information
+
+#include "inline.h"
+#include "common/options.h"
+#include "common/reg.h"
+#include "common/symtable.h"
+
+u64 inlineCallCnt = 0;
+
+bool IsLabelOp(u64 op) {
+	return op == BA_IM_LABEL ||
+		(op >= BA_IM_LABELJMP && op <= BA_IM_LABELJGE);
+}
+
+// First IM after the prologue of func, which stores the args
+struct ba_IM* InlineBodyStart(struct ba_Func* func, struct ba_IMChunk** chunk) {
+	struct ba_IM* im = ba_IMNext(chunk, 0);
+	while (im && !(im->vals[0] == BA_IM_MOV && im->count == 3 &&
+		im->vals[1] == BA_IM_RBP && im->vals[2] == BA_IM_RSP))
+	{
+		im = ba_IMNext(chunk, im);
+	}
+	im && (im = ba_IMNext(chunk, im));
+	if (im && im->vals[0] == BA_IM_REGHINT &&
+		im->vals[1] == BA_REGHINT_SAVE)
+	{
+		im = ba_IMNext(chunk, im);
+	}
+	return im;
+}
+
+// The epilogue starts with the end label
+bool IsInlineBodyEnd(struct ba_Func* func, struct ba_IM* im) {
+	return !im || (im->vals[0] == BA_IM_LABEL && im->vals[1] == func->lblEnd);
+}
+
+/* Whether im still works when copied into another frame: it mustn't leave
+ * the func, and can only use RBP for the func's own variables */
+bool IsInlineIM(struct ba_Func* func, struct ba_IM* im) {
+	u64 op = im->vals[0];
+	// Forward gotos are only resolved once the program has been parsed
+	if (op == BA_IM_LABELCALL || op == BA_IM_RET || op == BA_IM_GOTO) {
+		return 0;
+	}
+	if (IsLabelOp(op)) {
+		return im->vals[1] >= func->lblStart &&
+			im->vals[1] < func->lblStart + func->lblCnt;
+	}
+	if (op == BA_IM_REGHINT) {
+		return im->vals[1] != BA_REGHINT_PARAM;
+	}
+
+	for (u64 i = 1; i < im->count; i++) {
+		u64 val = im->vals[i];
+		if (val == BA_IM_IMM || val == BA_IM_STATIC) {
+			++i;
+		}
+		else if (val == BA_IM_ADR || val == BA_IM_64ADR) {
+			if (im->vals[i+1] == BA_IM_RBP) {
+				return 0; // Static link
+			}
+			++i;
+		}
+		else if (val == BA_IM_ADRADD || val == BA_IM_64ADRADD) {
+			if (im->vals[i+1] == BA_IM_RBP) {
+				return 0; // Args on the stack or the func's context
+			}
+			i += 2;
+		}
+		else if (val == BA_IM_ADRSUB || val == BA_IM_64ADRSUB) {
+			i += 2;
+		}
+		else if (val == BA_IM_ADRADDREGMUL) {
+			if (im->vals[i+1] == BA_IM_RBP || im->vals[i+3] == BA_IM_RBP) {
+				return 0;
+			}
+			i += 3;
+		}
+		else if (val == BA_IM_RBP || val == BA_IM_BPL) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Called once func is fully defined
+void ba_InlineCheck(struct ba_Ctr* ctr, struct ba_Func* func) {
+	func->lblCnt = ctr->labelCnt - func->lblStart;
+	func->isInlinable = func->retType.type != BA_TYPE_ARR &&
+		!func->paramStackSize;
+
+	struct ba_IMChunk* chunk = func->im->first;
+	struct ba_IM* im = InlineBodyStart(func, &chunk);
+	for (; func->isInlinable && !IsInlineBodyEnd(func, im);
+		im = ba_IMNext(&chunk, im))
+	{
+		func->isInlinable = IsInlineIM(func, im);
+		func->inlineSize += im->vals[0] != BA_IM_REGHINT;
+	}
+	func->isInlinable &= !!im;
+}
+
+bool ba_IsInlineCall(struct ba_Func* func) {
+	return func->isInlinable && (func->isInline ||
+		(ba_GetOptLevel() >= BA_OPT_INLINELEVEL &&
+		func->inlineSize <= BA_INLINE_MAXSIZE));
+}
+
+/* Copies the body of func in place of a call to it, once its args have been
+ * put in registers. Its variables go below the caller's data and anything
+ * else the caller has on the stack, and its labels are renumbered. */
+void ba_InlineCall(struct ba_Ctr* ctr, struct ba_Func* func) {
+	if (!ba_StkTop(ctr->genImStk)) {
+		return;
+	}
+	++inlineCallCnt;
+
+	u64 frameOfst = ba_STFrameDataSize(ctr->currScope) + ctr->imStackSize;
+	u64 lblOfst = ctr->labelCnt - func->lblStart;
+	ctr->labelCnt += func->lblCnt;
+
+	struct ba_IMChunk* chunk = func->im->first;
+	for (struct ba_IM* im = InlineBodyStart(func, &chunk);
+		!IsInlineBodyEnd(func, im); im = ba_IMNext(&chunk, im))
+	{
+		struct ba_IM* newIM = ba_IMBufAdd(ctr->im);
+		*newIM = *im;
+		if (IsLabelOp(im->vals[0])) {
+			newIM->vals[1] += lblOfst;
+			continue;
+		}
+		if (im->vals[0] == BA_IM_REGHINT) {
+			continue;
+		}
+		for (u64 i = 1; i < im->count; i++) {
+			u64 val = im->vals[i];
+			if (val == BA_IM_IMM || val == BA_IM_STATIC ||
+				val == BA_IM_ADR || val == BA_IM_64ADR)
+			{
+				++i;
+			}
+			else if (val == BA_IM_ADRADD || val == BA_IM_64ADRADD) {
+				i += 2;
+			}
+			else if (val == BA_IM_ADRSUB || val == BA_IM_64ADRSUB) {
+				(im->vals[i+1] == BA_IM_RBP) &&
+					(newIM->vals[i+2] += frameOfst);
+				i += 2;
+			}
+			else if (val == BA_IM_ADRADDREGMUL) {
+				i += 3;
+			}
+		}
+	}
+
+	// Returns jump here, then the copy's variables are removed
+	ba_AddIM(ctr, 2, BA_IM_LABEL, func->lblEnd + lblOfst);
+	if (frameOfst) {
+		ba_AddIM(ctr, 5, BA_IM_LEA, BA_IM_RSP, BA_IM_ADRSUB, BA_IM_RBP,
+			frameOfst);
+	}
+	else {
+		ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+	}
+}
+
+void ba_InlinePrintStats(FILE* file) {
+	fprintf(file, "inline: %-11s %llu\n", "calls", inlineCallCnt);
+}
@@ -0,0 +1,26 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__INLINE_H
+#define BA__INLINE_H
+
+#include "common/ctr.h"
+#include "common/func.h"
+
+/* Copies the body of a func into its caller in place of a call. The copy
+ * keeps its variables in the caller's stack frame, below what the caller has
+ * on the stack, so it has no frame of its own. Only funcs that call nothing,
+ * take all their args in registers, don't return an array, don't use
+ * variables of other funcs and have no forward gotos can be inlined. Funcs
+ * declared 'inline' are inlined wherever they can be, and other small funcs
+ * are too when optimizing. */
+
+// Most IM (not counting hints) in the body of a func that is inlined
+// without being declared 'inline'
+#define BA_INLINE_MAXSIZE 0x18
+
+void ba_InlineCheck(struct ba_Ctr* ctr, struct ba_Func* func);
+bool ba_IsInlineCall(struct ba_Func* func);
+void ba_InlineCall(struct ba_Ctr* ctr, struct ba_Func* func);
+void ba_InlinePrintStats(FILE* file);
+
+#endif
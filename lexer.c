@@ -4,12 +4,21 @@
 #include "common/lexeme.h"
 #include "common/exitmsg.h"
 #include "common/format.h"
+#include "common/intern.h"
+#include "lexscan.h"
 
 /* Returns 0 if unable to read more */
-bool IncFile(u64* jPtr, char* f, FILE* srcFile) {
+bool IncFile(u64* jPtr, char* f, struct ba_LexSrc* src) {
+	if (src->isMapped) {
+		// The 0 after the end is read too, like at the end of a buffered file
+		return ++*jPtr <= src->size;
+	}
 	if (++*jPtr >= BA_FILE_BUF_SIZE) {
 		*jPtr = 0;
-		return fread(f, sizeof(char), BA_FILE_BUF_SIZE, srcFile);
+		u64 readCnt = fread(f, sizeof(char), BA_FILE_BUF_SIZE, src->file);
+		// Don't let the end of the previous read be lexed again
+		(readCnt < BA_FILE_BUF_SIZE) && (f[readCnt] = 0);
+		return readCnt;
 	}
 	return 1;
 }
@@ -51,25 +60,85 @@ u8 HexCharToNum(char c, u64 line, u64 col, char* path) {
 			"on", line, col, path);
 }
 
-u8 TryKeyword(char* buf, char* keyword, u64 lexType, struct ba_Lexeme* lex) {
-	if (!strcmp(buf, keyword)) {
-		lex->type = lexType;
-		return 1;
+// Used by KeywordType once the length and first character have matched
+#define BA_KW(kw, lexType) \
+	return memcmp(buf + 1, (kw) + 1, len - 1) ? BA_TK_IDENTIFIER : (lexType)
+
+/* Returns the keyword token type of an identifier-shaped token, or 
+ * BA_TK_IDENTIFIER if it isn't a keyword. Keywords are distinguished by 
+ * length and then first character, so at most one memcmp is done. */
+u64 KeywordType(char* buf, u64 len) {
+	switch (len) {
+		case 2:
+			switch (buf[0]) {
+				case 'i': 
+					return buf[1] == 'f' ? BA_TK_KW_IF : 
+						buf[1] == '8' ? BA_TK_KW_I8 : BA_TK_IDENTIFIER;
+				case 'u': BA_KW("u8", BA_TK_KW_U8);
+			}
+			break;
+		case 3:
+			switch (buf[0]) {
+				case 'i': BA_KW("i64", BA_TK_KW_I64);
+				case 'u': BA_KW("u64", BA_TK_KW_U64);
+			}
+			break;
+		case 4:
+			switch (buf[0]) {
+				case 'b': BA_KW("bool", BA_TK_KW_BOOL);
+				case 'e': 
+					return !memcmp(buf, "elif", 4) ? BA_TK_KW_ELIF : 
+						!memcmp(buf, "else", 4) ? BA_TK_KW_ELSE : 
+						!memcmp(buf, "exit", 4) ? BA_TK_KW_EXIT : BA_TK_IDENTIFIER;
+				case 'g': BA_KW("goto", BA_TK_KW_GOTO);
+				case 'v': BA_KW("void", BA_TK_KW_VOID);
+			}
+			break;
+		case 5:
+			switch (buf[0]) {
+				case 'w': BA_KW("while", BA_TK_KW_WHILE);
+				case 'b': BA_KW("break", BA_TK_KW_BREAK);
+				case 'c': BA_KW("const", BA_TK_KW_CONST);
+			}
+			break;
+		case 6:
+			switch (buf[0]) {
+				case 'r': BA_KW("return", BA_TK_KW_RETURN);
+				case 'a': BA_KW("assert", BA_TK_KW_ASSERT);
+				case 's': BA_KW("struct", BA_TK_KW_STRUCT);
+				case 'i': BA_KW("inline", BA_TK_KW_INLINE);
+			}
+			break;
+		case 7:
+			switch (buf[0]) {
+				case 'i': BA_KW("include", BA_TK_KW_INCLUDE);
+				case 'g': BA_KW("garbage", BA_TK_KW_GARBAGE);
+			}
+			break;
+		case 8:
+			switch (buf[0]) {
+				case 'l': BA_KW("lengthof", BA_TK_KW_LENGTHOF);
+			}
+			break;
 	}
-	return 0;
+	return BA_TK_IDENTIFIER;
 }
 
-bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr, 
-		u64* linePtr, u64* colPtr, struct ba_Lexeme* lex, bool isInFString)
+#undef BA_KW
+
+bool TokenizeWithState(struct ba_Ctr* ctr, struct ba_LexSrc* src, char* f, 
+		u64* jPtr, u64* linePtr, u64* colPtr, struct ba_Lexeme* lex, 
+		bool isInFString)
 {
 	u64 j = *jPtr;
 	u64 line = *linePtr;
 	u64 col = *colPtr;
 
-	bool willInc = 1;
-	bool willCont = 1;
+	// The outermost stream continues from where its last lexeme ended
+	bool willInc = isInFString || src->willInc;
+	bool willCont = isInFString || src->willCont;
 
-	while (!willInc || IncFile(&j, f, srcFile)) {
+	while (willCont && (!willInc || IncFile(&j, f, src))) {
 		char c = f[j];
 		lex->line = line;
 		lex->col = col;
@@ -80,12 +149,20 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			break;
 		}
 		else if (isInFString && c == '}') {
+			ba_TkBufPush(ctr->tks, lex);
 			*jPtr = ++j;
 			*linePtr = line;
 			*colPtr = ++col;
 			return 1;
 		}
 		else if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') {
+			if (src->isMapped) {
+				// Leave j on the last blank, so that it is incremented past it
+				u64 end = ba_ScanBlank(f, j, src->size);
+				col += end - j;
+				j = end - 1;
+				goto BA_LBL_LEXSKIP;
+			}
 			++col;
 			goto BA_LBL_LEXSKIP;
 		}
@@ -95,7 +172,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			goto BA_LBL_LEXSKIP;
 		}
 		else if (c == '#') {
-			IncFile(&j, f, srcFile) || ErrorEOF();
+			IncFile(&j, f, src) || ErrorEOF();
 			++col;
 			bool isMultiLine = 0;
 			if (f[j] == '{') {
@@ -106,14 +183,25 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 				willInc = 0;
 			}
 
-			while (!willInc || IncFile(&j, f, srcFile)) {
+			while (!willInc || IncFile(&j, f, src)) {
 				willInc = 1;
+				if (src->isMapped) {
+					// Skip to the next character that could end the comment
+					u64 end = isMultiLine ? 
+						ba_ScanFor(f, j, src->size, '#', '#', '\n') : 
+						ba_ScanFor(f, j, src->size, '\n', '\n', '\n');
+					col += end - j;
+					j = end;
+					if (j >= src->size) {
+						break;
+					}
+				}
 				if (f[j] == '\n') {
 					++line;
 					col = 1;
 				}
 				if (f[j] == '#' && isMultiLine) {
-					IncFile(&j, f, srcFile) || ErrorEOF();
+					IncFile(&j, f, src) || ErrorEOF();
 					++col;
 					if (f[j] == '}') {
 						++col;
@@ -132,10 +220,10 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			ErrorEOF();
 		}
 		else if (c == '>') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '>' && willCont) {
-				willCont = IncFile(&j, f, srcFile);
+				willCont = IncFile(&j, f, src);
 				++col;
 				if (f[j] == '=') {
 					lex->type = BA_TK_RSHIFTEQ;
@@ -156,10 +244,10 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '<') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '<' && willCont) {
-				willCont = IncFile(&j, f, srcFile);
+				willCont = IncFile(&j, f, src);
 				++col;
 				if (f[j] == '=') {
 					lex->type = BA_TK_LSHIFTEQ;
@@ -180,10 +268,10 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '/') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '/' && willCont) {
-				willCont = IncFile(&j, f, srcFile);
+				willCont = IncFile(&j, f, src);
 				++col;
 				if (f[j] == '=' && willCont) {
 					lex->type = BA_TK_IDIVEQ;
@@ -204,7 +292,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '&') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '&' && willCont) {
 				lex->type = BA_TK_LOGAND;
@@ -220,7 +308,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '^') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '=' && willCont) {
 				lex->type = BA_TK_BITXOREQ;
@@ -232,7 +320,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '|') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '|' && willCont) {
 				lex->type = BA_TK_LOGOR;
@@ -248,7 +336,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '=') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '=' && willCont) {
 				lex->type = BA_TK_DBEQUAL;
@@ -260,7 +348,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '!') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '=' && willCont) {
 				lex->type = BA_TK_NEQUAL;
@@ -272,7 +360,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '+') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if ((f[j] == '=' || f[j] == '+') && willCont) {
 				lex->type = (f[j] == '=') ? BA_TK_ADDEQ : BA_TK_INC;
@@ -284,7 +372,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '-') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if ((f[j] == '=' || f[j] == '-') && willCont) {
 				lex->type = (f[j] == '=') ? BA_TK_SUBEQ : BA_TK_DEC;
@@ -296,7 +384,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '*') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '=' && willCont) {
 				lex->type = BA_TK_MULEQ;
@@ -308,7 +396,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 		}
 		else if (c == '%') {
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			if (f[j] == '=' && willCont) {
 				lex->type = BA_TK_MODEQ;
@@ -327,18 +415,35 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			++col;
 		}
 		else if (c == '"') {
-			char* buf = ba_CAlloc(BA_LITERAL_SIZE + 1, sizeof(char));
+			char buf[BA_LITERAL_SIZE + 1];
 			char* bufCurr = buf;
 			++col;
-			while (!willInc || IncFile(&j, f, srcFile)) {
-				c = f[j];
+			while (!willInc || IncFile(&j, f, src)) {
 				willInc = 1;
+				if (src->isMapped) {
+					// Copy everything up to the next special character at once
+					u64 end = ba_ScanFor(f, j, src->size, '"', '\\', '\n');
+					u64 len = bufCurr - buf;
+					if (len + end - j > BA_LITERAL_SIZE) {
+						return ba_ErrorTknOverflow("string literal", line, 
+							col + BA_LITERAL_SIZE - len + 1, src->path, 
+							BA_LITERAL_SIZE);
+					}
+					memcpy(bufCurr, f + j, end - j);
+					bufCurr += end - j;
+					col += end - j;
+					j = end;
+					if (j >= src->size) {
+						break;
+					}
+				}
+				c = f[j];
 				if (c == '"') {
 					++col;
 					break;
 				}
 				if (c == '\\') {
-					IncFile(&j, f, srcFile) || ErrorEOF();
+					IncFile(&j, f, src) || ErrorEOF();
 					++col;
 					c = CharEscape(f[j]);
 					if (c == -1) {
@@ -348,12 +453,12 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 							goto BA_LBL_STRSKIP;
 						}
 						else if (f[j] == 'x') {
-							IncFile(&j, f, srcFile) || ErrorEOF();
+							IncFile(&j, f, src) || ErrorEOF();
 							++col;
-							c = HexCharToNum(f[j], line, col, ctr->currPath) << 4;
-							IncFile(&j, f, srcFile) || ErrorEOF();
+							c = HexCharToNum(f[j], line, col, src->path) << 4;
+							IncFile(&j, f, src) || ErrorEOF();
 							++col;
-							c += HexCharToNum(f[j], line, col, ctr->currPath);
+							c += HexCharToNum(f[j], line, col, src->path);
 						}
 						else {
 							c = '\\';
@@ -375,20 +480,21 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 				++bufCurr;
 				if (bufCurr - buf > BA_LITERAL_SIZE) {
 					return ba_ErrorTknOverflow("string literal", line, col, 
-							ctr->currPath, BA_LITERAL_SIZE);
+							src->path, BA_LITERAL_SIZE);
 				}
 				BA_LBL_STRSKIP:;
 			}
 			lex->type = BA_TK_LITSTR;
-			lex->val = buf;
 			lex->valLen = bufCurr - buf;
+			lex->val = ba_ArenaAlloc(BA_ARENA_LEX, lex->valLen + 1);
+			memcpy(lex->val, buf, lex->valLen);
 		}
 		else if (c >= '0' && c <= '9') {
-			char* buf = ba_CAlloc(BA_LITERAL_SIZE + 1, sizeof(char));
+			char buf[BA_LITERAL_SIZE + 1];
 			char* bufCurr = buf;
 			u64 base = 10;
 
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			col += 2;
 			*bufCurr = c;
 			++bufCurr;
@@ -419,7 +525,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 				}
 			}
 			
-			while (!willInc || IncFile(&j, f, srcFile)) {
+			while (!willInc || IncFile(&j, f, src)) {
 				c = f[j];
 				willInc = 1;
 				++col;
@@ -432,7 +538,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 					(c >= 'A' && c <= 'F' && base < 16) || 
 					(buf == bufCurr && (c == 'u' || c == 'U'))) 
 				{
-					return ba_ErrorIntLitChar(line, col, ctr->currPath);
+					return ba_ErrorIntLitChar(line, col, src->path);
 				}
 				else if (c == 'u' || c == 'U') {
 					*bufCurr = 'u';
@@ -450,34 +556,35 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 				++bufCurr;
 				if (bufCurr - buf > BA_LITERAL_SIZE) {
 					return ba_ErrorTknOverflow("integer literal", line, col, 
-							ctr->currPath, BA_LITERAL_SIZE);
+							src->path, BA_LITERAL_SIZE);
 				}
 				BA_LBL_INTSKIP:;
 			}
 			lex->type = BA_TK_LITINT;
-			lex->val = buf;
 			lex->valLen = bufCurr - buf;
+			lex->val = ba_ArenaAlloc(BA_ARENA_LEX, lex->valLen + 1);
+			memcpy(lex->val, buf, lex->valLen);
 		}
 		else if (c == '\'') {
-			IncFile(&j, f, srcFile) || ErrorEOF();
+			IncFile(&j, f, src) || ErrorEOF();
 			++col;
 			c = f[j];
-			(c == '\'') && ba_ErrorCharLit(line, col, ctr->currPath);
+			(c == '\'') && ba_ErrorCharLit(line, col, src->path);
 			if (c == '\\') {
-				IncFile(&j, f, srcFile) || ErrorEOF();
+				IncFile(&j, f, src) || ErrorEOF();
 				++col;
 				c = CharEscape(f[j]);
 				if (c == -1) {
 					if (f[j] == '\n') {
-						ba_ErrorCharLit(line, col, ctr->currPath);
+						ba_ErrorCharLit(line, col, src->path);
 					}
 					else if (f[j] == 'x') {
-						IncFile(&j, f, srcFile) || ErrorEOF();
+						IncFile(&j, f, src) || ErrorEOF();
 						++col;
-						c = HexCharToNum(f[j], line, col, ctr->currPath);
-						IncFile(&j, f, srcFile) || ErrorEOF();
+						c = HexCharToNum(f[j], line, col, src->path);
+						IncFile(&j, f, src) || ErrorEOF();
 						++col;
-						c += HexCharToNum(f[j], line, col, ctr->currPath) << 4;
+						c += HexCharToNum(f[j], line, col, src->path) << 4;
 					}
 					else {
 						c = '\\';
@@ -495,29 +602,32 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			else {
 				++col;
 			}
-			IncFile(&j, f, srcFile) || ErrorEOF();
-			(f[j] != '\'') && ba_ErrorCharLit(line, col, ctr->currPath);
+			IncFile(&j, f, src) || ErrorEOF();
+			(f[j] != '\'') && ba_ErrorCharLit(line, col, src->path);
 			++col;
 			lex->type = BA_TK_LITCHAR;
 			lex->val = (void*)(u64)c;
 		}
 		else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
-			char* buf = ba_CAlloc(BA_IDENTIFIER_SIZE + 1, sizeof(char));
+			char buf[BA_IDENTIFIER_SIZE + 1];
 			char* bufCurr = buf;
-			willCont = IncFile(&j, f, srcFile);
+			willCont = IncFile(&j, f, src);
 			++col;
 			
 			if ((c == 'f' || c == 'F') && f[j] == '"' && willCont) {
 				// Formatted strings
-				free(buf);
 				++col;
 
+				// Reserved before the expressions' lexemes are added
+				lex->type = BA_TK_FSTRING;
+				u64 fstrIdx = ba_TkBufPush(ctr->tks, lex);
+
 				struct ba_FStr* fstrFirst = ba_MAlloc(sizeof(*fstrFirst));
 				struct ba_FStr* fstr = fstrFirst;
 				char autoBuf[BA_LITERAL_SIZE] = {0};
 				bufCurr = autoBuf;
 
-				while (!willInc || IncFile(&j, f, srcFile)) {
+				while (!willInc || IncFile(&j, f, src)) {
 					c = f[j];
 					willInc = 1;
 					if (c == '"') {
@@ -530,7 +640,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 						break;
 					}
 					if (c == '\\') {
-						IncFile(&j, f, srcFile) || ErrorEOF();
+						IncFile(&j, f, src) || ErrorEOF();
 						++col;
 						c = CharEscape(f[j]);
 						if (c == -1) {
@@ -540,12 +650,12 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 								goto BA_LBL_FSTRSKIP;
 							}
 							else if (f[j] == 'x') {
-								IncFile(&j, f, srcFile) || ErrorEOF();
+								IncFile(&j, f, src) || ErrorEOF();
 								++col;
-								c = HexCharToNum(f[j], line, col, ctr->currPath);
-								IncFile(&j, f, srcFile) || ErrorEOF();
+								c = HexCharToNum(f[j], line, col, src->path);
+								IncFile(&j, f, src) || ErrorEOF();
 								++col;
-								c += HexCharToNum(f[j], line, col, ctr->currPath) << 4;
+								c += HexCharToNum(f[j], line, col, src->path) << 4;
 							}
 							else {
 								c = '\\';
@@ -565,7 +675,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 							memcpy(fstr->val, autoBuf, fstr->len);
 							fstr = fstr->next;
 						}
-						IncFile(&j, f, srcFile) || ErrorEOF();
+						IncFile(&j, f, src) || ErrorEOF();
 						col += 2;
 						if (f[j] == '%') {
 							c = '%';
@@ -597,26 +707,27 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 								          willInc = 0;
 													goto BA_LBL_FSTREPILOGUE;
 							}
-							IncFile(&j, f, srcFile) || ErrorEOF();
+							IncFile(&j, f, src) || ErrorEOF();
 							col += 2;
 							(f[j] != '{') &&
-								ba_ErrorFString(line, col, ctr->currPath, ", expected '{'");
+								ba_ErrorFString(line, col, src->path, ", expected '{'");
 
+							struct ba_Lexeme fstrLex = {0};
 							if (fstr->formatType == BA_FTYPE_STR) {
-								struct ba_Lexeme* fstrLen = ba_MAlloc(sizeof(*fstrLen));
-								if (!TokenizeWithState(ctr, srcFile, f, &j, &line, &col, 
-									fstrLen, /* isInFString = */ 1))
+								fstr->len = ctr->tks->cnt;
+								if (!TokenizeWithState(ctr, src, f, &j, &line, &col, 
+									&fstrLex, /* isInFString = */ 1))
 								{
 									return 0;
 								}
-								fstr->len = (u64)fstrLen;
+								fstrLex = (struct ba_Lexeme){0};
 								(f[j] != '{') &&
-									ba_ErrorFString(line, col, ctr->currPath, ", expected '{'");
+									ba_ErrorFString(line, col, src->path, ", expected '{'");
 							}
 							
-							fstr->val = ba_MAlloc(sizeof(struct ba_Lexeme));
-							if (!TokenizeWithState(ctr, srcFile, f, &j, &line, &col, 
-								fstr->val, /* isInFString = */ 1))
+							fstr->val = (void*)ctr->tks->cnt;
+							if (!TokenizeWithState(ctr, src, f, &j, &line, &col, 
+								&fstrLex, /* isInFString = */ 1))
 							{
 								return 0;
 							}
@@ -650,11 +761,11 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 					BA_LBL_FSTRSKIP:;
 				}
 
-				lex->type = BA_TK_FSTRING;
-				lex->val = (void*)fstrFirst;
-				lex->next = ba_NewLexeme();
-				lex = lex->next;
-				goto BA_LBL_LEXSKIP;
+				u64 fstrSlot = BA_TK_SLOT(ctr->tks, fstrIdx);
+				ctr->tks->vals[fstrSlot] = (void*)fstrFirst;
+				ctr->tks->valLens[fstrSlot] = ctr->tks->cnt;
+				*lex = (struct ba_Lexeme){0};
+				goto BA_LBL_LEXPUSHED;
 			}
 			
 			++col;
@@ -672,7 +783,7 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			}
 
 			// Identifiers and keywords
-			while (!willInc || IncFile(&j, f, srcFile)) {
+			while (!willInc || IncFile(&j, f, src)) {
 				willInc = 1;
 				if (!(f[j] >= 'a' && f[j] <= 'z') && !(f[j] >= 'A' && f[j] <= 'Z') && 
 					!(f[j] >= '0' && f[j] <= '9') && f[j] != '_')
@@ -685,46 +796,33 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 				++bufCurr;
 				if (bufCurr - buf > BA_IDENTIFIER_SIZE) {
 					return ba_ErrorTknOverflow("identifier", line, col, 
-							ctr->currPath, BA_IDENTIFIER_SIZE);
+							src->path, BA_IDENTIFIER_SIZE);
 				}
 			}
 
-			bool isKeyword = 
-				TryKeyword(buf, "if", BA_TK_KW_IF, lex) || 
-				TryKeyword(buf, "i8", BA_TK_KW_I8, lex) || 
-				TryKeyword(buf, "u8", BA_TK_KW_U8, lex) || 
-				TryKeyword(buf, "i64", BA_TK_KW_I64, lex) || 
-				TryKeyword(buf, "u64", BA_TK_KW_U64, lex) || 
-				TryKeyword(buf, "bool", BA_TK_KW_BOOL, lex) ||
-				TryKeyword(buf, "elif", BA_TK_KW_ELIF, lex) || 
-				TryKeyword(buf, "else", BA_TK_KW_ELSE, lex) || 
-				TryKeyword(buf, "exit", BA_TK_KW_EXIT, lex) || 
-				TryKeyword(buf, "goto", BA_TK_KW_GOTO, lex) || 
-				TryKeyword(buf, "void", BA_TK_KW_VOID, lex) ||
-				TryKeyword(buf, "while", BA_TK_KW_WHILE, lex) || 
-				TryKeyword(buf, "break", BA_TK_KW_BREAK, lex) || 
-				TryKeyword(buf, "return", BA_TK_KW_RETURN, lex) || 
-				TryKeyword(buf, "assert", BA_TK_KW_ASSERT, lex) || 
-				TryKeyword(buf, "struct", BA_TK_KW_STRUCT, lex) ||
-				TryKeyword(buf, "include", BA_TK_KW_INCLUDE, lex) || 
-				TryKeyword(buf, "garbage", BA_TK_KW_GARBAGE, lex) || 
-				TryKeyword(buf, "lengthof", BA_TK_KW_LENGTHOF, lex);
-
-			if (isKeyword) {
-				free(buf);
-			}
-			else {
-				lex->type = BA_TK_IDENTIFIER;
-				lex->val = buf;
-				lex->valLen = bufCurr - buf;
-			}
+			*bufCurr = 0;
+			lex->type = KeywordType(buf, bufCurr - buf);
+			lex->valLen = bufCurr - buf;
+			lex->val = ba_InternLen(buf, lex->valLen);
 		}
 		else {
-			ba_ExitMsg(BA_EXIT_ERR, "invalid character on", line, col, ctr->currPath);
+			ba_ExitMsg(BA_EXIT_ERR, "invalid character on", line, col, src->path);
 		}
 
-		lex->next = ba_NewLexeme();
-		lex = lex->next;
+		ba_TkBufPush(ctr->tks, lex);
+		*lex = (struct ba_Lexeme){0};
+
+		BA_LBL_LEXPUSHED:
+
+		// The outermost stream is lexed one lexeme at a time
+		if (!isInFString) {
+			*jPtr = j;
+			*linePtr = line;
+			*colPtr = col;
+			src->willInc = willInc;
+			src->willCont = willCont;
+			return 1;
+		}
 		
 		BA_LBL_LEXSKIP:
 
@@ -732,17 +830,104 @@ bool TokenizeWithState(struct ba_Ctr* ctr, FILE* srcFile, char* f, u64* jPtr,
 			break;
 		}
 	}
+	// End of the stream
+	ba_TkBufPush(ctr->tks, lex);
+	src->isDone = !isInFString;
 	return !isInFString;
 }
 
-/* Returns 0 on error and 1 on success. */
-bool ba_Tokenize(struct ba_Ctr* ctr, FILE* srcFile) {
-	char f[BA_FILE_BUF_SIZE] = {0}; // File buffer
-	u64 j = BA_FILE_BUF_SIZE - 1; // File buffer iterator
-	u64 line = 1;
-	u64 col = 1;
-	struct ba_Lexeme* lex = ctr->lex;
-	return TokenizeWithState(ctr, srcFile, f, &j, &line, &col, lex, 
-		/* isInFString = */ 0);
+/* Maps a regular file into memory followed by at least one 0 byte, so that 
+ * it can be lexed without copying. Returns 0 if it can't be mapped. */
+char* MapSrcFile(FILE* srcFile, u64* sizePtr) {
+	struct stat srcStat;
+	if (fstat(fileno(srcFile), &srcStat) || !S_ISREG(srcStat.st_mode) || 
+		!srcStat.st_size)
+	{
+		return 0;
+	}
+	*sizePtr = srcStat.st_size;
+
+	// Reserve zeroed memory one byte longer than the file, then map the file 
+	// over the start of it
+	char* f = mmap(0, *sizePtr + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, 
+		-1, 0);
+	if (f == MAP_FAILED) {
+		return 0;
+	}
+	if (mmap(f, *sizePtr, PROT_READ, MAP_PRIVATE | MAP_FIXED, 
+		fileno(srcFile), 0) == MAP_FAILED) 
+	{
+		munmap(f, *sizePtr + 1);
+		return 0;
+	}
+	return f;
 }
 
+/* Lexes the next lexeme of the current source file. An included file's 
+ * BA_TK_EOF becomes a BA_TK_FILECHANGE back to the file that included it, 
+ * which takes the position of that file's next lexeme. */
+void LexNext(struct ba_Ctr* ctr) {
+	struct ba_LexSrc* src = ctr->lexSrc;
+	struct ba_Lexeme lex = {0};
+	if (!src) {
+		// Past the end of the main file
+		ba_TkBufPush(ctr->tks, &lex);
+		return;
+	}
+	if (!TokenizeWithState(ctr, src, src->f, &src->j, &src->line, &src->col, 
+		&lex, /* isInFString = */ 0))
+	{
+		exit(1);
+	}
+	if (!src->isDone) {
+		return;
+	}
+
+	if (src->isMapped) {
+		munmap(src->f, src->size + 1);
+	}
+	else {
+		free(src->f);
+	}
+	fclose(src->file);
+	ctr->lexSrc = src->prev;
+	if (src->prev) {
+		u64 idx = ctr->tks->cnt - 1;
+		LexNext(ctr);
+		u64 slot = BA_TK_SLOT(ctr->tks, idx);
+		ctr->tks->types[slot] = BA_TK_FILECHANGE;
+		ctr->tks->lineCols[slot] = 
+			ctr->tks->lineCols[BA_TK_SLOT(ctr->tks, idx + 1)];
+		ctr->tks->vals[slot] = src->prev->path;
+		ctr->tks->valLens[slot] = idx + 1;
+	}
+	free(src);
+}
+
+/* Starts lexing a file from the next lexeme on. The file is closed once all 
+ * of it has been lexed, and the current source file (if any) is continued. */
+void ba_LexPushFile(struct ba_Ctr* ctr, FILE* file, char* path) {
+	struct ba_LexSrc* src = ba_MAlloc(sizeof(*src));
+	*src = (struct ba_LexSrc){ .file = file, .line = 1, .col = 1, 
+		.willInc = 1, .willCont = 1, .path = path, .prev = ctr->lexSrc };
+
+	// Regular files are lexed in place
+	src->f = MapSrcFile(file, &src->size);
+	if (src->f) {
+		src->isMapped = 1;
+		src->j = -1; // Incremented to 0 before the first read
+	}
+	// Anything else, such as stdin or a pipe, is read through a buffer
+	else {
+		src->f = ba_CAlloc(BA_FILE_BUF_SIZE, 1);
+		src->j = BA_FILE_BUF_SIZE - 1;
+	}
+	ctr->lexSrc = src;
+}
+
+// Lexes until the lexeme at idx exists
+void ba_LexUpTo(struct ba_Ctr* ctr, u64 idx) {
+	while (idx >= ctr->tks->cnt) {
+		LexNext(ctr);
+	}
+}
@@ -5,7 +5,26 @@
 
 #include "common/common.h"
 #include "common/ctr.h"
+#include "sys/mman.h"
 
-bool ba_Tokenize(struct ba_Ctr* ctr, FILE* srcFile);
+// Source file being lexed
+struct ba_LexSrc {
+	FILE* file;
+	bool isMapped; // Otherwise the file is read through a buffer
+	u64 size; // Size of the mapped source
+	char* f; // Mapped source or file buffer
+	u64 j; // Position in f
+	u64 line;
+	u64 col;
+	// Where lexing left off after the last lexeme
+	bool willInc;
+	bool willCont;
+	bool isDone;
+	char* path;
+	struct ba_LexSrc* prev; // Source that included this one
+};
+
+void ba_LexPushFile(struct ba_Ctr* ctr, FILE* file, char* path);
+void ba_LexUpTo(struct ba_Ctr* ctr, u64 idx);
 
 #endif
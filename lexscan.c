@@ -0,0 +1,134 @@
+// See LICENSE for copyright/license information
+
+#include "lexscan.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Spaces and tabs etc., but not newlines, which the lexer has to count
+#define BA_ISBLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\v' || \
+	(c) == '\f' || (c) == '\r')
+
+u64 ScanForScalar(char* f, u64 i, u64 size, char a, char b, char c) {
+	while (i < size && f[i] != a && f[i] != b && f[i] != c) {
+		++i;
+	}
+	return i;
+}
+
+u64 ScanBlankScalar(char* f, u64 i, u64 size) {
+	while (i < size && BA_ISBLANK(f[i])) {
+		++i;
+	}
+	return i;
+}
+
+#if defined(__x86_64__)
+
+// Vector loops only load whole vectors that are inside f[0..size)
+
+u64 ScanForSSE2(char* f, u64 i, u64 size, char a, char b, char c) {
+	__m128i va = _mm_set1_epi8(a);
+	__m128i vb = _mm_set1_epi8(b);
+	__m128i vc = _mm_set1_epi8(c);
+	for (; i + 16 <= size; i += 16) {
+		__m128i x = _mm_loadu_si128((__m128i*)(f + i));
+		__m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), 
+			_mm_cmpeq_epi8(x, vb)), _mm_cmpeq_epi8(x, vc));
+		u64 mask = _mm_movemask_epi8(eq);
+		if (mask) {
+			return i + __builtin_ctzll(mask);
+		}
+	}
+	return ScanForScalar(f, i, size, a, b, c);
+}
+
+u64 ScanBlankSSE2(char* f, u64 i, u64 size) {
+	__m128i space = _mm_set1_epi8(' ');
+	__m128i newline = _mm_set1_epi8('\n');
+	__m128i tab = _mm_set1_epi8('\t');
+	__m128i four = _mm_set1_epi8(4);
+	for (; i + 16 <= size; i += 16) {
+		__m128i x = _mm_loadu_si128((__m128i*)(f + i));
+		// '\t' to '\r' is 9 to 13, so x-9 is at most 4 for those
+		__m128i ofst = _mm_sub_epi8(x, tab);
+		__m128i isCtrl = _mm_cmpeq_epi8(_mm_min_epu8(ofst, four), ofst);
+		__m128i isBlank = _mm_or_si128(_mm_cmpeq_epi8(x, space), 
+			_mm_andnot_si128(_mm_cmpeq_epi8(x, newline), isCtrl));
+		u64 mask = _mm_movemask_epi8(isBlank) ^ 0xffff;
+		if (mask) {
+			return i + __builtin_ctzll(mask);
+		}
+	}
+	return ScanBlankScalar(f, i, size);
+}
+
+__attribute__((target("avx2")))
+u64 ScanForAVX2(char* f, u64 i, u64 size, char a, char b, char c) {
+	__m256i va = _mm256_set1_epi8(a);
+	__m256i vb = _mm256_set1_epi8(b);
+	__m256i vc = _mm256_set1_epi8(c);
+	for (; i + 32 <= size; i += 32) {
+		__m256i x = _mm256_loadu_si256((__m256i*)(f + i));
+		__m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va), 
+			_mm256_cmpeq_epi8(x, vb)), _mm256_cmpeq_epi8(x, vc));
+		u64 mask = (u32)_mm256_movemask_epi8(eq);
+		if (mask) {
+			return i + __builtin_ctzll(mask);
+		}
+	}
+	return ScanForSSE2(f, i, size, a, b, c);
+}
+
+__attribute__((target("avx2")))
+u64 ScanBlankAVX2(char* f, u64 i, u64 size) {
+	__m256i space = _mm256_set1_epi8(' ');
+	__m256i newline = _mm256_set1_epi8('\n');
+	__m256i tab = _mm256_set1_epi8('\t');
+	__m256i four = _mm256_set1_epi8(4);
+	for (; i + 32 <= size; i += 32) {
+		__m256i x = _mm256_loadu_si256((__m256i*)(f + i));
+		__m256i ofst = _mm256_sub_epi8(x, tab);
+		__m256i isCtrl = _mm256_cmpeq_epi8(_mm256_min_epu8(ofst, four), ofst);
+		__m256i isBlank = _mm256_or_si256(_mm256_cmpeq_epi8(x, space), 
+			_mm256_andnot_si256(_mm256_cmpeq_epi8(x, newline), isCtrl));
+		u64 mask = (u32)~_mm256_movemask_epi8(isBlank);
+		if (mask) {
+			return i + __builtin_ctzll(mask);
+		}
+	}
+	return ScanBlankSSE2(f, i, size);
+}
+
+#endif
+
+u64 (*scanFor)(char* f, u64 i, u64 size, char a, char b, char c) = 0;
+u64 (*scanBlank)(char* f, u64 i, u64 size) = 0;
+
+void ScanInit() {
+	scanFor = ScanForScalar;
+	scanBlank = ScanBlankScalar;
+#if defined(__x86_64__)
+	// SSE2 is part of x86_64
+	scanFor = ScanForSSE2;
+	scanBlank = ScanBlankSSE2;
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		scanFor = ScanForAVX2;
+		scanBlank = ScanBlankAVX2;
+	}
+#endif
+}
+
+// Index of the first of a, b or c in f[i..size), or size if there is none
+u64 ba_ScanFor(char* f, u64 i, u64 size, char a, char b, char c) {
+	(!scanFor) && (ScanInit(), 1);
+	return scanFor(f, i, size, a, b, c);
+}
+
+// Index of the first byte in f[i..size) that isn't a blank, or size
+u64 ba_ScanBlank(char* f, u64 i, u64 size) {
+	(!scanBlank) && (ScanInit(), 1);
+	return scanBlank(f, i, size);
+}
@@ -0,0 +1,15 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__LEXSCAN_H
+#define BA__LEXSCAN_H
+
+#include "common/common.h"
+
+/* Scanners for skipping long runs of bytes the lexer doesn't have to look at 
+ * individually. They use AVX2 or SSE2 when available, which is checked at 
+ * runtime, and otherwise go byte by byte. */
+
+u64 ba_ScanFor(char* f, u64 i, u64 size, char a, char b, char c);
+u64 ba_ScanBlank(char* f, u64 i, u64 size);
+
+#endif
@@ -0,0 +1,66 @@
+// See LICENSE for copyright/license information
+
+#include "optimize.h"
+#include "common/options.h"
+#include "ctfe.h"
+#include "inline.h"
+#include "tailcall.h"
+#include "regalloc.h"
+#include "constprop.h"
+#include "ssa.h"
+#include "dce.h"
+#include "peephole.h"
+
+struct ba_OptPass optPasses[] = {
+	{ "ctfe",     0, 0, 0, ba_CTFEPrintStats },
+	{ "tailcall", BA_OPT_TAILCALLLEVEL, 0, 0, ba_TailCallPrintStats },
+	{ "inline",   BA_OPT_INLINELEVEL, 0, 0, ba_InlinePrintStats },
+	{ "regalloc", BA_OPT_REGVARLEVEL, 0, ba_AllocVarRegs, 0 },
+	{ "constprop", 1, 1, ba_ConstProp, ba_ConstPropPrintStats },
+	{ "ssa",      1, 1, ba_SSAOpt,   ba_SSAPrintStats },
+	{ "dce",      1, 1, ba_DCE,      ba_DCEPrintStats },
+	{ "peephole", 1, 1, ba_Peephole, ba_PeepholePrintStats },
+};
+
+#define BA_OPT_PASSCNT (sizeof(optPasses) / sizeof(*optPasses))
+
+// Size of the program before and after each pass that ran after emplacing
+u64 optPassSizes[BA_OPT_PASSCNT][2];
+
+u64 CountIM(struct ba_Ctr* ctr) {
+	u64 cnt = 0;
+	for (struct ba_IMChunk* chunk = ctr->startIM->first; chunk;
+		chunk = chunk->next)
+	{
+		cnt += chunk->cnt;
+	}
+	return cnt;
+}
+
+void ba_RunOptPasses(struct ba_Ctr* ctr, bool isAfterEmplace) {
+	for (u64 i = 0; i < BA_OPT_PASSCNT; i++) {
+		struct ba_OptPass* pass = &optPasses[i];
+		if (pass->isAfterEmplace != isAfterEmplace ||
+			pass->level > ba_GetOptLevel())
+		{
+			continue;
+		}
+		isAfterEmplace && (optPassSizes[i][0] = CountIM(ctr));
+		pass->run && (pass->run(ctr), 1);
+		isAfterEmplace && (optPassSizes[i][1] = CountIM(ctr));
+	}
+}
+
+void ba_OptPrintStats(FILE* file) {
+	for (u64 i = 0; i < BA_OPT_PASSCNT; i++) {
+		struct ba_OptPass* pass = &optPasses[i];
+		if (pass->level > ba_GetOptLevel()) {
+			continue;
+		}
+		if (pass->isAfterEmplace) {
+			fprintf(file, "%s: %llu IM -> %llu IM\n", pass->name,
+				optPassSizes[i][0], optPassSizes[i][1]);
+		}
+		pass->printStats && (pass->printStats(file), 1);
+	}
+}
@@ -0,0 +1,23 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__OPTIMIZE_H
+#define BA__OPTIMIZE_H
+
+#include "common/ctr.h"
+
+/* Runs the optimization passes enabled at the current optimization level,
+ * in order. Passes that work on the IM of each func separately run before
+ * funcs are emplaced (ba_EmplaceIM), and the rest run after. */
+
+struct ba_OptPass {
+	char* name;
+	u8 level; // Lowest optimization level the pass runs at
+	bool isAfterEmplace;
+	void (*run)(struct ba_Ctr* ctr); // 0 if done while parsing
+	void (*printStats)(FILE* file);
+};
+
+void ba_RunOptPasses(struct ba_Ctr* ctr, bool isAfterEmplace);
+void ba_OptPrintStats(FILE* file);
+
+#endif
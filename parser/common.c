@@ -2,24 +2,30 @@
 
 #include "common.h"
 
+// Moves on to the next lexeme, lexing it if it hasn't been yet
+void ba_PNext(struct ba_Ctr* ctr) {
+	ctr->lex = ba_TkNext(ctr->tks, ctr->lex);
+	ba_LexUpTo(ctr, ctr->lex);
+}
+
 u8 ba_PAccept(u64 type, struct ba_Ctr* ctr) {
-	if (!ctr->lex || ctr->lex->type != type) {
-		(ctr->lex->type == BA_TK_FILECHANGE) && (ctr->currPath = ctr->lex->val);
+	if (BA_LEX_TYPE(ctr) != type) {
+		(BA_LEX_TYPE(ctr) == BA_TK_FILECHANGE) && (ctr->currPath = BA_LEX_VAL(ctr));
 		return 0;
 	}
-	ctr->lex = ba_DelLexeme(ctr->lex);
+	ba_PNext(ctr);
 	return 1;
 }
 
 u8 ba_PExpect(u64 type, struct ba_Ctr* ctr) {
 	if (!ba_PAccept(type, ctr)) {
-		if (!ctr->lex->line) {
+		if (!BA_LEX_LINE(ctr)) {
 			fprintf(stderr, "Error: expected %s at end of file in %s\n", 
 				ba_GetLexemeStr(type), ctr->currPath);
 		}
 		else {
 			fprintf(stderr, "Error: expected %s at line %llu:%llu in %s\n",
-				ba_GetLexemeStr(type), ctr->lex->line, ctr->lex->col,
+				ba_GetLexemeStr(type), BA_LEX_LINE(ctr), BA_LEX_COL(ctr),
 				ctr->currPath);
 		}
 		exit(1);
@@ -28,25 +34,20 @@ u8 ba_PExpect(u64 type, struct ba_Ctr* ctr) {
 	return 1;
 }
 
-struct ba_Lexeme* ba_PLookAhead(u64 k, u64 type, struct ba_Ctr* ctr) {
-	struct ba_Lexeme* lex = ctr->lex;
+u8 ba_PLookAhead(u64 k, u64 type, struct ba_Ctr* ctr) {
+	u64 lex = ctr->lex;
 	while (k) {
-		if (!ctr->lex) {
-			return 0;
-		}
-		lex = ctr->lex->next;
+		lex = ba_TkNext(ctr->tks, lex);
+		ba_LexUpTo(ctr, lex);
 		--k;
 	}
-	if (!lex || lex->type != type) {
-		return 0;
-	}
-	return lex;
+	return ctr->tks->types[BA_TK_SLOT(ctr->tks, lex)] == type;
 }
 
 u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type, 
 	bool* ptrIsVoid, bool isInclIndefArr) 
 {
-	u64 lexType = ctr->lex->type;
+	u64 lexType = BA_LEX_TYPE(ctr);
 	while (ba_PAccept('*', ctr) || ba_PAccept('[', ctr)) {
 		if (lexType == '*') {
 			struct ba_Type* oldInfo = type->extraInfo;
@@ -54,7 +55,7 @@ u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type,
 			*(struct ba_Type*)type->extraInfo = 
 				(struct ba_Type){ BA_TYPE_PTR, oldInfo };
 			*ptrIsVoid = 0;
-			lexType = ctr->lex->type;
+			lexType = BA_LEX_TYPE(ctr);
 			goto BA_LBL_PARSEPTRORARRAY_END;
 		}
 
@@ -69,7 +70,7 @@ u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type,
 			if (ba_PAccept(']', ctr)) {
 				isInclIndefArr ||
 					ba_ExitMsg(BA_EXIT_ERR, "invalid usage of indefinite size "
-						"array on", ctr->lex->line, ctr->lex->col, 
+						"array on", BA_LEX_LINE(ctr), BA_LEX_COL(ctr), 
 						ctr->currPath);
 				extraInfo->cnt = 0;
 			}
@@ -77,7 +78,7 @@ u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type,
 				struct ba_PTkStkItem* expItem = ba_StkPop(ctr->pTkStk);
 				if (!ba_IsTypeInt(expItem->typeInfo) || !expItem->isConst) {
 					return ba_ExitMsg2(BA_EXIT_ERR, "invalid array size on", 
-						ctr->lex->line, ctr->lex->col, ctr->currPath, 
+						BA_LEX_LINE(ctr), BA_LEX_COL(ctr), ctr->currPath, 
 						", must be a constant integer");
 				}
 				extraInfo->cnt = (u64)expItem->val;
@@ -98,7 +99,7 @@ u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type,
 			}
 		}
 		
-		lexType = ctr->lex->type;
+		lexType = BA_LEX_TYPE(ctr);
 		BA_LBL_PARSEPTRORARRAY_END:;
 	}
 	return 1;
@@ -108,7 +109,7 @@ u8 ParsePtrOrArray(struct ba_Ctr* ctr, struct ba_Type* type,
  *             { "*" | "[" exp "]" } [ "[" "]" ]
  *           | "void" # if isInclVoid */
 u8 ba_PBaseType(struct ba_Ctr* ctr, bool isInclVoid, bool isInclIndefArr) {
-	u64 lexType = ctr->lex->type;
+	u64 lexType = BA_LEX_TYPE(ctr);
 	bool isVoid = lexType == BA_TK_KW_VOID;
 	
 	if (!ba_PAccept(BA_TK_KW_U64, ctr) && !ba_PAccept(BA_TK_KW_I64, ctr) && 
@@ -128,7 +129,7 @@ u8 ba_PBaseType(struct ba_Ctr* ctr, bool isInclVoid, bool isInclIndefArr) {
 
 	if (isVoid && !isInclVoid) {
 		return ba_ExitMsg(BA_EXIT_ERR, "invalid use of void type on", 
-			ctr->lex->line, ctr->lex->col, ctr->currPath);
+			BA_LEX_LINE(ctr), BA_LEX_COL(ctr), ctr->currPath);
 	}
 
 	ba_PTkStkPush(ctr->pTkStk, /* val = */ 0, type, /* lexType = */ 0, 
@@ -143,11 +144,11 @@ u8 ba_PIdType(struct ba_Ctr* ctr, bool isInclIndefArr) {
 	}
 
 	struct ba_STVal* id = ba_STParentFind(ctr->currScope, 
-		/* stFoundInPtr = */ 0, ctr->lex->val);
+		/* stFoundInPtr = */ 0, BA_LEX_VAL(ctr));
 	if (!id || id->type.type != BA_TYPE_TYPE) {
 		return 0;
 	}
-	ctr->lex = ba_DelLexeme(ctr->lex);
+	ba_PNext(ctr);
 
 	struct ba_Type type = id->type;
 	bool isVoid = 0; // Not used; the followin func just needs a real address
@@ -6,18 +6,19 @@
 /* atom = lit_str { lit_str } | lit_int | lit_char | identifier 
  *      | "{" exp { "," exp } [ "," ] "}" */
 u8 ba_PAtom(struct ba_Ctr* ctr) {
-	u64 lexLine = ctr->lex->line;
-	u64 lexCol = ctr->lex->col;
-	u64 lexValLen = ctr->lex->valLen;
+	u64 lexLine = BA_LEX_LINE(ctr);
+	u64 lexCol = BA_LEX_COL(ctr);
+	u64 lexValLen = BA_LEX_VALLEN(ctr);
 	char* lexVal = 0;
-	bool isLexValStr = ctr->lex->type == BA_TK_LITSTR || 
-		ctr->lex->type == BA_TK_LITINT || ctr->lex->type == BA_TK_IDENTIFIER;
+	// Identifiers are atoms, which don't need to be copied
+	bool isLexValStr = BA_LEX_TYPE(ctr) == BA_TK_LITSTR || 
+		BA_LEX_TYPE(ctr) == BA_TK_LITINT;
 	if (isLexValStr) {
 		lexVal = ba_MAlloc(lexValLen+1);
-		memcpy(lexVal, ctr->lex->val, lexValLen+1);
+		memcpy(lexVal, BA_LEX_VAL(ctr), lexValLen+1);
 	}
 	else {
-		lexVal = ctr->lex->val;
+		lexVal = BA_LEX_VAL(ctr);
 	}
 
 	// lit_str { lit_str }
@@ -28,20 +29,20 @@ u8 ba_PAtom(struct ba_Ctr* ctr) {
 		
 		// do-while prevents 1 more str literal from being consumed than needed
 		do {
-			if (ctr->lex->type != BA_TK_LITSTR) {
+			if (BA_LEX_TYPE(ctr) != BA_TK_LITSTR) {
 				break;
 			}
 			u64 oldLen = len;
-			len += ctr->lex->valLen;
+			len += BA_LEX_VALLEN(ctr);
 			
 			if (len > BA_STACK_SIZE) {
-				return ba_ExitMsg2(BA_EXIT_ERR, "string at", ctr->lex->line, 
-					ctr->lex->col, ctr->currPath, 
+				return ba_ExitMsg2(BA_EXIT_ERR, "string at", BA_LEX_LINE(ctr), 
+					BA_LEX_COL(ctr), ctr->currPath, 
 					" too large to fit on the stack");
 			}
 
 			chars = ba_Realloc(chars, len+1);
-			memcpy(chars+oldLen, ctr->lex->val, ctr->lex->valLen + 1);
+			memcpy(chars+oldLen, BA_LEX_VAL(ctr), BA_LEX_VALLEN(ctr) + 1);
 			chars[len] = 0;
 		}
 		while (ba_PAccept(BA_TK_LITSTR, ctr));
@@ -90,8 +91,15 @@ u8 ba_PAtom(struct ba_Ctr* ctr) {
 		if (!id) {
 			return ba_ErrorIdUndef(lexVal, lexLine, lexCol, ctr->currPath);
 		}
-		ba_PTkStkPush(ctr->pTkStk, (void*)id, id->type, BA_TK_IDENTIFIER, 
-			/* isLValue = */ 1, /* isConst = */ 0);
+		// Consts are used as literals of their type
+		if (id->isConst) {
+			ba_PTkStkPush(ctr->pTkStk, (void*)id->constVal, id->type, 
+				BA_TK_LITINT, /* isLValue = */ 0, /* isConst = */ 1);
+		}
+		else {
+			ba_PTkStkPush(ctr->pTkStk, (void*)id, id->type, BA_TK_IDENTIFIER, 
+				/* isLValue = */ 1, /* isConst = */ 0);
+		}
 	}
 	// "{" exp { "," exp } [ "," ] "}"
 	else if (ba_PAccept('{', ctr)) {
@@ -386,7 +394,7 @@ u8 ba_PDerefListMake(struct ba_Ctr* ctr, u64 line, u64 col) {
 	}
 	else {
 		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + deStackPos, BA_IM_RAX);
+			ba_STFrameDataSize(ctr->currScope) + deStackPos, BA_IM_RAX);
 		ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RAX);
 		ctr->imStackSize -= 8;
 		result->lexemeType = BA_TK_IMSTACK;
@@ -417,9 +425,9 @@ u8 ba_PExp(struct ba_Ctr* ctr) {
 	u64 lastPraefix = 0;
 
 	while (1) {
-		u64 lexType = ctr->lex->type;
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 lexType = BA_LEX_TYPE(ctr);
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
 		// Start of an expression or after a binary operator
 		if (!isAfterAtom) {
@@ -482,10 +490,10 @@ u8 ba_PExp(struct ba_Ctr* ctr) {
 			op->lexemeType = lexType;
 			op->syntax = 0;
 
-			u64 nextLexType = ctr->lex->type;
+			u64 nextLexType = BA_LEX_TYPE(ctr);
 
 			// Set syntax type
-			if (ctr->lex->type == ')') {
+			if (BA_LEX_TYPE(ctr) == ')') {
 				ctr->isPermitArrLit = 0;
 				if (ctr->paren <= initParen) {
 					endDueTo = 1;
@@ -494,7 +502,7 @@ u8 ba_PExp(struct ba_Ctr* ctr) {
 				op->syntax = BA_OP_POSTFIX;
 				ba_PAccept(')', ctr);
 			}
-			else if (ctr->lex->type == ']') {
+			else if (BA_LEX_TYPE(ctr) == ']') {
 				ctr->isPermitArrLit = 0;
 				if (ctr->bracket <= initBracket) {
 					endDueTo = 2;
@@ -696,8 +704,8 @@ u8 ba_PExp(struct ba_Ctr* ctr) {
 				ctr->currPath);
 		}
 
-		line = ctr->lex->line;
-		col = ctr->lex->col;
+		line = BA_LEX_LINE(ctr);
+		col = BA_LEX_COL(ctr);
 	}
 
 	BA_LBL_PEXP_END:;
@@ -715,7 +723,7 @@ u8 ba_PExp(struct ba_Ctr* ctr) {
 	}
 
 	ba_PCorrectDPtr(ctr, ba_StkTop(ctr->pTkStk)) || 
-		ba_ErrorDerefInvalid(ctr->lex->line, ctr->lex->col, ctr->currPath);
+		ba_ErrorDerefInvalid(BA_LEX_LINE(ctr), BA_LEX_COL(ctr), ctr->currPath);
 
 	if (ctr->paren || ctr->bracket) {
 		return 1;
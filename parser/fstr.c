@@ -4,12 +4,12 @@
 #include "../common/format.h"
 
 u8 ba_PFStr(struct ba_Ctr* ctr) {
-	struct ba_FStr* fstr = (void*)ctr->lex->val;
+	struct ba_FStr* fstr = (void*)BA_LEX_VAL(ctr);
 	if (!ba_PAccept(BA_TK_FSTRING, ctr)) {
 		return 0;
 	}
 	while (1) {
-		struct ba_FStr* val = (void*)ctr->lex->val;
+		struct ba_FStr* val = (void*)BA_LEX_VAL(ctr);
 		if (!ba_PAccept(BA_TK_FSTRING, ctr)) {
 			break;
 		}
@@ -1,6 +1,9 @@
 // See LICENSE for copyright/license information
 
 #include "common.h"
+#include "../ctfe.h"
+#include "../inline.h"
+#include "../tailcall.h"
 
 // Handle operations (i.e. perform operation now or generate code for it)
 u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
@@ -109,7 +112,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				// IMSTACK must be a DPTR
 				else if (arg->lexemeType == BA_TK_IMSTACK) {
 					ba_AddIM(ctr, 5, BA_IM_MOV, reg, BA_IM_ADRSUB, BA_IM_RBP, 
-						ctr->currScope->dataSize + (u64)arg->val);
+						ba_STFrameDataSize(ctr->currScope) + (u64)arg->val);
 				}
 				
 				ba_POpSetArg(ctr, arg, argReg, stackPos);
@@ -209,6 +212,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				if (arg->lexemeType == BA_TK_IDENTIFIER) {
 					bool isPopRbp = 0;
 					i64 offset = ba_CalcVarOffset(ctr, arg->val, &isPopRbp);
+					ba_AddRegHint(ctr, BA_REGHINT_ACCESS, arg->val);
 					ba_AddIM(ctr, 5, BA_IM_MOV, 
 						offset < 0 ? BA_IM_ADRSUB : BA_IM_ADRADD, BA_IM_RBP, 
 						offset < 0 ? -offset : offset, 
@@ -224,7 +228,8 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				}
 				else if (arg->lexemeType == BA_TK_IMSTACK) {
 					ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP, 
-						ctr->currScope->dataSize + (u64)arg->val, reg);
+						ba_STFrameDataSize(ctr->currScope) + (u64)arg->val, 
+						reg);
 				}
 
 				ba_POpSetArg(ctr, arg, argReg, stackPos);
@@ -465,6 +470,9 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					// Test for sign
 					bool isRhsNeg = ba_IsTypeSigned(rhs->typeInfo) && 
 						((u64)rhs->val & (1llu << (rhsSize*8-1)));
+					// Sign extend
+					isRhsNeg && rhsSize < 8 && (rhs->val = 
+						(void*)((u64)rhs->val | -(1llu << (rhsSize*8))));
 
 					if (op->lexemeType == '%') { // Modulo
 						u64 rhsAbs = isRhsNeg ? -(u64)rhs->val : (u64)rhs->val;
@@ -483,8 +491,18 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 							newRhs->typeInfo.type = BA_TYPE_U64;
 							newRhs->lexemeType = BA_TK_LITINT;
 
-							ba_POpNonLitBitShift(ctr, BA_IM_AND, lhs, newRhs, 
-								arg, /* isRhsLiteral = */ 1);
+							/* Masks that don't fit in a sign extended imm32 
+							 * are moved into a register first */
+							if (rhsAbs - 1 < (1llu << 31)) {
+								ba_POpNonLitBitShift(ctr, BA_IM_AND, lhs, 
+									newRhs, arg, /* isRhsLiteral = */ 1);
+							}
+							else {
+								ba_POpNonLitBinary(ctr, BA_IM_AND, lhs, newRhs,
+									arg, /* isLhsLiteral = */ 0, 
+									/* isRhsLiteral = */ 1, 
+									/* isShortCirc = */ 0);
+							}
 
 							if (isRhsNeg) {
 								newRhs->val = (void*)rhsAbs;
@@ -501,12 +519,11 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 						}
 					}
 					else { // Integer division
-						if (isRhsNeg) {
+						/* Other negative divisors are left to the division, 
+						 * since negating lhs would overflow for INT64_MIN */
+						if (isRhsNeg && (i64)rhs->val == -1) {
 							ba_POpNonLitUnary('-', lhs, ctr);
-							rhs->val = rhsSize == 8 
-								? (void*)(-(i64)rhs->val) 
-								: (void*)((-(i64)rhs->val) & 
-									((1llu<<(rhsSize*8))-1));
+							rhs->val = (void*)1;
 						}
 
 						if ((u64)rhs->val == 1) {
@@ -751,7 +768,8 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					}
 					else {
 						ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP, 
-							ctr->currScope->dataSize + stackPos, lhsAdjReg);
+							ba_STFrameDataSize(ctr->currScope) + stackPos, 
+							lhsAdjReg);
 					}
 				}
 
@@ -816,6 +834,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				if (lhs->lexemeType == BA_TK_IDENTIFIER) {
 					bool isPopRbp = 0;
 					i64 offset = ba_CalcVarOffset(ctr, lhs->val, &isPopRbp);
+					ba_AddRegHint(ctr, BA_REGHINT_ACCESS, lhs->val);
 					ba_AddIM(ctr, 5, BA_IM_MOV, 
 						offset < 0 ? BA_IM_ADRSUB : BA_IM_ADRADD, BA_IM_RBP, 
 						offset < 0 ? -offset : offset, lhsAdjReg);
@@ -832,7 +851,8 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					u64 tmpReg = realReg == BA_IM_RAX ? BA_IM_RCX : BA_IM_RAX;
 					ba_AddIM(ctr, 2, BA_IM_PUSH, tmpReg);
 					ba_AddIM(ctr, 5, BA_IM_MOV, tmpReg, BA_IM_ADRSUB, 
-						BA_IM_RBP, ctr->currScope->dataSize + (u64)lhs->val);
+						BA_IM_RBP, 
+						ba_STFrameDataSize(ctr->currScope) + (u64)lhs->val);
 					ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_ADR, tmpReg, realReg);
 					ba_AddIM(ctr, 2, BA_IM_POP, tmpReg);
 				}
@@ -843,7 +863,8 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				}
 				else {
 					ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP,
-						ctr->currScope->dataSize + stackPos, BA_IM_RCX);
+						ba_STFrameDataSize(ctr->currScope) + stackPos, 
+						BA_IM_RCX);
 					ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RCX);
 					ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RCX);
 					ctr->imStackSize -= 16;
@@ -915,7 +936,9 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				u64 regR = (u64)rhs->val; // Kept only if rhs is a register
 
 				ba_POpAsgnRegOrStack(ctr, lhs->lexemeType, &regL, &lhsStackPos);
-				ba_POpAsgnRegOrStack(ctr, rhs->lexemeType, &regR, 0);
+				// rhs isn't given a place on the stack, see realRegR
+				(rhs->lexemeType != BA_TK_IMREGISTER) && 
+					(regR = ba_NextIMRegister(ctr));
 				
 				/* regR is replaced with rdx normally, but if regL is 
 				 * already rdx, regR will be set to rcx. */
@@ -966,7 +989,8 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					arg->lexemeType = BA_TK_IMSTACK;
 					arg->val = (void*)ctr->imStackSize;
 					ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP,
-						ctr->currScope->dataSize + lhsStackPos, BA_IM_RAX);
+						ba_STFrameDataSize(ctr->currScope) + lhsStackPos, 
+						BA_IM_RAX);
 				}
 
 				if (handler && ba_IsLexemeCompare(handler->lexemeType)) {
@@ -1031,7 +1055,6 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					ctr->pTkStk->items[ctr->pTkStk->count-(u64)arg];
 				struct ba_Func* func = 
 					((struct ba_STVal*)funcTk->val)->type.extraInfo;
-				func->isCalled = 1;
 
 				if (funcArgsCnt < func->paramCnt) {
 					struct ba_FuncParam* param = func->firstParam;
@@ -1066,6 +1089,21 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 						op->line, op->col, ctr->currPath);
 				}
 
+				// Calls with only literal args may be run while compiling
+				u64 ctfeVal = 0;
+				if (ba_CTFECall(ctr, func, argsStk, &ctfeVal)) {
+					ba_DelStk(argsStk);
+					struct ba_PTkStkItem* retVal = 
+						ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*retVal));
+					retVal->lexemeType = BA_TK_LITINT;
+					retVal->val = (void*)ctfeVal;
+					retVal->typeInfo = func->retType;
+					retVal->isLValue = 0;
+					retVal->isConst = 1;
+					ba_StkPush(ctr->pTkStk, retVal);
+					return 2;
+				}
+
 				// If ret. type is array, allocate stack space for ret. value
 				if (func->retType.type == BA_TYPE_ARR) {
 					u64 retSz = ba_GetSizeOfType(func->retType);
@@ -1073,13 +1111,33 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					ctr->imStackSize += retSz;
 				}
 
-				// Enter a new stack frame
-				ba_UsedRegPreserve(ctr);
-				ba_StkPush(ctr->funcFrameStk, (void*)ctr->usedRegisters);
-
-				// Add arguments onto the stack
+				/* Enter a new stack frame, saving the registers that are 
+				 * needed after the call (not the args) and that the callee 
+				 * may change. rcx is used to swap rax with the return value 
+				 * when there are no free registers left after the call. */
+				u64 liveRegs = ctr->usedRegisters;
+				for (u64 i = 0; i < argsStk->count; i++) {
+					struct ba_PTkStkItem* argItem = argsStk->items[i];
+					argItem && argItem->lexemeType == BA_TK_IMREGISTER &&
+						(liveRegs &= ~ba_IMToCtrReg((u64)argItem->val));
+				}
+				u64 clobberRegs = ba_FuncClobberRegs(func);
+				// A recursive call changes nothing the func doesn't already
+				func != ctr->currScope->func && 
+					(ba_AddCallClobbers(ctr, clobberRegs), 1);
+				(liveRegs & BA_CTRREG_RAX) && (clobberRegs |= BA_CTRREG_RCX);
+				u64 savedRegs = liveRegs & clobberRegs;
+				ba_UsedRegPreserve(ctr, savedRegs);
+				ba_StkPush(ctr->funcFrameStk, (void*)liveRegs);
+				ba_StkPush(ctr->funcFrameStk, (void*)savedRegs);
+
+				/* Add arguments onto the stack, keeping the ones passed in 
+				 * registers until the rest are done */
 				struct ba_FuncParam* param = func->firstParam;
 				u64 originalImStackSize = ctr->imStackSize;
+				struct ba_PTkStkItem* regArgs[BA_FUNC_ARGREGCNT];
+				struct ba_FuncParam* regParams[BA_FUNC_ARGREGCNT];
+				u64 regArgCnt = 0;
 				while (argsStk->count) {
 					struct ba_PTkStkItem* funcArg = ba_StkPop(argsStk);
 					u64 paramSize = ba_GetSizeOfType(param->type);
@@ -1099,7 +1157,11 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 							exit(1);
 						}
 						
-						if (isParamNum) {
+						if (param->reg) {
+							regArgs[regArgCnt] = funcArg;
+							regParams[regArgCnt++] = param;
+						}
+						else if (isParamNum) {
 							u64 reg = (u64)funcArg->val;
 							if (funcArg->lexemeType != BA_TK_IMREGISTER) {
 								reg = ba_NextIMRegister(ctr);
@@ -1132,7 +1194,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 							if (reg) {
 								ba_POpFuncCallPushArgReg(ctr, reg, paramSize);
 								if (paramSize < 8) {
-									ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADR, 
+									ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_ADR, 
 										BA_IM_RSP, ba_AdjRegSize(reg, paramSize));
 								}
 								ctr->imStackSize += paramSize;
@@ -1167,14 +1229,18 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 								op->line, op->col, ctr->currPath, "with implicit "
 								"argument for parameter that has no default");
 						}
-						if (isParamNum) {
+						if (param->reg) {
+							regArgs[regArgCnt] = 0;
+							regParams[regArgCnt++] = param;
+						}
+						else if (isParamNum) {
 							u64 reg = ba_NextIMRegister(ctr);
 							if (reg) {
 								ba_AddIM(ctr, 4, BA_IM_MOV, reg, BA_IM_IMM, 
 									(u64)param->defaultVal);
 								ba_POpFuncCallPushArgReg(ctr, reg, paramSize);
 								if (paramSize < 8) {
-									ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADR, 
+									ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_ADR, 
 										BA_IM_RSP, ba_AdjRegSize(reg, paramSize));
 								}
 								ctr->usedRegisters &= ~ba_IMToCtrReg(reg);
@@ -1217,13 +1283,32 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 					param = param->next;
 				}
 
+				ba_POpFuncCallMovArgRegs(ctr, regArgs, regParams, regArgCnt);
+
 				// Reset stack
 				ba_DelStk(argsStk);
 				ctr->imStackSize = originalImStackSize;
 
+				/* Jump back to the start of the func for tail calls to 
+				 * itself, and copy the body of small funcs here instead of 
+				 * calling them */
+				bool isTailCall = !savedRegs && 
+					ba_IsTailCall(ctr, func, op->line, op->col);
+				bool isInlined = !isTailCall && ba_IsInlineCall(func);
+				bool isCall = !isTailCall && !isInlined;
+				if (isTailCall) {
+					ba_TailCall(ctr, func);
+				}
+				else if (isInlined) {
+					ba_InlineCall(ctr, func);
+				}
+				else {
+					func->isCalled = 1;
+				}
+
 				// Put static link on the stack (in the callee's stack frame)
 				// Built-in funcs with no child scope don't need this
-				if (func->childScope) {
+				if (func->childScope && isCall) {
 					struct ba_SymTable* scope = ctr->currScope->frameScope;
 					struct ba_SymTable* funcFrameScope = 
 						func->childScope->parent->frameScope;
@@ -1245,7 +1330,9 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				}
 
 				// Call the function, clear args from stack, init return value
-				ba_AddIM(ctr, 2, BA_IM_LABELCALL, func->lblStart);
+				if (isCall) {
+					ba_AddIM(ctr, 2, BA_IM_LABELCALL, func->lblStart);
+				}
 				if (func->paramStackSize) {
 					ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, 
 						BA_IM_IMM, func->paramStackSize);
@@ -1253,13 +1340,16 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 				struct ba_PTkStkItem* retVal = ba_MAlloc(sizeof(*retVal));
 
 				// Leave the stack frame
+				savedRegs = (u64)ba_StkPop(ctr->funcFrameStk);
 				ctr->usedRegisters = (u64)ba_StkPop(ctr->funcFrameStk);
 				
 				if (func->retType.type == BA_TYPE_ARR) {
 					// Get return value from stack
 					u64 retSz = ba_GetSizeOfType(func->retType);
 					ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, retSz);
+					// Kept until the end of the scope instead of the exp
 					ctr->currScope->dataSize += retSz;
+					ctr->imStackSize -= retSz;
 					retVal->lexemeType = BA_TK_IMREGISTER;
 					retVal->val = (void*)BA_IM_RSP;
 				}
@@ -1273,7 +1363,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 						ctr->usedRegisters &= ~ba_IMToCtrReg(regRet);
 						if (regRet) {
 							// Restore every register except RAX
-							ba_UsedRegRestore(ctr, 1);
+							ba_UsedRegRestore(ctr, savedRegs, 1);
 							ba_AddIM(ctr, 3, BA_IM_MOV, regRet, BA_IM_RAX);
 							ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RAX);
 							ctr->imStackSize -= 8;
@@ -1281,7 +1371,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 						else {
 							// Restore every register except the last two 
 							// (should be RCX, RAX)
-							ba_UsedRegRestore(ctr, 2);
+							ba_UsedRegRestore(ctr, savedRegs, 2);
 							// Swap the return value and the original rax value
 							ba_AddIM(ctr, 2, BA_IM_MOV, BA_IM_RCX, BA_IM_RAX);
 							ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RAX, BA_IM_ADRADD, 
@@ -1294,7 +1384,7 @@ u8 ba_POpHandle(struct ba_Ctr* ctr, struct ba_POpStkItem* handler) {
 						ctr->usedRegisters |= ba_IMToCtrReg(regRet);
 					}
 					else {
-						ba_UsedRegRestore(ctr, 0);
+						ba_UsedRegRestore(ctr, savedRegs, 0);
 						ctr->usedRegisters |= BA_CTRREG_RAX;
 					}
 					ba_POpSetArg(ctr, retVal, regRet, stackPos);
@@ -111,6 +111,7 @@ void ba_POpMovIdToReg(struct ba_Ctr* ctr, struct ba_STVal* id, u64 argSize,
 {
 	bool isPopRbp = 0;
 	i64 offset = ba_CalcVarOffset(ctr, id, &isPopRbp);
+	ba_AddRegHint(ctr, BA_REGHINT_ACCESS, id);
 	ba_AddIM(ctr, 5, isLea ? BA_IM_LEA : BA_IM_MOV, 
 		ba_AdjRegSize(reg, argSize), 
 		offset < 0 ? BA_IM_ADRSUB : BA_IM_ADRADD, BA_IM_RBP, 
@@ -144,7 +145,7 @@ bool ba_POpMovArgToReg(struct ba_Ctr* ctr, struct ba_PTkStkItem* arg, u64 reg,
 	}
 	if (arg->lexemeType == BA_TK_IMSTACK) {
 		ba_AddIM(ctr, 5, isArr ? BA_IM_LEA : BA_IM_MOV, reg, BA_IM_ADRSUB, 
-			BA_IM_RBP, ctr->currScope->dataSize + (u64)arg->val);
+			BA_IM_RBP, ba_STFrameDataSize(ctr->currScope) + (u64)arg->val);
 		return 1;
 	}
 	if (arg->lexemeType == BA_TK_LITSTR) {
@@ -180,7 +181,7 @@ bool ba_POpMovArgToRegDPTR(struct ba_Ctr* ctr, struct ba_PTkStkItem* arg,
 		u64 tmpReg = testReg == tmpRegDef ? tmpRegBackup : tmpRegDef;
 		ba_AddIM(ctr, 2, BA_IM_PUSH, tmpReg);
 		ba_AddIM(ctr, 5, BA_IM_MOV, tmpReg, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + (u64)arg->val);
+			ba_STFrameDataSize(ctr->currScope) + (u64)arg->val);
 		ba_AddIM(ctr, 4, BA_IM_MOV, reg, BA_IM_ADR, tmpReg);
 		ba_AddIM(ctr, 2, BA_IM_POP, tmpReg);
 		return 1;
@@ -197,7 +198,7 @@ void ba_POpSetArg(struct ba_Ctr* ctr, struct ba_PTkStkItem* arg, u64 reg,
 	}
 	else {
 		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + stackPos, BA_IM_RAX);
+			ba_STFrameDataSize(ctr->currScope) + stackPos, BA_IM_RAX);
 		ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RAX);
 		ctr->imStackSize -= 8;
 		arg->lexemeType = BA_TK_IMSTACK;
@@ -251,7 +252,8 @@ void ba_POpNonLitBinary(struct ba_Ctr* ctr, u64 imOp, struct ba_PTkStkItem* lhs,
 	ba_POpMovArgToReg(ctr, lhs, realRegL, isLhsLiteral);
 
 	u64 regR = (u64)rhs->val; // Kept only if rhs is a register
-	ba_POpAsgnRegOrStack(ctr, rhs->lexemeType, &regR, 0);
+	// rhs isn't given a place on the stack, see rhsReplacement
+	(rhs->lexemeType != BA_TK_IMREGISTER) && (regR = ba_NextIMRegister(ctr));
 	/* regR is replaced with rdx normally, but if regL is 
 	 * already rdx, regR will be set to rcx. */
 	u64 rhsReplacement = regL == BA_IM_RDX ? BA_IM_RCX : BA_IM_RDX;
@@ -315,7 +317,9 @@ void ba_POpNonLitBitShift(struct ba_Ctr* ctr, u64 imOp,
 		/* isLiteral = */ lhs->lexemeType != BA_TK_IMREGISTER);
 
 	if (isRhsLiteral) {
-		ba_AddIM(ctr, 4, imOp, regL, BA_IM_IMM, (u64)rhs->val & 0x3f);
+		// Shift counts are masked, AND (for modulo) takes the whole mask
+		u64 imm = imOp == BA_IM_AND ? (u64)rhs->val : (u64)rhs->val & 0x3f;
+		ba_AddIM(ctr, 4, imOp, regL, BA_IM_IMM, imm);
 	}
 	else {
 		u64 regTmp = BA_IM_RCX;
@@ -391,9 +395,9 @@ u8 ba_PCorrectDPtr(struct ba_Ctr* ctr, struct ba_PTkStkItem* item) {
 	else if (item->lexemeType == BA_TK_IMSTACK) {
 		ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RAX);
 		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RAX, BA_IM_ADRSUB, 
-			BA_IM_RBP, ctr->currScope->dataSize + (u64)item->val);
+			BA_IM_RBP, ba_STFrameDataSize(ctr->currScope) + (u64)item->val);
 		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + (u64)item->val, BA_IM_RAX);
+			ba_STFrameDataSize(ctr->currScope) + (u64)item->val, BA_IM_RAX);
 		ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RAX);
 	}
 	return 1;
@@ -455,6 +459,79 @@ void ba_POpFuncCallPushArgReg(struct ba_Ctr* ctr, u64 reg, u64 size) {
 	}
 }
 
+/* Moves the args of a func call that are passed in registers into those 
+ * registers. Args that are already in registers are moved first, in an order 
+ * that doesn't overwrite any of them before it is read, going through rax 
+ * (never an arg register) to break cycles. A null arg means the default. */
+void ba_POpFuncCallMovArgRegs(struct ba_Ctr* ctr, 
+	struct ba_PTkStkItem** args, struct ba_FuncParam** params, u64 cnt)
+{
+	u64 srcs[BA_FUNC_ARGREGCNT] = {0};
+	u64 pendingCnt = 0;
+	for (u64 i = 0; i < cnt; i++) {
+		struct ba_PTkStkItem* arg = args[i];
+		if (!arg || arg->lexemeType != BA_TK_IMREGISTER) {
+			continue;
+		}
+		u64 reg = (u64)arg->val;
+		ctr->usedRegisters &= ~ba_IMToCtrReg(reg);
+		if (params[i]->type.type == BA_TYPE_BOOL && 
+			arg->typeInfo.type != BA_TYPE_BOOL)
+		{
+			u64 adjReg = ba_AdjRegSize(reg, ba_GetSizeOfType(arg->typeInfo));
+			ba_AddIM(ctr, 3, BA_IM_TEST, adjReg, adjReg);
+			ba_AddIM(ctr, 2, BA_IM_SETNZ, ba_AdjRegSize(reg, 1));
+		}
+		(reg != params[i]->reg) && (srcs[i] = reg) && ++pendingCnt;
+	}
+
+	while (pendingCnt) {
+		u64 i = 0;
+		for (; i < cnt; i++) {
+			bool isBlocked = 0;
+			for (u64 j = 0; j < cnt; j++) {
+				isBlocked |= srcs[j] == params[i]->reg;
+			}
+			if (srcs[i] && !isBlocked) {
+				break;
+			}
+		}
+		if (i == cnt) {
+			for (i = 0; !srcs[i]; i++);
+			ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, srcs[i]);
+			srcs[i] = BA_IM_RAX;
+			continue;
+		}
+		ba_AddIM(ctr, 3, BA_IM_MOV, params[i]->reg, srcs[i]);
+		srcs[i] = 0;
+		--pendingCnt;
+	}
+
+	// Everything else is read from memory or is an immediate
+	for (u64 i = 0; i < cnt; i++) {
+		struct ba_PTkStkItem* arg = args[i];
+		u64 reg = params[i]->reg;
+		if (!arg) {
+			ba_AddIM(ctr, 4, BA_IM_MOV, reg, BA_IM_IMM, 
+				(u64)params[i]->defaultVal);
+			continue;
+		}
+		if (arg->lexemeType == BA_TK_IMREGISTER) {
+			continue;
+		}
+		bool isLiteral = ba_IsLexemeLiteral(arg->lexemeType);
+		bool isConvToBool = params[i]->type.type == BA_TYPE_BOOL && 
+			arg->typeInfo.type != BA_TYPE_BOOL;
+		isConvToBool && isLiteral && (arg->val = (void*)(bool)arg->val);
+		ba_POpMovArgToReg(ctr, arg, reg, isLiteral);
+		if (isConvToBool && !isLiteral) {
+			u64 adjReg = ba_AdjRegSize(reg, ba_GetSizeOfType(arg->typeInfo));
+			ba_AddIM(ctr, 3, BA_IM_TEST, adjReg, adjReg);
+			ba_AddIM(ctr, 2, BA_IM_SETNZ, ba_AdjRegSize(reg, 1));
+		}
+	}
+}
+
 struct ba_StaticAddr* 
 ba_AllocStrLitStatic(struct ba_Ctr* ctr, struct ba_Str* str) {
 	struct ba_Static* statObj = ba_MAlloc(sizeof(*statObj));
@@ -474,77 +551,188 @@ ba_AllocStrLitStatic(struct ba_Ctr* ctr, struct ba_Str* str) {
 	return staticAddr;
 }
 
+// Moves a pointer held in reg into argReg, an arg register of MemCopy
+void AssignArrMovReg(struct ba_Ctr* ctr, u64 argReg, u64 reg, u64 pushSize) {
+	if (reg == BA_IM_RSP && pushSize) {
+		ba_AddIM(ctr, 5, BA_IM_LEA, argReg, BA_IM_ADRADD, BA_IM_RSP, pushSize);
+	}
+	else if (reg != argReg) {
+		ba_AddIM(ctr, 3, BA_IM_MOV, argReg, reg);
+	}
+}
+
+void AssignArrSrc(struct ba_Ctr* ctr, struct ba_PTkStkItem* srcItem, u64 s, 
+	u64 pushSize)
+{
+	if (s) {
+		AssignArrMovReg(ctr, BA_IM_RSI, s, pushSize);
+	}
+	else if (srcItem->lexemeType == BA_TK_IDENTIFIER) {
+		ba_POpMovIdToReg(ctr, srcItem->val, 8, BA_IM_RSI, /* isLea = */ 1);
+	}
+	else if (srcItem->lexemeType == BA_TK_IMSTATIC) {
+		// Non-constant array literals
+		ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RSI, BA_IM_STATIC, 
+			(u64)srcItem->val);
+	}
+	else if (srcItem->lexemeType == BA_TK_LITSTR) {
+		ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RSI, BA_IM_STATIC, 
+			(u64)ba_AllocStrLitStatic(ctr, (struct ba_Str*)srcItem->val));
+	}
+	else if (srcItem->lexemeType == BA_TK_IMSTACK) {
+		ba_AddIM(ctr, 5, BA_IM_LEA, BA_IM_RSI, BA_IM_ADRSUB, BA_IM_RBP, 
+			ba_STFrameDataSize(ctr->currScope) + (u64)srcItem->val);
+	}
+}
+
 void ba_PAssignArr(struct ba_Ctr* ctr, struct ba_PTkStkItem* destItem, 
 	struct ba_PTkStkItem* srcItem, u64 size)
 {
-	{ // Recognize MemCopy as having been called
-		struct ba_STVal* stVal = ba_HTGet(ctr->globalST->ht, "MemCopy");
-		((struct ba_Func*)stVal->type.extraInfo)->isCalled = 1;
+	// Recognize MemCopy as having been called
+	struct ba_Func* memCopy = ((struct ba_STVal*)ba_STGet(ctr->globalST, 
+		ba_Intern("MemCopy")))->type.extraInfo;
+	memCopy->isCalled = 1;
+
+	if (srcItem->lexemeType == BA_TK_IMREGISTER && !destItem->lexemeType && 
+		srcItem->val == (void*)BA_IM_RSP && destItem->val == (void*)BA_IM_RSP)
+	{
+		return;
 	}
 
-	// Setting the default register so that it does not trample on used ones
-	u64 defaultReg = BA_IM_RAX;
+	// Registers holding the pointers
 	u64 d = 0;
-	destItem->lexemeType == BA_TK_IMREGISTER && (d = (u64)destItem->val);
+	(!destItem->lexemeType || destItem->lexemeType == BA_TK_IMREGISTER) &&
+		(d = (u64)destItem->val);
 	u64 s = 0;
 	srcItem->lexemeType == BA_TK_IMREGISTER && (s = (u64)srcItem->val);
-	if (d == BA_IM_RAX || s == BA_IM_RAX) {
-		defaultReg = (d == BA_IM_RCX || s == BA_IM_RCX) ? BA_IM_RDX : BA_IM_RCX;
+
+	// Preserve registers in use that are overwritten by MemCopy
+	u64 clobberRegs = ba_FuncClobberRegs(memCopy);
+	ba_AddCallClobbers(ctr, clobberRegs);
+	u64 clobbered = ctr->usedRegisters & clobberRegs;
+	u64 pushSize = 0;
+	for (u64 ctrReg = BA_CTRREG_RAX; ctrReg <= BA_CTRREG_R15; ctrReg <<= 1) {
+		if (clobbered & ctrReg) {
+			ba_AddIM(ctr, 2, BA_IM_PUSH, ba_CtrRegToIM(ctrReg));
+			pushSize += 8;
+		}
 	}
-	u64 reg = defaultReg;
+	ctr->imStackSize += pushSize;
 
-	if (srcItem->lexemeType == BA_TK_IMREGISTER && !destItem->lexemeType && 
-		srcItem->val == (void*)BA_IM_RSP && destItem->val == (void*)BA_IM_RSP)
-	{
-		return;
+	// A source pointer in rdi is moved first so that it isn't overwritten
+	bool isSrcFirst = s == BA_IM_RDI;
+	if (isSrcFirst && d == BA_IM_RSI) {
+		ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RSI);
+		d = BA_IM_RAX;
 	}
+	isSrcFirst && (AssignArrSrc(ctr, srcItem, s, pushSize), 1);
 
 	// Destination pointer
-	if (!destItem->lexemeType) {
-		reg = (u64)destItem->val;
+	if (d) {
+		AssignArrMovReg(ctr, BA_IM_RDI, d, pushSize);
 	}
 	else if (destItem->lexemeType == BA_TK_IDENTIFIER) {
-		ba_POpMovIdToReg(ctr, destItem->val, 8, defaultReg, /* isLea = */ 1);
-	}
-	else if (destItem->lexemeType == BA_TK_IMREGISTER) {
-		// (DPTR)
-		reg = (u64)destItem->val;
+		ba_POpMovIdToReg(ctr, destItem->val, 8, BA_IM_RDI, /* isLea = */ 1);
 	}
 	else if (destItem->lexemeType == BA_TK_IMSTACK) {
 		// (DPTR)
-		ba_AddIM(ctr, 5, BA_IM_MOV, defaultReg, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + (u64)destItem->val);
+		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_RDI, BA_IM_ADRSUB, BA_IM_RBP, 
+			ba_STFrameDataSize(ctr->currScope) + (u64)destItem->val);
 	}
-	ba_AddIM(ctr, 3, BA_IM_PUSH, reg); // dest ptr
-	ctr->imStackSize += 8;
 
-	// Source pointer
-	reg = defaultReg;
-	if (srcItem->lexemeType == BA_TK_IDENTIFIER) {
-		ba_POpMovIdToReg(ctr, srcItem->val, 8, defaultReg, /* isLea = */ 1);
+	!isSrcFirst && (AssignArrSrc(ctr, srcItem, s, pushSize), 1);
+	
+	ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RDX, BA_IM_IMM, size);
+	ba_AddIM(ctr, 2, BA_IM_LABELCALL, ba_BltinLblGet(BA_BLTIN_CoreMemCopy));
+
+	for (u64 ctrReg = BA_CTRREG_R15; ctrReg >= BA_CTRREG_RAX; ctrReg >>= 1) {
+		if (clobbered & ctrReg) {
+			ba_AddIM(ctr, 2, BA_IM_POP, ba_CtrRegToIM(ctrReg));
+		}
 	}
-	else if (srcItem->lexemeType == BA_TK_IMREGISTER) {
-		reg = (u64)srcItem->val;
+	ctr->imStackSize -= pushSize;
+}
+
+/* Leaves rax divided by the constant d in rax and, unless isDiv, the 
+ * remainder in rdx, the same as DIV or IDIV would. The division is done by 
+ * multiplying by a fixed-point reciprocal of d, or by shifting for powers of 
+ * 2 (as in libdivide). reg is used for the dividend, and set back to d for 
+ * signed modulo. */
+void DivModByConst(struct ba_Ctr* ctr, u64 d, u64 reg, bool isSigned, 
+	bool isDiv)
+{
+	bool isNeg = isSigned && (i64)d < 0;
+	u64 absD = isNeg ? -d : d;
+	u64 log2D = 63 - __builtin_clzll(absD);
+	ba_AddIM(ctr, 3, BA_IM_MOV, reg, BA_IM_RAX);
+
+	if (!(absD & (absD - 1))) {
+		// Round negative dividends towards 0 by adding absD - 1 first
+		if (isSigned && log2D) {
+			ba_AddIM(ctr, 1, BA_IM_CQO);
+			ba_AddIM(ctr, 4, BA_IM_SHR, BA_IM_RDX, BA_IM_IMM, 64 - log2D);
+			ba_AddIM(ctr, 3, BA_IM_ADD, BA_IM_RAX, BA_IM_RDX);
+		}
+		log2D && (ba_AddIM(ctr, 4, isSigned ? BA_IM_SAR : BA_IM_SHR, 
+			BA_IM_RAX, BA_IM_IMM, log2D), 1);
 	}
-	else if (srcItem->lexemeType == BA_TK_IMSTATIC) {
-		// Non-constant array literals
-		ba_AddIM(ctr, 4, BA_IM_MOV, defaultReg, BA_IM_STATIC, (u64)srcItem->val);
+	else {
+		/* magic = 2^(64+shift) / absD rounded up, with shift chosen so that 
+		 * the result is exact for any dividend. If that needs more than 64 
+		 * (or for signed, 63) bits, it is stored without the top bit, which 
+		 * is made up for by adding the dividend back. */
+		u64 shift = log2D - isSigned;
+		unsigned __int128 num = (unsigned __int128)1 << (64 + shift);
+		u64 magic = num / absD;
+		u64 rem = num % absD;
+		bool isAdd = absD - rem >= (1llu << log2D);
+		if (isAdd) {
+			magic += magic;
+			u64 twiceRem = rem + rem;
+			(twiceRem >= absD || twiceRem < rem) && ++magic;
+			shift += isSigned;
+		}
+		++magic;
+
+		ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RDX, BA_IM_IMM, magic);
+		ba_AddIM(ctr, 2, isSigned ? BA_IM_IMUL : BA_IM_MUL, BA_IM_RDX);
+		if (isSigned) {
+			isAdd && (ba_AddIM(ctr, 3, BA_IM_ADD, BA_IM_RDX, reg), 1);
+			shift && (ba_AddIM(ctr, 4, BA_IM_SAR, BA_IM_RDX, BA_IM_IMM, 
+				shift), 1);
+			// Round towards 0 instead of down
+			ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
+			ba_AddIM(ctr, 4, BA_IM_SHR, BA_IM_RAX, BA_IM_IMM, 63);
+			ba_AddIM(ctr, 3, BA_IM_ADD, BA_IM_RAX, BA_IM_RDX);
+		}
+		else if (isAdd) {
+			ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, reg);
+			ba_AddIM(ctr, 3, BA_IM_SUB, BA_IM_RAX, BA_IM_RDX);
+			ba_AddIM(ctr, 4, BA_IM_SHR, BA_IM_RAX, BA_IM_IMM, 1);
+			ba_AddIM(ctr, 3, BA_IM_ADD, BA_IM_RAX, BA_IM_RDX);
+			ba_AddIM(ctr, 4, BA_IM_SHR, BA_IM_RAX, BA_IM_IMM, shift);
+		}
+		else {
+			ba_AddIM(ctr, 4, BA_IM_SHR, BA_IM_RDX, BA_IM_IMM, shift);
+			ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, BA_IM_RDX);
+		}
 	}
-	else if (srcItem->lexemeType == BA_TK_LITSTR) {
-		ba_AddIM(ctr, 4, BA_IM_MOV, defaultReg, BA_IM_STATIC, 
-			(u64)ba_AllocStrLitStatic(ctr, (struct ba_Str*)srcItem->val));
+	isNeg && (ba_AddIM(ctr, 2, BA_IM_NEG, BA_IM_RAX), 1);
+
+	if (isDiv) {
+		return;
 	}
-	else if (srcItem->lexemeType == BA_TK_IMSTACK) {
-		ba_AddIM(ctr, 5, BA_IM_LEA, defaultReg, BA_IM_ADRSUB, BA_IM_RBP, 
-			ctr->currScope->dataSize + (u64)srcItem->val);
+	// Remainder = dividend - quotient * d
+	if ((i64)d >= -(1ll << 31) && (i64)d < (1ll << 31)) {
+		ba_AddIM(ctr, 5, BA_IM_IMUL, BA_IM_RDX, BA_IM_RAX, BA_IM_IMM, d);
 	}
-	ba_AddIM(ctr, 2, BA_IM_PUSH, reg); // src ptr
-	ctr->imStackSize -= 8; // so that memory is not automatically deallocated
-	
-	ba_AddIM(ctr, 4, BA_IM_MOV, defaultReg, BA_IM_IMM, size); // mem size
-	ba_AddIM(ctr, 2, BA_IM_PUSH, defaultReg);
-	ba_AddIM(ctr, 2, BA_IM_LABELCALL, ba_BltinLblGet(BA_BLTIN_CoreMemCopy));
-	ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, 0x18);
+	else {
+		ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RDX, BA_IM_IMM, d);
+		ba_AddIM(ctr, 3, BA_IM_IMUL, BA_IM_RDX, BA_IM_RAX);
+	}
+	ba_AddIM(ctr, 3, BA_IM_SUB, reg, BA_IM_RDX);
+	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDX, reg);
+	isSigned && (ba_AddIM(ctr, 4, BA_IM_MOV, reg, BA_IM_IMM, d), 1);
 }
 
 /* A helper used to stand in for duplicated code in division and modulo
@@ -606,8 +794,13 @@ void ba_POpNonLitDivMod(struct ba_Ctr* ctr, struct ba_PTkStkItem* lhs,
 			ba_IsLexemeLiteral(rhs->lexemeType));
 	}
 
-	ba_AddIM(ctr, 1, BA_IM_CQO);
-	ba_AddIM(ctr, 2, areBothUnsigned ? BA_IM_DIV : BA_IM_IDIV, realReg);
+	if (ba_IsLexemeLiteral(rhs->lexemeType)) {
+		DivModByConst(ctr, (u64)rhs->val, realReg, !areBothUnsigned, isDiv);
+	}
+	else {
+		ba_AddIM(ctr, 1, BA_IM_CQO);
+		ba_AddIM(ctr, 2, areBothUnsigned ? BA_IM_DIV : BA_IM_IDIV, realReg);
+	}
 
 	if (isDiv) {
 		ba_AddIM(ctr, 3, BA_IM_MOV, isAssign ? realReg : regL, BA_IM_RAX);
@@ -641,8 +834,9 @@ void ba_POpNonLitDivMod(struct ba_Ctr* ctr, struct ba_PTkStkItem* lhs,
 				arg->val = (void*)regL;
 			}
 			else {
-				ba_AddIM(ctr, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP,
-					ctr->currScope->dataSize + lhsStackPos, BA_IM_RDX);
+				ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRSUB, BA_IM_RBP,
+					ba_STFrameDataSize(ctr->currScope) + lhsStackPos, 
+					BA_IM_RDX);
 				arg->lexemeType = BA_TK_IMSTACK;
 				arg->val = (void*)ctr->imStackSize;
 			}
@@ -5,6 +5,7 @@
 
 #include "../common/ctr.h"
 #include "../common/parser.h"
+#include "../common/func.h"
 
 bool ba_POpIsHandler(struct ba_POpStkItem* op);
 u8 ba_POpPrecedence(struct ba_POpStkItem* op);
@@ -31,6 +32,8 @@ u8 ba_PCorrectDPtr(struct ba_Ctr* ctr, struct ba_PTkStkItem* item);
 u8 ba_POpAssignChecks(struct ba_Ctr* ctr, struct ba_Type lhsType, 
 	struct ba_PTkStkItem* rhs, u64 line, u64 col);
 void ba_POpFuncCallPushArgReg(struct ba_Ctr* ctr, u64 reg, u64 size);
+void ba_POpFuncCallMovArgRegs(struct ba_Ctr* ctr, 
+	struct ba_PTkStkItem** args, struct ba_FuncParam** params, u64 cnt);
 struct ba_StaticAddr* 
 ba_AllocStrLitStatic(struct ba_Ctr* ctr, struct ba_Str* str);
 void ba_PAssignArr(struct ba_Ctr* ctr, struct ba_PTkStkItem* destItem, 
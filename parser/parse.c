@@ -5,6 +5,7 @@
 /* program = { stmt } eof */
 u8 ba_Parse(struct ba_Ctr* ctr) {
 	ba_IncludeCore(ctr);
+	ba_LexUpTo(ctr, ctr->lex);
 	
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
 	while (!ba_PAccept(BA_TK_EOF, ctr)) {
@@ -12,22 +13,22 @@ u8 ba_Parse(struct ba_Ctr* ctr) {
 			// doesn't have anything to do with literals, 
 			// this is just a decent buffer size
 			char msg[BA_LITERAL_SIZE+1];
-			if (ctr->lex->type == BA_TK_FILECHANGE) {
+			if (BA_LEX_TYPE(ctr) == BA_TK_FILECHANGE) {
 				snprintf(msg, BA_LITERAL_SIZE+1, 
 					"unexpected end of file %s, included on", ctr->currPath);
-				ctr->currPath = ctr->lex->val;
+				ctr->currPath = BA_LEX_VAL(ctr);
 			}
-			else if (ctr->lex->type == BA_TK_EOF) {
+			else if (BA_LEX_TYPE(ctr) == BA_TK_EOF) {
 				fprintf(stderr, "Error: unexpected end of file in %s\n",
 					ctr->currPath);
 				exit(1);
 			}
 			else {
 				snprintf(msg, BA_LITERAL_SIZE+1, "unexpected %s at", 
-					ba_GetLexemeStr(ctr->lex->type));
+					ba_GetLexemeStr(BA_LEX_TYPE(ctr)));
 			}
-			return ba_ExitMsg(BA_EXIT_ERR, msg, ctr->lex->line, 
-				ctr->lex->col, ctr->currPath);
+			return ba_ExitMsg(BA_EXIT_ERR, msg, BA_LEX_LINE(ctr), 
+				BA_LEX_COL(ctr), ctr->currPath);
 		}
 	}
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
@@ -3,6 +3,8 @@
 #include "common.h"
 #include "fstr.h"
 #include "../common/options.h"
+#include "../inline.h"
+#include "../tailcall.h"
 
 // commaStmt = "," stmt
 u8 CommaStmt(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
@@ -11,7 +13,7 @@ u8 CommaStmt(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
 	}
 
 	if (!scope) {
-		ctr->currScope = ba_SymTableAddChild(ctr->currScope);
+		ba_STEnter(ctr, ba_SymTableAddChild(ctr->currScope));
 	}
 	
 	if (!ba_PStmt(ctr)) {
@@ -23,7 +25,7 @@ u8 CommaStmt(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
 			ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, 
 				ctr->currScope->dataSize);
 		}
-		ctr->currScope = ctr->currScope->parent;
+		ba_STLeave(ctr);
 	}
 
 	return 1;
@@ -74,9 +76,9 @@ void WriteStr(struct ba_Ctr* ctr, u64 len, char* str, i64 fd) {
 }
 
 u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col, 
-	struct ba_Type retType)
+	struct ba_Type retType, bool isInline)
 {
-	struct ba_STVal* prevFuncIdVal = ba_HTGet(ctr->currScope->ht, funcName);
+	struct ba_STVal* prevFuncIdVal = ba_STGet(ctr->currScope, funcName);
 	if (prevFuncIdVal && (prevFuncIdVal->type.type != BA_TYPE_FUNC || 
 		prevFuncIdVal->isInited))
 	{
@@ -99,8 +101,9 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 			"size array on", line, col, ctr->currPath);
 	}
 
-	struct ba_STVal* funcIdVal = ba_MAlloc(sizeof(*funcIdVal));
-	ba_HTSet(ctr->currScope->ht, funcName, (void*)funcIdVal);
+	struct ba_STVal* funcIdVal = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(*funcIdVal));
+	ba_STSet(ctr->currScope, funcName, (void*)funcIdVal);
 
 	funcIdVal->scope = ctr->currScope;
 	funcIdVal->type.type = BA_TYPE_FUNC;
@@ -109,17 +112,18 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 	funcIdVal->type.extraInfo = (void*)func;
 
 	func->retType = retType;
+	func->isInline = isInline;
 	func->childScope = ba_SymTableAddChild(ctr->currScope);
 	func->childScope->func = func;
-	func->childScope->hasFramePtrLink = 1;
 	func->childScope->frameScope = func->childScope;
 
 	struct ba_FuncParam* param = ba_NewFuncParam();
 	char* paramName = 0;
 	func->firstParam = param;
+	u64 regParamCnt = 0;
 
-	struct ba_IM* oldIM = ctr->im;
-	ctr->im = func->imBegin;
+	struct ba_IMBuf* oldIM = ctr->im;
+	ctr->im = func->im;
 
 	enum {
 		TP_NONE = 0,
@@ -170,13 +174,10 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 				param->type = *(struct ba_Type*)((struct ba_PTkStkItem*)
 					ba_StkPop(ctr->pTkStk))->typeInfo.extraInfo;
 
-				if (ctr->lex->val) {
-					paramName = ba_MAlloc(ctr->lex->valLen+1);
-					strcpy(paramName, ctr->lex->val);
-				}
+				paramName = BA_LEX_VAL(ctr);
 
-				line = ctr->lex->line;
-				col = ctr->lex->col;
+				line = BA_LEX_LINE(ctr);
+				col = BA_LEX_COL(ctr);
 
 				// ... identifier ...
 				if (!ba_PAccept(BA_TK_IDENTIFIER, ctr)) {
@@ -188,7 +189,7 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 					break;
 				}
 
-				if (ba_HTGet(func->childScope->ht, paramName)) {
+				if (ba_STGet(func->childScope, paramName)) {
 					return ba_ErrorVarRedef(paramName, line, col, ctr->currPath);
 				}
 				if (ba_STParentFind(ctr->currScope, 
@@ -197,15 +198,21 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 					ba_ErrorShadow(paramName, line, col, ctr->currPath);
 				}
 
-				param->stVal = ba_MAlloc(sizeof(struct ba_STVal));
+				param->stVal = ba_ArenaAlloc(BA_ARENA_PARSE, 
+					sizeof(struct ba_STVal));
 				param->stVal->scope = func->childScope;
 				param->stVal->type = param->type;
 
+				// Integer and pointer args go in registers while there are any
 				u64 paramSize = ba_GetSizeOfType(param->stVal->type);
-				func->paramStackSize += paramSize;
-				param->stVal->address = func->paramStackSize;
+				ba_IsTypeNum(param->type) && 
+					(param->reg = ba_FuncArgReg(regParamCnt++));
+				if (!param->reg) {
+					func->paramStackSize += paramSize;
+					param->stVal->address = func->paramStackSize;
+				}
 
-				ba_HTSet(func->childScope->ht, paramName, (void*)param->stVal);
+				ba_STSet(func->childScope, paramName, (void*)param->stVal);
 
 				state = ST_PARAM;
 			}
@@ -225,8 +232,8 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 				}
 
 				// ... "=" exp ...
-				line = ctr->lex->line;
-				col = ctr->lex->col;
+				line = BA_LEX_LINE(ctr);
+				col = BA_LEX_COL(ctr);
 
 				ba_StkPush(ctr->expCoercedTypeStk, &param->type);
 
@@ -295,19 +302,26 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 
 	func->lblStart = ctr->labelCnt++;
 	func->lblEnd = ctr->labelCnt++;
+	func->lblBody = ctr->labelCnt++;
 
 	ba_AddIM(ctr, 2, BA_IM_LABEL, func->lblStart);
 
 	func->contextSize = 0x18; // return location + dynamic link + static link
 
-	// TODO: praeserve registers
+	if (ba_GetOptLevel() >= BA_OPT_REGVARLEVEL) {
+		// Space for saving registers kept for variables
+		func->contextSize += BA_REGVAR_SAVESIZE;
+		ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, BA_REGVAR_SAVESIZE);
+	}
 	
 	ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP); // dynamic link
 	ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, 8); // static link
 
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP); // enter stack frame
+	ba_AddRegHint(ctr, BA_REGHINT_SAVE, 0);
+	ba_AddIM(ctr, 2, BA_IM_LABEL, func->lblBody);
 
-	ctr->currScope = func->childScope;
+	ba_STEnter(ctr, func->childScope);
 	struct ba_Stk* oldBreakStk = ctr->pBreakStk;
 	ctr->pBreakStk = ba_NewStk();
 
@@ -320,10 +334,26 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 		ba_PExpect(';', ctr);
 	}
 	else {
-		// Correct param addresses
+		/* Correct addresses of params on the stack, and store the ones 
+		 * passed in registers as the first variables of the func */
 		param = func->firstParam;
 		for (u64 i = 0; i < func->paramCnt; ++i) {
-			param->stVal->address -= func->paramStackSize + func->contextSize;
+			bool isRegVarCand = ba_IsTypeInt(param->type) && 
+				ba_GetSizeOfType(param->type) == 8;
+			if (param->reg) {
+				u64 paramSize = ba_GetSizeOfType(param->type);
+				ctr->currScope->dataSize += paramSize;
+				param->stVal->address = ctr->currScope->dataSize;
+				isRegVarCand && 
+					(ba_AddRegHint(ctr, BA_REGHINT_DECL, param->stVal), 1);
+				ba_POpFuncCallPushArgReg(ctr, param->reg, paramSize);
+			}
+			else {
+				param->stVal->address -= 
+					func->paramStackSize + func->contextSize;
+				isRegVarCand && 
+					(ba_AddRegHint(ctr, BA_REGHINT_PARAM, param->stVal), 1);
+			}
 			param = param->next;
 		}
 
@@ -351,23 +381,35 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 			"%llu:%llu in %s incompatible with previously forward declared "
 			"definition\n", funcName, line, col, ctr->currPath);
 		exit(1);
-		free(prevFuncIdVal);
 	}
 	
 	ba_AddIM(ctr, 2, BA_IM_LABEL, func->lblEnd);
+	ba_AddRegHint(ctr, BA_REGHINT_RESTORE, 0);
 	ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP); // leave stack frame
 
 	ba_DelStk(ctr->pBreakStk);
 	ctr->pBreakStk = oldBreakStk;
-	ctr->currScope = func->childScope->parent;
+	ba_STLeave(ctr);
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP); // pop static pointer
 	ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP); // pop dynamic pointer
-	// TODO: restore registers
+	if (ba_GetOptLevel() >= BA_OPT_REGVARLEVEL) {
+		ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, BA_REGVAR_SAVESIZE);
+	}
 	ba_AddIM(ctr, 1, BA_IM_RET);
 
-	func->imEnd = ctr->im;
 	ctr->im = oldIM;
 
+	if (stmtType == TP_FULLDEC) {
+		func->clobberRegs |= ba_IMClobberRegs(func->im);
+		func->isClobberKnown = 1;
+		func->isDefined = 1;
+		ba_InlineCheck(ctr, func);
+		if (isInline && !func->isInlinable) {
+			ba_ExitMsg(BA_EXIT_WARN, "func declared inline cannot be "
+				"inlined on", line, col, ctr->currPath);
+		}
+	}
+
 	if (stmtType == TP_FULLDEC && retType.type != BA_TYPE_VOID && 
 		!func->doesReturn) 
 	{
@@ -384,7 +426,7 @@ u8 FuncDef(struct ba_Ctr* ctr, char* funcName, u64 line, u64 col,
 u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col, 
 	struct ba_Type type)
 {
-	if (ba_HTGet(ctr->currScope->ht, idName)) {
+	if (ba_STGet(ctr->currScope, idName)) {
 		return ba_ErrorVarRedef(idName, line, col, ctr->currPath);
 	}
 
@@ -392,7 +434,8 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 		ba_ErrorShadow(idName, line, col, ctr->currPath);
 	}
 
-	struct ba_STVal* idVal = ba_MAlloc(sizeof(struct ba_STVal));
+	struct ba_STVal* idVal = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(struct ba_STVal));
 	idVal->scope = ctr->currScope;
 	idVal->type = type;
 
@@ -400,10 +443,10 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 		return ba_ErrorVarVoid(line, col, ctr->currPath);
 	}
 	
-	ba_HTSet(ctr->currScope->ht, idName, (void*)idVal);
+	ba_STSet(ctr->currScope, idName, (void*)idVal);
 
-	line = ctr->lex->line;
-	col = ctr->lex->col;
+	line = BA_LEX_LINE(ctr);
+	col = BA_LEX_COL(ctr);
 
 	ba_PExpect('=', ctr);
 
@@ -456,6 +499,7 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 			if (expItem->lexemeType == BA_TK_IDENTIFIER) {
 				bool isPopRbp = 0;
 				i64 offset = ba_CalcVarOffset(ctr, expItem->val, &isPopRbp);
+				ba_AddRegHint(ctr, BA_REGHINT_ACCESS, expItem->val);
 				ba_AddIM(ctr, 5, BA_IM_MOV, ba_AdjRegSize(BA_IM_RAX, dataSize), 
 					offset < 0 ? BA_IM_ADRSUB : BA_IM_ADRADD, BA_IM_RBP,
 					offset < 0 ? -offset : offset);
@@ -475,6 +519,7 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 		ctr->currScope->dataSize += dataSize;
 
 		if (dataSize == 8) {
+			ba_AddRegHint(ctr, BA_REGHINT_DECL, idVal);
 			ba_AddIM(ctr, 2, BA_IM_PUSH, reg);
 		}
 		else if (dataSize == 1) {
@@ -500,6 +545,13 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 			ba_ExitMsg(BA_EXIT_ERR, "attempting to initialize array with " 
 				"indefinite size to garbage on", line, col, ctr->currPath);
 		}
+		// An array returned by a func is already on the stack
+		if (!isGarbage && expItem->lexemeType == BA_TK_IMREGISTER && 
+			(u64)expItem->val == BA_IM_RSP)
+		{
+			idVal->address = ctr->currScope->dataSize;
+			return 1;
+		}
 		ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, dataSize);
 		ctr->currScope->dataSize += dataSize;
 		if (!isGarbage) {
@@ -513,6 +565,71 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
 	return 1;
 }
 
+// Consts are only stored in the symbol table, never on the stack
+u8 ConstDef(struct ba_Ctr* ctr) {
+	if (!ba_PPlainType(ctr, /* isInclVoid = */ 0, /* isInclIndefArr = */ 0)) {
+		return 0;
+	}
+	struct ba_PTkStkItem* typeTk = ba_StkPop(ctr->pTkStk);
+	struct ba_Type type = *(struct ba_Type*)(typeTk->typeInfo.extraInfo);
+
+	char* idName = BA_LEX_VAL(ctr);
+
+	u64 line = BA_LEX_LINE(ctr);
+	u64 col = BA_LEX_COL(ctr);
+
+	if (!ba_PExpect(BA_TK_IDENTIFIER, ctr)) {
+		return 0;
+	}
+
+	if (ba_STGet(ctr->currScope, idName)) {
+		return ba_ErrorVarRedef(idName, line, col, ctr->currPath);
+	}
+	if (ba_STParentFind(ctr->currScope, /* stFoundInPtr = */ 0, idName)) {
+		ba_ErrorShadow(idName, line, col, ctr->currPath);
+	}
+	if (!ba_IsTypeInt(type) && type.type != BA_TYPE_BOOL) {
+		return ba_ExitMsg(BA_EXIT_ERR, "const must be of an integer type or "
+			"bool on", line, col, ctr->currPath);
+	}
+
+	line = BA_LEX_LINE(ctr);
+	col = BA_LEX_COL(ctr);
+
+	if (!ba_PExpect('=', ctr)) {
+		return 0;
+	}
+
+	ba_StkPush(ctr->expCoercedTypeStk, &type);
+	if (!ba_PExp(ctr)) {
+		return 0;
+	}
+	ba_StkPop(ctr->expCoercedTypeStk);
+
+	struct ba_PTkStkItem* expItem = ba_StkPop(ctr->pTkStk);
+	if (!expItem->isConst || expItem->lexemeType != BA_TK_LITINT) {
+		return ba_ExitMsg(BA_EXIT_ERR, "const value cannot be resolved at "
+			"compile time on", line, col, ctr->currPath);
+	}
+	ba_POpAssignChecks(ctr, type, expItem, line, col);
+
+	u64 val = (u64)expItem->val;
+	(type.type == BA_TYPE_BOOL) && (val = (bool)val);
+	(type.type == BA_TYPE_U8) && (val &= 0xff);
+	(type.type == BA_TYPE_I8) && (val = (i64)(i8)val);
+
+	struct ba_STVal* idVal = ba_ArenaAlloc(BA_ARENA_PARSE, 
+		sizeof(struct ba_STVal));
+	idVal->scope = ctr->currScope;
+	idVal->type = type;
+	idVal->isInited = 1;
+	idVal->isConst = 1;
+	idVal->constVal = val;
+	ba_STSet(ctr->currScope, idName, (void*)idVal);
+
+	return ba_PExpect(';', ctr);
+}
+
 /* type = base_type | id_type */
 /* stmt = "if" exp ( commaStmt | scope ) { "elif" exp ( commaStmt | scope ) }
  *        [ "else" ( commaStmt | scope ) ]
@@ -528,27 +645,30 @@ u8 VarDef(struct ba_Ctr* ctr, char* idName, u64 line, u64 col,
  *      | scope
  *      | type identifier "(" [ { type [ identifier ] "," } 
  *        type [ identifier ] ] ")" ";"
- *      | type identifier "(" [ { type identifier [ "=" exp ] "," } 
- *        type identifier [ "=" exp ] ] ")" ( commaStmt | scope ) 
+ *      | [ "inline" ] type identifier "(" [ { type identifier [ "=" exp ] 
+ *        "," } type identifier [ "=" exp ] ] ")" ( commaStmt | scope ) 
  *      | type identifier "=" exp ";"
+ *      | "const" type identifier "=" exp ";"
  *      | identifier ":"
  *      | exp ";"
  *      | ";" 
  */
 u8 ba_PStmt(struct ba_Ctr* ctr) {
-	u64 firstLine = ctr->lex->line;
-	u64 firstCol = ctr->lex->col;
+	// Nothing before a statement is parsed again
+	ctr->tks->base = ctr->lex;
+
+	u64 firstLine = BA_LEX_LINE(ctr);
+	u64 firstCol = BA_LEX_COL(ctr);
 
 	// <file change>
-	if (ctr->lex->type == BA_TK_FILECHANGE) {
-		ctr->currPath = ba_MAlloc(ctr->lex->valLen+1);
-		strcpy(ctr->currPath, ctr->lex->val);
+	if (BA_LEX_TYPE(ctr) == BA_TK_FILECHANGE) {
+		ctr->currPath = BA_LEX_VAL(ctr);
 		return ba_PAccept(BA_TK_FILECHANGE, ctr);
 	}
 	// "if" ...
 	else if (ba_PAccept(BA_TK_KW_IF, ctr)) {
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 		u64 endLblId = ctr->labelCnt++;
 		bool hasReachedElse = 0;
 
@@ -594,7 +714,7 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 				return 0;
 			}
 
-			if (ctr->lex->type == BA_TK_KW_ELIF || ctr->lex->type == BA_TK_KW_ELSE) {
+			if (BA_LEX_TYPE(ctr) == BA_TK_KW_ELIF || BA_LEX_TYPE(ctr) == BA_TK_KW_ELSE) {
 				ba_AddIM(ctr, 2, BA_IM_LABELJMP, endLblId);
 			}
 			
@@ -622,8 +742,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	}
 	// "assert" exp ";"
 	else if (ba_PAccept(BA_TK_KW_ASSERT, ctr)) {
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 		
 		if (!ba_PExp(ctr)) {
 			return 0;
@@ -679,17 +799,14 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	}
 	// "while" ...
 	else if (ba_PAccept(BA_TK_KW_WHILE, ctr)) {
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
 		u64 startLblId = ctr->labelCnt++;
-		ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RBP);
-		ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RBP, BA_IM_RSP);
 		ba_AddIM(ctr, 2, BA_IM_LABEL, startLblId);
 
-		ctr->currScope = ba_SymTableAddChild(ctr->currScope);
-		ctr->currScope->hasFramePtrLink = 1;
-		ctr->currScope->frameScope = ctr->currScope;
+		// Variables declared in the loop are in the frame of the func
+		ba_STEnter(ctr, ba_SymTableAddChild(ctr->currScope));
 
 		// ... exp ...
 		if (!ba_PExp(ctr)) {
@@ -732,13 +849,16 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 			ba_AddIM(ctr, 2, BA_IM_LABELJZ, endLblId);
 		}
 
-		struct ba_IM* imIterBegin = 0;
-		struct ba_IM* imIterEnd = 0;
+		// e.g. an array returned by a func in the condition
+		u64 condDataSize = ctr->currScope->dataSize;
+		u64 breakLblId = condDataSize ? ctr->labelCnt++ : endLblId;
+
+		struct ba_IMBuf* iterIM = 0;
 		// ... ";" ...
 		if (ba_PAccept(';', ctr)) {
-			struct ba_IM* oldIM = ctr->im;
-			imIterBegin = ba_NewIM();
-			ctr->im = imIterBegin;
+			struct ba_IMBuf* oldIM = ctr->im;
+			iterIM = ba_NewIMBuf();
+			ctr->im = iterIM;
 
 			// ... exp ...
 			if (!ba_PExp(ctr)) {
@@ -750,12 +870,12 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 					ctr->currPath);
 			}
 			
-			imIterEnd = ctr->im;
 			ctr->im = oldIM;
 		}
 		
 		// ... ( commaStmt | scope ) ...
-		ba_PBreakStkPush(ctr->pBreakStk, endLblId, ctr->currScope);
+		ba_PBreakStkPush(ctr->pBreakStk, breakLblId, ctr->currScope, 
+			ba_STFrameDataSize(ctr->currScope->parent));
 		if (!CommaStmt(ctr, ctr->currScope) && 
 			!ba_PScope(ctr, ctr->currScope)) 
 		{
@@ -763,20 +883,23 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 		}
 		ba_StkPop(ctr->pBreakStk);
 
-		if (imIterBegin) {
-			memcpy(ctr->im, imIterBegin, sizeof(*ctr->im));
-			free(imIterBegin);
-			ctr->im = imIterEnd;
+		if (iterIM) {
+			ba_IMBufAppend(ctr->im, iterIM);
 		}
 
-		ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
+		if (ctr->currScope->dataSize) {
+			ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, 
+				ctr->currScope->dataSize);
+		}
 		ba_AddIM(ctr, 2, BA_IM_LABELJMP, startLblId);
 
 		ba_AddIM(ctr, 2, BA_IM_LABEL, endLblId);
-		ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
-		ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
+		if (condDataSize) {
+			ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, condDataSize);
+			ba_AddIM(ctr, 2, BA_IM_LABEL, breakLblId);
+		}
 
-		ctr->currScope = ctr->currScope->parent;
+		ba_STLeave(ctr);
 
 		return 1;
 	}
@@ -787,12 +910,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 				"loop on", firstLine, firstCol, ctr->currPath);
 		}
 		struct ba_PLabel* label = ba_StkTop(ctr->pBreakStk);
-		struct ba_SymTable* scope = ctr->currScope;
-		while (scope != label->scope) {
-			ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
-			ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
-			scope = scope->parent;
-		}
+		ba_STAdjStack(ctr, ba_STFrameDataSize(ctr->currScope), 
+			label->frameDataSize);
 		ba_AddIM(ctr, 2, BA_IM_LABELJMP, label->id);
 		return ba_PExpect(';', ctr);
 	}
@@ -803,16 +922,15 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 			return ba_ExitMsg(BA_EXIT_ERR, "keyword 'return' used outside of "
 				"func on", firstLine, firstCol, ctr->currPath);
 		}
-		if (!ctr->lex) {
-			ba_PExpect(';', ctr);
-		}
-
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
 		ba_StkPush(ctr->expCoercedTypeStk, &func->retType);
 		ctr->isPermitArrLit = 1;
-		if (ba_PExp(ctr)) {
+		ctr->tailCallPos = ba_TailCallPos(ctr, func);
+		bool isExp = ba_PExp(ctr);
+		ctr->tailCallPos = 0;
+		if (isExp) {
 			if (func->retType.type == BA_TYPE_VOID) {
 				return ba_ExitMsg(BA_EXIT_ERR, "returning value from func with "
 					"return type 'void' on", line, col, ctr->currPath);
@@ -871,14 +989,7 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 		ctr->isPermitArrLit = 0;
 		ba_StkPop(ctr->expCoercedTypeStk);
 
-		struct ba_SymTable* scope = ctr->currScope;
-		while (scope != func->childScope) {
-			if (scope->hasFramePtrLink) {
-				ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
-				ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
-			}
-			scope = scope->parent;
-		}
+		// The epilogue resets RSP
 		ba_AddIM(ctr, 2, BA_IM_LABELJMP, func->lblEnd);
 		func->doesReturn = 1;
 		return ba_PExpect(';', ctr);
@@ -906,15 +1017,10 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	}
 	// "goto" identifier ";"
 	else if (ba_PAccept(BA_TK_KW_GOTO, ctr)) {
-		u64 lblNameLen = ctr->lex->valLen;
-		char* lblName = 0;
-		if (ctr->lex->val) {
-			lblName = ba_MAlloc(lblNameLen+1);
-			strcpy(lblName, ctr->lex->val);
-		}
+		char* lblName = BA_LEX_VAL(ctr);
 
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
 		if (!ba_PExpect(BA_TK_IDENTIFIER, ctr)) {
 			return 0;
@@ -924,47 +1030,49 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 		struct ba_SymTable* scope = ctr->currScope;
 
 		if (label) {
-			while (scope != label->scope) {
-				if (scope->hasFramePtrLink) {
-					ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSP, BA_IM_RBP);
-					ba_AddIM(ctr, 2, BA_IM_POP, BA_IM_RBP);
-				}
+			while (scope && scope != label->scope) {
 				scope = scope->parent;
 			}
-			(!scope) && ba_ErrorGoto(line, col, ctr->currPath);
+			(!scope || scope->frameScope != ctr->currScope->frameScope) && 
+				ba_ErrorGoto(line, col, ctr->currPath);
+			ba_STAdjStack(ctr, ba_STFrameDataSize(ctr->currScope), 
+				label->frameDataSize);
 			ba_AddIM(ctr, 2, BA_IM_LABELJMP, label->id);
 		}
 		else {
-			ba_AddIM(ctr, 6, BA_IM_GOTO, (u64)lblName, (u64)ctr->currScope, 
-				line, col, (u64)ctr->currPath);
+			struct ba_PGoto* gotoStmt = ba_ArenaAlloc(BA_ARENA_PARSE, 
+				sizeof(*gotoStmt));
+			*gotoStmt = (struct ba_PGoto){ lblName, ctr->currScope, 
+				ba_STFrameDataSize(ctr->currScope), line, col, ctr->currPath };
+			ba_AddIM(ctr, 2, BA_IM_GOTO, (u64)gotoStmt);
 		}
 		
 		return ba_PExpect(';', ctr);
 	}
 	// "include" lit_str { lit_str } ";"
 	else if (ba_PAccept(BA_TK_KW_INCLUDE, ctr)) {
-		u64 len = ctr->lex->valLen;
+		u64 len = BA_LEX_VALLEN(ctr);
 		char* originalFileName = ba_MAlloc(len+1);
-		memcpy(originalFileName, ctr->lex->val, len+1);
+		memcpy(originalFileName, BA_LEX_VAL(ctr), len+1);
 		char* fileName = ba_MAlloc(len+1);
-		memcpy(fileName, ctr->lex->val, len+1);
+		memcpy(fileName, BA_LEX_VAL(ctr), len+1);
 		ba_PExpect(BA_TK_LITSTR, ctr);
 
 		// do-while prevents 1 more str literal from being consumed than needed
 		do {
-			if (ctr->lex->type != BA_TK_LITSTR) {
+			if (BA_LEX_TYPE(ctr) != BA_TK_LITSTR) {
 				break;
 			}
 			u64 oldLen = len;
-			len += ctr->lex->valLen;
+			len += BA_LEX_VALLEN(ctr);
 			
 			if (len > BA_STACK_SIZE) {
-				return ba_ExitMsg2(BA_EXIT_ERR, "string at", ctr->lex->line, 
-					ctr->lex->col, ctr->currPath, " too large to fit on the stack");
+				return ba_ExitMsg2(BA_EXIT_ERR, "string at", BA_LEX_LINE(ctr), 
+					BA_LEX_COL(ctr), ctr->currPath, " too large to fit on the stack");
 			}
 
 			fileName = ba_Realloc(fileName, len+1);
-			memcpy(fileName+oldLen, ctr->lex->val, ctr->lex->valLen);
+			memcpy(fileName+oldLen, BA_LEX_VAL(ctr), BA_LEX_VALLEN(ctr));
 			fileName[len] = 0;
 		}
 		while (ba_PAccept(BA_TK_LITSTR, ctr));
@@ -1030,63 +1138,38 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 					return ba_PExpect(';', ctr);
 				}
 			}
-			ba_PExpect(';', ctr);
-
 			++ctr->inclInodes->cnt;
 			(ctr->inclInodes->cnt > ctr->inclInodes->cap) && 
 				ba_ResizeDynArr64(ctr->inclInodes);
 			ctr->inclInodes->arr[ctr->inclInodes->cnt-1] = inclFileStat.st_ino;
 
-			u64 line = ctr->lex->line;
-			u64 col = ctr->lex->col;
-
-			struct ba_Lexeme* oldNextLex = ctr->lex;
-			ctr->lex = ba_NewLexeme();
-			ba_Tokenize(ctr, includeFile);
-			struct ba_Lexeme* nextLex = ctr->lex;
-			while (nextLex->next) {
-				nextLex = nextLex->next;
-			}
-			nextLex->type = BA_TK_FILECHANGE;
-			nextLex->line = line;
-			nextLex->col = col;
-
-			nextLex->valLen = strlen(ctr->currPath);
-			nextLex->val = ba_MAlloc(nextLex->valLen+1);
-			memcpy(nextLex->val, ctr->currPath, nextLex->valLen+1);
+			// The included file's lexemes come straight after the ';'
+			ba_LexPushFile(ctr, includeFile, fileName);
+			ba_PExpect(';', ctr);
 
-			nextLex->next = oldNextLex;
 			ctr->currPath = fileName;
 			return 1;
 		}
 	}
 	// "struct" ...
 	else if (ba_PAccept(BA_TK_KW_STRUCT, ctr)) {
-		if (!ctr->lex) {
-			return 0;
-		}
-
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
-		u64 idNameLen = ctr->lex->valLen;
-		char* idName = 0;
-		if (ctr->lex->val) {
-			idName = ba_MAlloc(idNameLen+1);
-			strcpy(idName, ctr->lex->val);
-		}
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
+		u64 idNameLen = BA_LEX_VALLEN(ctr);
+		char* idName = BA_LEX_VAL(ctr);
 
 		// ... identifier "{" ...
 		ba_PExpect(BA_TK_IDENTIFIER, ctr);
 		ba_PExpect('{', ctr);
 		
-		struct ba_STVal* idVal = ba_MAlloc(sizeof(*idVal));
-		if (ba_HTGet(ctr->currScope->ht, idName)) {
+		struct ba_STVal* idVal = ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*idVal));
+		if (ba_STGet(ctr->currScope, idName)) {
 			return ba_ErrorVarRedef(idName, line, col, ctr->currPath);
 		}
 		if (ba_STParentFind(ctr->currScope, /* stFoundInPtr = */ 0, idName)) {
 			return ba_ErrorShadow(idName, line, col, ctr->currPath);
 		}
-		ba_HTSet(ctr->currScope->ht, idName, (void*)idVal);
+		ba_STSet(ctr->currScope, idName, (void*)idVal);
 
 		struct ba_Type* extraInfo = ba_MAlloc(sizeof(*extraInfo));
 		*idVal = (struct ba_STVal){
@@ -1113,15 +1196,12 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 		// ... { type identifier ";" } ...
 		while (ba_PPlainType(ctr, /* isInclVoid = */ 0, /* isInclIndefArr = */ 0)) {
 			structMember = structMember->next;
-			line = ctr->lex->line;
-			col = ctr->lex->col;
+			line = BA_LEX_LINE(ctr);
+			col = BA_LEX_COL(ctr);
 
 			struct ba_PTkStkItem* typeTk = ba_StkPop(ctr->pTkStk);
-			idNameLen = ctr->lex->valLen;
-			if (ctr->lex->val) {
-				idName = ba_MAlloc(idNameLen+1);
-				strcpy(idName, ctr->lex->val);
-			}
+			idNameLen = BA_LEX_VALLEN(ctr);
+			idName = BA_LEX_VAL(ctr);
 			
 			ba_PExpect(BA_TK_IDENTIFIER, ctr);
 			ba_PExpect(';', ctr);
@@ -1154,7 +1234,6 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	else if (ba_PFStr(ctr)) {
 		struct ba_PTkStkItem* stkItem = ba_StkPop(ctr->pTkStk);
 		struct ba_FStr* fstr = stkItem->val;
-		free(stkItem);
 		while (fstr) {
 			if (!fstr->formatType) {
 				if (fstr->len) {
@@ -1165,17 +1244,17 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 				bool isFormatNum = fstr->formatType != BA_FTYPE_CHAR && 
 					fstr->formatType != BA_FTYPE_STR;
 
-				struct ba_Lexeme* lex = ctr->lex;
+				u64 lex = ctr->lex;
 				if (fstr->formatType == BA_FTYPE_STR) {
-					ctr->lex = (void*)fstr->len;
+					ctr->lex = fstr->len;
 					ctr->usedRegisters |= BA_CTRREG_RDX | BA_CTRREG_RSI;
 				}
 				else {
-					ctr->lex = fstr->val;
+					ctr->lex = (u64)fstr->val;
 				}
 
-				u64 line = ctr->lex->line;
-				u64 col = ctr->lex->col;
+				u64 line = BA_LEX_LINE(ctr);
+				u64 col = BA_LEX_COL(ctr);
 				ba_PExp(ctr);
 				ctr->lex = lex;
 				stkItem = ba_StkPop(ctr->pTkStk);
@@ -1198,12 +1277,11 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 				if (!isLiteral && isFormatNum) {
 					ba_AddIM(ctr, 4, BA_IM_SUB, BA_IM_RSP, BA_IM_IMM, 
 						fstr->formatType == BA_FTYPE_BIN ? 0x40 : 0x18);
-					ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RSP);
-					ba_POpMovArgToReg(ctr, stkItem, BA_IM_RAX, /* isLiteral = */ 0);
-					if (stkItem->lexemeType == BA_TK_IMREGISTER && val != BA_IM_RAX) {
-						ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RAX, val);
+					ba_POpMovArgToReg(ctr, stkItem, BA_IM_RDI, /* isLiteral = */ 0);
+					if (stkItem->lexemeType == BA_TK_IMREGISTER && val != BA_IM_RDI) {
+						ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDI, val);
 					}
-					ba_AddIM(ctr, 2, BA_IM_PUSH, BA_IM_RAX);
+					ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RSI, BA_IM_RSP);
 				}
 
 				switch (fstr->formatType) {
@@ -1214,6 +1292,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 							}
 							ba_AddIM(ctr, 2, BA_IM_LABELCALL, 
 								ba_BltinLblGet(BA_BLTIN_FormatI64ToStr));
+							ba_AddCallClobbers(ctr, 
+								ba_BltinClobberGet(BA_BLTIN_FormatI64ToStr));
 							break;
 						}
 						str = ba_I64ToStr(val, &len);
@@ -1226,6 +1306,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 							}
 							ba_AddIM(ctr, 2, BA_IM_LABELCALL, 
 								ba_BltinLblGet(BA_BLTIN_FormatU64ToStr));
+							ba_AddCallClobbers(ctr, 
+								ba_BltinClobberGet(BA_BLTIN_FormatU64ToStr));
 							break;
 						}
 						str = ba_U64ToStr(val, &len);
@@ -1238,6 +1320,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 							}
 							ba_AddIM(ctr, 2, BA_IM_LABELCALL, 
 								ba_BltinLblGet(BA_BLTIN_FormatHexToStr));
+							ba_AddCallClobbers(ctr, 
+								ba_BltinClobberGet(BA_BLTIN_FormatHexToStr));
 							break;
 						}
 						str = ba_HexToStr(val, &len);
@@ -1250,6 +1334,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 							}
 							ba_AddIM(ctr, 2, BA_IM_LABELCALL, 
 								ba_BltinLblGet(BA_BLTIN_FormatOctToStr));
+							ba_AddCallClobbers(ctr, 
+								ba_BltinClobberGet(BA_BLTIN_FormatOctToStr));
 							break;
 						}
 						str = ba_OctToStr(val, &len);
@@ -1262,6 +1348,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 							}
 							ba_AddIM(ctr, 2, BA_IM_LABELCALL, 
 								ba_BltinLblGet(BA_BLTIN_FormatBinToStr));
+							ba_AddCallClobbers(ctr, 
+								ba_BltinClobberGet(BA_BLTIN_FormatBinToStr));
 							break;
 						}
 						str = ba_BinToStr(val, &len);
@@ -1296,7 +1384,7 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 						/* The "length" argument has been parsed already, 
 						 * now parse the pointer to the string */
 						lex = ctr->lex;
-						ctr->lex = fstr->val;
+						ctr->lex = (u64)fstr->val;
 						ba_PExp(ctr);
 						ctr->lex = lex;
 						stkItem = ba_StkPop(ctr->pTkStk);
@@ -1327,7 +1415,6 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 						free(str);
 					}
 					else {
-						ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, 0x10);
 						ba_AddIM(ctr, 3, BA_IM_MOV, BA_IM_RDX, BA_IM_RAX);
 						ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RAX, BA_IM_IMM, 1);
 						ba_AddIM(ctr, 4, BA_IM_MOV, BA_IM_RDI, BA_IM_IMM, 1);
@@ -1348,24 +1435,39 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	else if (ba_PScope(ctr, 0)) {
 		return 1;
 	}
-	// ( type | "void" ) identifier ...
-	else if (ba_PPlainType(ctr, /* isInclVoid = */ 1, /* isInclIndefArr = */ 1)) {
+	// "const" type identifier "=" exp ";"
+	else if (ba_PAccept(BA_TK_KW_CONST, ctr)) {
+		return ConstDef(ctr);
+	}
+	// "inline" ( type | "void" ) identifier "(" ...
+	else if (ba_PAccept(BA_TK_KW_INLINE, ctr)) {
+		if (!ba_PPlainType(ctr, /* isInclVoid = */ 1, 
+			/* isInclIndefArr = */ 1)) 
+		{
+			return 0;
+		}
 		struct ba_PTkStkItem* typeTk = ba_StkPop(ctr->pTkStk);
 		struct ba_Type type = *(struct ba_Type*)(typeTk->typeInfo.extraInfo);
 
-		if (!ctr->lex) {
+		char* idName = BA_LEX_VAL(ctr);
+
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
+
+		if (!ba_PExpect(BA_TK_IDENTIFIER, ctr) || !ba_PExpect('(', ctr)) {
 			return 0;
 		}
-		
-		u64 idNameLen = ctr->lex->valLen;
-		char* idName = 0;
-		if (ctr->lex->val) {
-			idName = ba_MAlloc(idNameLen+1);
-			strcpy(idName, ctr->lex->val);
-		}
+		return FuncDef(ctr, idName, line, col, type, /* isInline = */ 1);
+	}
+	// ( type | "void" ) identifier ...
+	else if (ba_PPlainType(ctr, /* isInclVoid = */ 1, /* isInclIndefArr = */ 1)) {
+		struct ba_PTkStkItem* typeTk = ba_StkPop(ctr->pTkStk);
+		struct ba_Type type = *(struct ba_Type*)(typeTk->typeInfo.extraInfo);
 
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		char* idName = BA_LEX_VAL(ctr);
+
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
 		if (!ba_PExpect(BA_TK_IDENTIFIER, ctr)) {
 			return 0;
@@ -1374,7 +1476,8 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 		// Function:
 		// ... "(" ...
 		if (ba_PAccept('(', ctr)) {
-			return FuncDef(ctr, idName, line, col, type);
+			return FuncDef(ctr, idName, line, col, type, 
+				/* isInline = */ 0);
 		}
 
 		// Variable:
@@ -1385,26 +1488,22 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 	else if (ba_PLookAhead(0, BA_TK_IDENTIFIER, ctr) && 
 		ba_PLookAhead(1, ':', ctr))
 	{
-		u64 lblNameLen = ctr->lex->valLen;
-		char* lblName = 0;
-		if (ctr->lex->val) {
-			lblName = ba_MAlloc(lblNameLen+1);
-			strcpy(lblName, ctr->lex->val);
-		}
+		char* lblName = BA_LEX_VAL(ctr);
 
-		u64 line = ctr->lex->line;
-		u64 col = ctr->lex->col;
+		u64 line = BA_LEX_LINE(ctr);
+		u64 col = BA_LEX_COL(ctr);
 
-		ctr->lex = ba_DelLexeme(ctr->lex);
-		ctr->lex = ba_DelLexeme(ctr->lex);
+		ba_PNext(ctr);
+		ba_PNext(ctr);
 
 		if (ba_HTGet(ctr->labelTable, lblName)) {
 			return ba_ErrorVarRedef(lblName, line, col, ctr->currPath);
 		}
 
-		struct ba_PLabel* label = ba_MAlloc(sizeof(*label));
+		struct ba_PLabel* label = ba_ArenaAlloc(BA_ARENA_PARSE, sizeof(*label));
 		label->id = ctr->labelCnt++;
 		label->scope = ctr->currScope;
+		label->frameDataSize = ba_STFrameDataSize(ctr->currScope);
 		ba_AddIM(ctr, 2, BA_IM_LABEL, label->id);
 		ba_HTSet(ctr->labelTable, lblName, label);
 
@@ -1419,7 +1518,6 @@ u8 ba_PStmt(struct ba_Ctr* ctr) {
 			char* str = ((struct ba_Str*)expItem->val)->str;
 			WriteStr(ctr, ((struct ba_Str*)expItem->val)->len, str, 1);
 			free(str);
-			free(expItem);
 		}
 
 		if (!ba_PExpect(';', ctr)) {
@@ -1444,7 +1542,7 @@ u8 ba_PScope(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
 	}
 
 	if (!scope) {
-		ctr->currScope = ba_SymTableAddChild(ctr->currScope);
+		ba_STEnter(ctr, ba_SymTableAddChild(ctr->currScope));
 	}
 
 	while (ba_PStmt(ctr));
@@ -1454,7 +1552,7 @@ u8 ba_PScope(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
 			ba_AddIM(ctr, 4, BA_IM_ADD, BA_IM_RSP, BA_IM_IMM, 
 				ctr->currScope->dataSize);
 		}
-		ctr->currScope = ctr->currScope->parent;
+		ba_STLeave(ctr);
 	}
 
 	return ba_PExpect('}', ctr);
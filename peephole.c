@@ -0,0 +1,430 @@
+// See LICENSE for copyright/license information
+
+#include "peephole.h"
+#include "dataflow.h"
+
+// Most IM a rule looks at
+#define BA_PEEP_WINDOW 4
+// Most IM looked through when checking if a register or the flags are dead
+#define BA_PEEP_SCANLEN 0x40
+// Most passes over the program
+#define BA_PEEP_MAXPASSES 4
+// Most rules applied at one IM before moving on
+#define BA_PEEP_MAXHITS 8
+
+// Deleted IM are kept (with no values) until the end
+#define BA_PEEP_ISDELETED(im) (!(im)->count)
+#define BA_PEEP_DELETE(im) ((im)->count = 0)
+
+#define BA_PEEP_ISGPR(val) (BA_IM_RAX <= (val) && BA_IM_R15 >= (val))
+#define BA_PEEP_ISGPRB(val) (BA_IM_AL <= (val) && BA_IM_R15B >= (val))
+#define BA_PEEP_ISJCC(op) (BA_IM_LABELJZ <= (op) && BA_IM_LABELJGE >= (op))
+#define BA_PEEP_ISSET(op) (BA_IM_SETS <= (op) && BA_IM_SETGE >= (op))
+#define BA_PEEP_ISCMOV(op) (BA_IM_CMOVZ <= (op) && BA_IM_CMOVGE >= (op))
+
+struct ba_PeepPos {
+	struct ba_IMChunk* chunk;
+	struct ba_IM* im;
+};
+
+struct ba_PeepCtx {
+	struct ba_Ctr* ctr;
+	struct ba_PeepPos* labels; // Where each LABEL is
+};
+
+struct ba_PeepRule {
+	char* name;
+	u8 windowSize;
+	bool (*apply)(struct ba_PeepCtx* ctx, struct ba_PeepPos* window);
+	u64 hits;
+};
+
+// ----- Analysis -----
+
+// Position of the next IM that isn't deleted (im is 0 at the end)
+struct ba_PeepPos NextLive(struct ba_PeepPos pos) {
+	do {
+		struct ba_IM* im = ba_IMNext(&pos.chunk, pos.im);
+		pos.im = im;
+	}
+	while (pos.im && BA_PEEP_ISDELETED(pos.im));
+	return pos;
+}
+
+bool FitsImm32(u64 imm) {
+	return (i64)imm >= -(1ll << 31) && (i64)imm < (1ll << 31);
+}
+
+/* Whether reg (or the flags, if reg is -1) is never read after pos before
+ * being written, on any path from pos. Anything that can't be followed
+ * within the budget counts as a read. */
+bool IsDead(struct ba_PeepCtx* ctx, struct ba_PeepPos pos, i64 reg,
+	u64* budget)
+{
+	while (1) {
+		pos = NextLive(pos);
+		if (!pos.im || !*budget) {
+			return 0;
+		}
+		--*budget;
+
+		u64 op = pos.im->vals[0];
+		if (op == BA_IM_LABEL) {
+			continue;
+		}
+		if (op == BA_IM_LABELJMP) {
+			pos = ctx->labels[pos.im->vals[1]];
+			if (!pos.im) {
+				return 0;
+			}
+			continue;
+		}
+		if (BA_PEEP_ISJCC(op) && reg >= 0) {
+			struct ba_PeepPos target = ctx->labels[pos.im->vals[1]];
+			if (!target.im || !IsDead(ctx, target, reg, budget)) {
+				return 0;
+			}
+			continue;
+		}
+
+		u8 use = reg < 0 ? ba_IMFlagUse(pos.im) : ba_IMRegUse(pos.im, reg);
+		if (use) {
+			return use == BA_DF_KILL;
+		}
+	}
+}
+
+bool IsRegDead(struct ba_PeepCtx* ctx, struct ba_PeepPos pos, u64 val) {
+	u64 budget = BA_PEEP_SCANLEN;
+	return IsDead(ctx, pos, ba_IMRegNum(val), &budget);
+}
+
+bool AreFlagsDead(struct ba_PeepCtx* ctx, struct ba_PeepPos pos) {
+	u64 budget = BA_PEEP_SCANLEN;
+	return IsDead(ctx, pos, -1, &budget);
+}
+
+// Whether the flags are dead after a Jcc, both where it jumps and after it
+bool AreFlagsDeadAfterJcc(struct ba_PeepCtx* ctx, struct ba_PeepPos pos) {
+	struct ba_PeepPos target = ctx->labels[pos.im->vals[1]];
+	return target.im && AreFlagsDead(ctx, pos) && AreFlagsDead(ctx, target);
+}
+
+void FindLabels(struct ba_PeepCtx* ctx) {
+	memset(ctx->labels, 0, ctx->ctr->labelCnt * sizeof(*ctx->labels));
+	struct ba_PeepPos pos = { ctx->ctr->startIM->first, 0 };
+	for (pos = NextLive(pos); pos.im; pos = NextLive(pos)) {
+		if (pos.im->vals[0] == BA_IM_LABEL) {
+			ctx->labels[pos.im->vals[1]] = pos;
+		}
+	}
+}
+
+// ----- Rules -----
+
+// JMP/Jcc L, followed by LABEL L (maybe among other labels)
+bool RuleJmpToNext(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* jmp = window[0].im;
+	if (jmp->vals[0] != BA_IM_LABELJMP && !BA_PEEP_ISJCC(jmp->vals[0])) {
+		return 0;
+	}
+	struct ba_PeepPos pos = NextLive(window[0]);
+	for (; pos.im && pos.im->vals[0] == BA_IM_LABEL; pos = NextLive(pos)) {
+		if (pos.im->vals[1] == jmp->vals[1]) {
+			BA_PEEP_DELETE(jmp);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// MOV r, r
+bool RuleMovSelf(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* im = window[0].im;
+	if (im->vals[0] != BA_IM_MOV || im->count != 3 ||
+		im->vals[1] != im->vals[2] || ba_IMRegNum(im->vals[1]) < 0)
+	{
+		return 0;
+	}
+	BA_PEEP_DELETE(im);
+	return 1;
+}
+
+// PUSH a; POP b -> MOV b, a
+bool RulePushPop(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* push = window[0].im;
+	struct ba_IM* pop = window[1].im;
+	if (push->vals[0] != BA_IM_PUSH || pop->vals[0] != BA_IM_POP ||
+		!BA_PEEP_ISGPR(pop->vals[1]) || pop->vals[1] == BA_IM_RSP)
+	{
+		return 0;
+	}
+	if (push->vals[1] == pop->vals[1]) {
+		BA_PEEP_DELETE(push);
+	}
+	else if (BA_PEEP_ISGPR(push->vals[1]) && push->vals[1] != BA_IM_RSP) {
+		*push = (struct ba_IM){ 3, { BA_IM_MOV, pop->vals[1], push->vals[1] } };
+	}
+	else if (push->vals[1] == BA_IM_IMM) {
+		*push = (struct ba_IM){ 4,
+			{ BA_IM_MOV, pop->vals[1], BA_IM_IMM, push->vals[2] } };
+	}
+	else {
+		return 0;
+	}
+	BA_PEEP_DELETE(pop);
+	return 1;
+}
+
+// MOV [m], r; MOV r, [m]
+bool RuleStoreReload(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* store = window[0].im;
+	struct ba_IM* load = window[1].im;
+	u64 cnt = store->count;
+	if (store->vals[0] != BA_IM_MOV || load->vals[0] != BA_IM_MOV ||
+		load->count != cnt || cnt < 4 ||
+		ba_IMRegNum(store->vals[cnt-1]) < 0 ||
+		load->vals[1] != store->vals[cnt-1] ||
+		memcmp(store->vals + 1, load->vals + 2, (cnt - 2) * sizeof(u64)))
+	{
+		return 0;
+	}
+	BA_PEEP_DELETE(load);
+	return 1;
+}
+
+// SETcc b; (MOVZX r, b;) TEST b, b; JZ/JNZ L -> SETcc b; (MOVZX r, b;) Jcc L
+bool RuleSetBranch(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* set = window[0].im;
+	u64 setOp = set->vals[0];
+	// Only conditions with a matching jump
+	if (!(BA_IM_SETZ <= setOp && BA_IM_SETGE >= setOp)) {
+		return 0;
+	}
+
+	u64 testIdx = 1;
+	u64 testReg = set->vals[1];
+	if (window[1].im->vals[0] == BA_IM_MOVZX &&
+		window[1].im->vals[2] == set->vals[1])
+	{
+		testIdx = 2;
+		testReg = window[1].im->vals[1];
+	}
+	struct ba_IM* test = window[testIdx].im;
+	struct ba_PeepPos jccPos = window[testIdx+1];
+	if (!test || !jccPos.im || test->vals[0] != BA_IM_TEST || test->count != 3 ||
+		test->vals[1] != test->vals[2] ||
+		(test->vals[1] != testReg && test->vals[1] != set->vals[1]) ||
+		(jccPos.im->vals[0] != BA_IM_LABELJZ &&
+			jccPos.im->vals[0] != BA_IM_LABELJNZ) ||
+		!AreFlagsDeadAfterJcc(ctx, jccPos))
+	{
+		return 0;
+	}
+
+	// Same order of conditions for SETcc and Jcc
+	u64 jccOp = setOp - BA_IM_SETZ + BA_IM_LABELJZ;
+	if (jccPos.im->vals[0] == BA_IM_LABELJZ) {
+		u64 negations[] = {
+			BA_IM_LABELJNZ, BA_IM_LABELJZ, BA_IM_LABELJAE, BA_IM_LABELJA,
+			BA_IM_LABELJBE, BA_IM_LABELJB, BA_IM_LABELJGE, BA_IM_LABELJG,
+			BA_IM_LABELJLE, BA_IM_LABELJL,
+		};
+		jccOp = negations[jccOp - BA_IM_LABELJZ];
+	}
+	*test = (struct ba_IM){ 2, { jccOp, jccPos.im->vals[1] } };
+	BA_PEEP_DELETE(jccPos.im);
+	return 1;
+}
+
+// MOV r, IMM x; PUSH r -> PUSH IMM x
+bool RuleMovImmPush(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* mov = window[0].im;
+	struct ba_IM* push = window[1].im;
+	if (mov->vals[0] != BA_IM_MOV || mov->vals[2] != BA_IM_IMM ||
+		!BA_PEEP_ISGPR(mov->vals[1]) || push->vals[0] != BA_IM_PUSH ||
+		push->vals[1] != mov->vals[1] || !FitsImm32(mov->vals[3]) ||
+		!IsRegDead(ctx, window[1], mov->vals[1]))
+	{
+		return 0;
+	}
+	*push = (struct ba_IM){ 3, { BA_IM_PUSH, BA_IM_IMM, mov->vals[3] } };
+	BA_PEEP_DELETE(mov);
+	return 1;
+}
+
+// MOV r2, IMM x; OP r1, r2 -> OP r1, IMM x
+bool RuleMovImmOp(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* mov = window[0].im;
+	struct ba_IM* im = window[1].im;
+	u64 op = im->vals[0];
+	u64 reg = mov->vals[1];
+	if (mov->vals[0] != BA_IM_MOV || mov->vals[2] != BA_IM_IMM ||
+		!(op == BA_IM_ADD || op == BA_IM_SUB || op == BA_IM_AND ||
+			op == BA_IM_OR || op == BA_IM_XOR || op == BA_IM_CMP) ||
+		im->count != 3 || im->vals[2] != reg || im->vals[1] == reg)
+	{
+		return 0;
+	}
+	// Both operands GPR or both GPRb
+	bool isGPR = BA_PEEP_ISGPR(reg) && BA_PEEP_ISGPR(im->vals[1]);
+	bool isGPRb = BA_PEEP_ISGPRB(reg) && BA_PEEP_ISGPRB(im->vals[1]);
+	if (!(isGPRb || (isGPR && FitsImm32(mov->vals[3]))) ||
+		!IsRegDead(ctx, window[1], reg))
+	{
+		return 0;
+	}
+	*im = (struct ba_IM){ 4, { op, im->vals[1], BA_IM_IMM, mov->vals[3] } };
+	BA_PEEP_DELETE(mov);
+	return 1;
+}
+
+// MOV r2, IMM x; IMUL r1, r2 -> IMUL r1, r1, IMM x (or nothing for x = 1)
+bool RuleMovImmImul(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* mov = window[0].im;
+	struct ba_IM* imul = window[1].im;
+	u64 reg = mov->vals[1];
+	if (mov->vals[0] != BA_IM_MOV || mov->vals[2] != BA_IM_IMM ||
+		!BA_PEEP_ISGPR(reg) || imul->vals[0] != BA_IM_IMUL ||
+		imul->count != 3 || imul->vals[2] != reg || imul->vals[1] == reg ||
+		!FitsImm32(mov->vals[3]) || !IsRegDead(ctx, window[1], reg))
+	{
+		return 0;
+	}
+	if (mov->vals[3] == 1 && AreFlagsDead(ctx, window[1])) {
+		BA_PEEP_DELETE(imul);
+	}
+	else {
+		*imul = (struct ba_IM){ 5,
+			{ BA_IM_IMUL, imul->vals[1], imul->vals[1], BA_IM_IMM, mov->vals[3] } };
+	}
+	BA_PEEP_DELETE(mov);
+	return 1;
+}
+
+// MOV r, IMM x; MOV [m], r -> MOV QWORD [m], IMM x
+bool RuleMovImmStore(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* mov = window[0].im;
+	struct ba_IM* store = window[1].im;
+	u64 reg = mov->vals[1];
+	u64 adr = store->vals[1];
+	u64 cnt = store->count;
+	if (mov->vals[0] != BA_IM_MOV || mov->vals[2] != BA_IM_IMM ||
+		!BA_PEEP_ISGPR(reg) || store->vals[0] != BA_IM_MOV ||
+		!(adr == BA_IM_ADR || adr == BA_IM_ADRADD || adr == BA_IM_ADRSUB) ||
+		store->vals[cnt-1] != reg || store->vals[2] == reg ||
+		!FitsImm32(mov->vals[3]) || !IsRegDead(ctx, window[1], reg))
+	{
+		return 0;
+	}
+	(adr == BA_IM_ADR && (store->vals[1] = BA_IM_64ADR)) ||
+	(adr == BA_IM_ADRADD && (store->vals[1] = BA_IM_64ADRADD)) ||
+	(adr == BA_IM_ADRSUB && (store->vals[1] = BA_IM_64ADRSUB));
+	store->vals[cnt-1] = BA_IM_IMM;
+	store->vals[cnt] = mov->vals[3];
+	++store->count;
+	BA_PEEP_DELETE(mov);
+	return 1;
+}
+
+// MOV/MOVZX/LEA/SETcc to a register that is never read
+bool RuleDeadWrite(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* im = window[0].im;
+	u64 op = im->vals[0];
+	u64 reg = im->vals[1];
+	if (!(op == BA_IM_MOV || op == BA_IM_MOVZX || op == BA_IM_LEA ||
+		BA_PEEP_ISSET(op)) || ba_IMRegNum(reg) < 0 ||
+		ba_IMRegNum(reg) == BA_IM_RSP - BA_IM_RAX ||
+		ba_IMRegNum(reg) == BA_IM_RBP - BA_IM_RAX ||
+		!IsRegDead(ctx, window[0], reg))
+	{
+		return 0;
+	}
+	BA_PEEP_DELETE(im);
+	return 1;
+}
+
+// MOV r, IMM 0 -> XOR r, r
+bool RuleZeroXor(struct ba_PeepCtx* ctx, struct ba_PeepPos* window) {
+	struct ba_IM* im = window[0].im;
+	if (im->vals[0] != BA_IM_MOV || !BA_PEEP_ISGPR(im->vals[1]) ||
+		im->vals[2] != BA_IM_IMM || im->vals[3] ||
+		!AreFlagsDead(ctx, window[0]))
+	{
+		return 0;
+	}
+	*im = (struct ba_IM){ 3, { BA_IM_XOR, im->vals[1], im->vals[1] } };
+	return 1;
+}
+
+// Tried in order, the first rule that applies at an IM is used
+struct ba_PeepRule peepRules[] = {
+	{ "jmp-to-next",   1, RuleJmpToNext,   0 },
+	{ "mov-self",      1, RuleMovSelf,     0 },
+	{ "push-pop",      2, RulePushPop,     0 },
+	{ "store-reload",  2, RuleStoreReload, 0 },
+	{ "set-branch",    3, RuleSetBranch,   0 },
+	{ "mov-imm-push",  2, RuleMovImmPush,  0 },
+	{ "mov-imm-op",    2, RuleMovImmOp,    0 },
+	{ "mov-imm-imul",  2, RuleMovImmImul,  0 },
+	{ "mov-imm-store", 2, RuleMovImmStore, 0 },
+	{ "dead-write",    1, RuleDeadWrite,   0 },
+	{ "zero-xor",      1, RuleZeroXor,     0 },
+};
+
+#define BA_PEEP_RULECNT (sizeof(peepRules) / sizeof(*peepRules))
+
+// ----- Pass -----
+
+void ba_Peephole(struct ba_Ctr* ctr) {
+	struct ba_PeepCtx ctx = { ctr,
+		ba_MAlloc((ctr->labelCnt + 1) * sizeof(struct ba_PeepPos)) };
+
+	bool isChanged = 1;
+	for (u64 pass = 0; isChanged && pass < BA_PEEP_MAXPASSES; pass++) {
+		isChanged = 0;
+		FindLabels(&ctx);
+
+		struct ba_PeepPos pos = { ctr->startIM->first, 0 };
+		pos = NextLive(pos);
+		u64 hitCnt = 0;
+		while (pos.im) {
+			struct ba_PeepPos window[BA_PEEP_WINDOW] = { 0 };
+			u64 windowCnt = 0;
+			for (struct ba_PeepPos p = pos; p.im && windowCnt < BA_PEEP_WINDOW;
+				p = NextLive(p))
+			{
+				window[windowCnt++] = p;
+			}
+
+			bool isHit = 0;
+			for (u64 i = 0; i < BA_PEEP_RULECNT && hitCnt < BA_PEEP_MAXHITS; i++) {
+				struct ba_PeepRule* rule = &peepRules[i];
+				if (rule->windowSize <= windowCnt && rule->apply(&ctx, window)) {
+					++rule->hits;
+					isHit = 1;
+					break;
+				}
+			}
+			isChanged |= isHit;
+
+			// Look at the same IM again if a rule changed it
+			if (isHit && !BA_PEEP_ISDELETED(pos.im)) {
+				++hitCnt;
+				continue;
+			}
+			hitCnt = 0;
+			pos = NextLive(pos);
+		}
+	}
+
+	ba_CompactIM(ctr);
+	free(ctx.labels);
+}
+
+void ba_PeepholePrintStats(FILE* file) {
+	for (u64 i = 0; i < BA_PEEP_RULECNT; i++) {
+		fprintf(file, "peephole: %-14s %llu\n", peepRules[i].name,
+			peepRules[i].hits);
+	}
+}
@@ -0,0 +1,15 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__PEEPHOLE_H
+#define BA__PEEPHOLE_H
+
+#include "common/ctr.h"
+
+/* Rewrites short sequences of IM into shorter or cheaper ones, using a list
+ * of rules that each look at a window of IM at a time. Runs over the whole
+ * program, so functions must already be emplaced (ba_EmplaceIM). */
+
+void ba_Peephole(struct ba_Ctr* ctr);
+void ba_PeepholePrintStats(FILE* file);
+
+#endif
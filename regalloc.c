@@ -0,0 +1,266 @@
+// See LICENSE for copyright/license information
+
+#include "regalloc.h"
+#include "common/reg.h"
+#include "common/func.h"
+
+// Registers that variables can be kept in, in the order they are given out
+u64 varRegs[BA_REGVAR_CNT] =
+	{ BA_IM_RBX, BA_IM_R12, BA_IM_R13, BA_IM_R14, BA_IM_R15 };
+
+bool IsGPR64(u64 val) {
+	return val >= BA_IM_RAX && val <= BA_IM_R15 && val != BA_IM_RSP &&
+		val != BA_IM_RBP;
+}
+
+bool IsRbpAdr(struct ba_IM* im, u64 idx) {
+	return (im->vals[idx] == BA_IM_ADRADD || im->vals[idx] == BA_IM_ADRSUB) &&
+		im->vals[idx+1] == BA_IM_RBP;
+}
+
+// Bit (1 << register number) for a GPR or GPRb, otherwise 0
+u64 RegBit(u64 val) {
+	if (val >= BA_IM_RAX && val <= BA_IM_R15) {
+		return 1llu << (val - BA_IM_RAX);
+	}
+	if (val >= BA_IM_AL && val <= BA_IM_R15B) {
+		return 1llu << (val - BA_IM_AL);
+	}
+	return 0;
+}
+
+// Registers used in any way by im, as RegBit bits
+u64 RegsInIM(struct ba_IM* im) {
+	u64 op = im->vals[0];
+	if (op == BA_IM_LABEL || op == BA_IM_LABELCALL || op == BA_IM_GOTO ||
+		op == BA_IM_REGHINT || (op >= BA_IM_LABELJMP && op <= BA_IM_LABELJGE))
+	{
+		return 0;
+	}
+
+	u64 regs = 0;
+	for (u64 i = 1; i < im->count; i++) {
+		u64 val = im->vals[i];
+		if (val == BA_IM_IMM || val == BA_IM_STATIC) {
+			++i;
+		}
+		else if (val == BA_IM_ADRADD || val == BA_IM_ADRSUB ||
+			val == BA_IM_64ADRADD || val == BA_IM_64ADRSUB)
+		{
+			regs |= RegBit(im->vals[i+1]);
+			i += 2;
+		}
+		else if (val == BA_IM_ADRADDREGMUL) {
+			regs |= RegBit(im->vals[i+1]) | RegBit(im->vals[i+3]);
+			i += 3;
+		}
+		else {
+			regs |= RegBit(val);
+		}
+	}
+	return regs;
+}
+
+// MOV r64, [RBP+ofs] or MOV [RBP+ofs], r64
+bool IsVarMov(struct ba_IM* im) {
+	return im && im->vals[0] == BA_IM_MOV && im->count == 5 &&
+		((IsGPR64(im->vals[1]) && IsRbpAdr(im, 2)) ||
+		(IsRbpAdr(im, 1) && IsGPR64(im->vals[4])));
+}
+
+/* Allocates registers for the variables of one func or of the main program,
+ * whose IM runs from start (in chunk) to the end of buf */
+void AllocRegion(struct ba_Ctr* ctr, struct ba_IMBuf* buf,
+	struct ba_IMChunk* chunk, struct ba_IM* start)
+{
+	// Find the variables declared here, and the registers that are used
+	struct ba_DynArr64* cands = ba_NewDynArr64(0x10);
+	u64 usedRegs = 0;
+	u64 regUseCnts[16] = {0};
+	bool hasCall = 0;
+	struct ba_STVal* argVars[16] = {0};
+	struct ba_IMChunk* imChunk = chunk;
+	for (struct ba_IM* im = start; im; im = ba_IMNext(&imChunk, im)) {
+		if (im->vals[0] != BA_IM_REGHINT) {
+			u64 op = im->vals[0];
+			u64 regs = RegsInIM(im);
+			(op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV ||
+				op == BA_IM_CQO || (op == BA_IM_IMUL && im->count == 2)) && 
+				(regs |= RegBit(BA_IM_RAX) | RegBit(BA_IM_RDX));
+			hasCall |= op == BA_IM_LABELCALL || op == BA_IM_SYSCALL;
+			usedRegs |= regs;
+			for (u64 i = 0; i < 16; i++) {
+				regUseCnts[i] += (regs >> i) & 1;
+			}
+			continue;
+		}
+
+		struct ba_STVal* var = (void*)im->vals[2];
+		struct ba_IMChunk* nextChunk = imChunk;
+		struct ba_IM* next = ba_IMNext(&nextChunk, im);
+		switch (im->vals[1]) {
+			case BA_REGHINT_DECL:
+				if (!next || next->vals[0] != BA_IM_PUSH ||
+					!IsGPR64(next->vals[1]))
+				{
+					var->isMemOnly = 1;
+				}
+				else {
+					argVars[next->vals[1] - BA_IM_RAX] = var;
+				}
+				// Fall through
+			case BA_REGHINT_PARAM:
+				(cands->cnt == cands->cap) && ba_ResizeDynArr64(cands);
+				cands->arr[cands->cnt++] = (u64)var;
+				break;
+			case BA_REGHINT_ACCESS:
+				// e.g. the address is taken
+				!IsVarMov(next) && (var->isMemOnly = 1);
+				break;
+		}
+		var && (var->regWeight += im->vals[3]);
+	}
+
+	/* A param passed in a register can stay there if nothing else in the 
+	 * region uses it (its push is the only use) and there are no calls */
+	for (u64 i = 0; i < 16; i++) {
+		struct ba_STVal* var = argVars[i];
+		if (var && !hasCall && regUseCnts[i] == 1 && !var->isMemOnly) {
+			var->reg = BA_IM_RAX + i;
+		}
+	}
+
+	// Give free registers to the most used variables
+	u64 savedRegs[BA_REGVAR_CNT];
+	u64 savedCnt = 0;
+	for (u64 i = 0; i < BA_REGVAR_CNT; i++) {
+		if (usedRegs & RegBit(varRegs[i])) {
+			continue;
+		}
+		struct ba_STVal* best = 0;
+		for (u64 j = 0; j < cands->cnt; j++) {
+			struct ba_STVal* var = (void*)cands->arr[j];
+			if (!var->isMemOnly && !var->reg &&
+				(!best || var->regWeight > best->regWeight))
+			{
+				best = var;
+			}
+		}
+		if (!best) {
+			break;
+		}
+		best->reg = varRegs[i];
+		savedRegs[savedCnt++] = varRegs[i];
+	}
+
+	// Rewrite into a new buffer, since saving registers adds IM
+	struct ba_IMBuf* newBuf = ba_NewIMBuf();
+	bool isInRegion = 0;
+	struct ba_STVal* accessVar = 0;
+	imChunk = buf->first;
+	for (struct ba_IM* im = ba_IMNext(&imChunk, 0); im;
+		im = ba_IMNext(&imChunk, im))
+	{
+		(im == start) && (isInRegion = 1);
+		if (!isInRegion) {
+			*ba_IMBufAdd(newBuf) = *im;
+			continue;
+		}
+
+		if (accessVar) {
+			struct ba_IM* newIM = ba_IMBufAdd(newBuf);
+			*newIM = (struct ba_IM){ 3, { BA_IM_MOV,
+				IsGPR64(im->vals[1]) ? im->vals[1] : accessVar->reg,
+				IsGPR64(im->vals[1]) ? accessVar->reg : im->vals[4] } };
+			(im == ctr->entryIM) && (ctr->entryIM = newIM);
+			accessVar = 0;
+			continue;
+		}
+
+		if (im->vals[0] != BA_IM_REGHINT) {
+			struct ba_IM* newIM = ba_IMBufAdd(newBuf);
+			*newIM = *im;
+			(im == ctr->entryIM) && (ctr->entryIM = newIM);
+			continue;
+		}
+
+		struct ba_STVal* var = (void*)im->vals[2];
+		struct ba_IMChunk* nextChunk = imChunk;
+		struct ba_IM* next = ba_IMNext(&nextChunk, im);
+		switch (im->vals[1]) {
+			case BA_REGHINT_DECL:
+				var->reg && var->reg != next->vals[1] && 
+					(*ba_IMBufAdd(newBuf) = (struct ba_IM){ 3,
+					{ BA_IM_MOV, var->reg, next->vals[1] } }, 1);
+				break;
+			case BA_REGHINT_PARAM:
+			{
+				if (!var->reg) {
+					break;
+				}
+				i64 offset = -var->address;
+				*ba_IMBufAdd(newBuf) = (struct ba_IM){ 5, { BA_IM_MOV,
+					var->reg, offset < 0 ? BA_IM_ADRSUB : BA_IM_ADRADD,
+					BA_IM_RBP, offset < 0 ? -offset : offset } };
+				break;
+			}
+			case BA_REGHINT_ACCESS:
+				var->reg && (accessVar = var);
+				break;
+			// Save area is above the dynamic and static links
+			case BA_REGHINT_SAVE:
+				for (u64 i = 0; i < savedCnt; i++) {
+					*ba_IMBufAdd(newBuf) = (struct ba_IM){ 5, { BA_IM_MOV,
+						BA_IM_ADRADD, BA_IM_RBP, 0x10 + 8 * i, savedRegs[i] } };
+				}
+				break;
+			case BA_REGHINT_RESTORE:
+				for (u64 i = 0; i < savedCnt; i++) {
+					*ba_IMBufAdd(newBuf) = (struct ba_IM){ 5, { BA_IM_MOV,
+						savedRegs[i], BA_IM_ADRADD, BA_IM_RBP, 0x10 + 8 * i } };
+				}
+				break;
+		}
+	}
+
+	buf->first = newBuf->first;
+	buf->last = newBuf->last;
+
+	// An inlined func shares its variables with the funcs it is copied into
+	for (u64 i = 0; i < cands->cnt; i++) {
+		struct ba_STVal* var = (void*)cands->arr[i];
+		var->reg = 0;
+		var->regWeight = 0;
+	}
+	ba_DelDynArr64(cands);
+}
+
+void AllocFuncRegs(struct ba_Ctr* ctr, struct ba_SymTable* scope) {
+	u64 entryCnt = 0;
+	struct ba_HTEntry* entries = ba_STEntries(scope, &entryCnt);
+	for (u64 i = 0; i < entryCnt; i++) {
+		struct ba_STVal* val = (struct ba_STVal*)entries[i].val;
+		if (val && entries[i].key && val->type.type == BA_TYPE_FUNC) {
+			struct ba_Func* func = val->type.extraInfo;
+			if (func->isCalled) {
+				struct ba_IMChunk* chunk = func->im->first;
+				AllocRegion(ctr, func->im, chunk, ba_IMNext(&chunk, 0));
+			}
+		}
+	}
+	for (u64 i = 0; i < scope->childCnt; ++i) {
+		AllocFuncRegs(ctr, scope->children[i]);
+	}
+}
+
+void ba_AllocVarRegs(struct ba_Ctr* ctr) {
+	// The main program starts after any builtins
+	struct ba_IMChunk* chunk = ctr->startIM->first;
+	while (ctr->entryIM < chunk->ims ||
+		ctr->entryIM >= chunk->ims + BA_IM_CHUNK_SIZE)
+	{
+		chunk = chunk->next;
+	}
+	AllocRegion(ctr, ctr->startIM, chunk, ctr->entryIM);
+	AllocFuncRegs(ctr, ctr->globalST);
+}
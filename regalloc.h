@@ -0,0 +1,17 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__REGALLOC_H
+#define BA__REGALLOC_H
+
+#include "common/ctr.h"
+
+/* Keeps the most used 64-bit integer variables of each func (and of the main
+ * program) in the registers of BA_CTRREG_VARS instead of on the stack, or
+ * args in the registers they were passed in, if those are free. When
+ * optimizing, the parser marks declarations and uses of variables with
+ * REGHINT IM, which this replaces or removes. Runs before funcs are
+ * emplaced (ba_EmplaceIM). */
+
+void ba_AllocVarRegs(struct ba_Ctr* ctr);
+
+#endif
@@ -0,0 +1,626 @@
+// See LICENSE for copyright/license information
+
+#include "ssa.h"
+
+// Registers that are followed (all except RSP and RBP)
+#define BA_SSA_REGS 0xffcfllu
+// Registers that funcs must preserve (RBX, RBP, R12 - R15)
+#define BA_SSA_CALLEESAVED 0xf028llu
+
+#define BA_SSA_ISGPR(val) (BA_IM_RAX <= (val) && BA_IM_R15 >= (val))
+#define BA_SSA_ISGPRB(val) (BA_IM_AL <= (val) && BA_IM_R15B >= (val))
+#define BA_SSA_ISJCC(op) (BA_IM_LABELJZ <= (op) && BA_IM_LABELJGE >= (op))
+#define BA_SSA_ISCMOV(op) (BA_IM_CMOVZ <= (op) && BA_IM_CMOVGE >= (op))
+// Whether val is a followed 64 bit register
+#define BA_SSA_ISREG(val) (BA_SSA_ISGPR(val) && \
+	((BA_SSA_REGS >> ((val) - BA_IM_RAX)) & 1))
+
+u64 ssaValueCnt = 0;
+u64 ssaPhiCnt = 0;
+u64 ssaMovCnt = 0;
+u64 ssaCopyCnt = 0;
+
+void SSAPush(struct ba_DynArr64* da, u64 val) {
+	(da->cnt == da->cap) && ba_ResizeDynArr64(da);
+	da->arr[da->cnt++] = val;
+}
+
+// ----- Instructions -----
+
+// Index in im->vals after the operand at idx
+u64 SSANextOpnd(struct ba_IM* im, u64 idx) {
+	u64 val = im->vals[idx];
+	if (val == BA_IM_IMM || val == BA_IM_STATIC || val == BA_IM_ADR ||
+		val == BA_IM_64ADR)
+	{
+		return idx + 2;
+	}
+	if (val == BA_IM_ADRADDREGMUL) {
+		return idx + 4;
+	}
+	if (val >= BA_IM_ADRADD && val <= BA_IM_64ADRSUB) {
+		return idx + 3;
+	}
+	return idx + 1;
+}
+
+// Registers written by im
+u64 SSADefMask(struct ba_IM* im) {
+	u64 op = im->vals[0];
+	if (op == BA_IM_NOP || op == BA_IM_LABEL || op == BA_IM_LABELJMP ||
+		BA_SSA_ISJCC(op) || op == BA_IM_RET || op == BA_IM_CMP ||
+		op == BA_IM_TEST || op == BA_IM_PUSH)
+	{
+		return 0;
+	}
+	if (op == BA_IM_LABELCALL) {
+		return BA_SSA_REGS & ~BA_SSA_CALLEESAVED;
+	}
+	if (op == BA_IM_SYSCALL) {
+		return (1llu << 0) | (1llu << 1) | (1llu << 11);
+	}
+	if (op == BA_IM_CQO) {
+		return 1llu << 2;
+	}
+	if (op == BA_IM_MUL || op == BA_IM_DIV || op == BA_IM_IDIV ||
+		(op == BA_IM_IMUL && im->count == 2))
+	{
+		return (1llu << 0) | (1llu << 2);
+	}
+	// Not understood, so any register may have been written
+	if (op < BA_IM_MOV || op > BA_IM_CMOVGE || im->count < 2) {
+		return BA_SSA_REGS;
+	}
+	i64 reg = ba_IMRegNum(im->vals[1]);
+	return reg >= 0 ? (1llu << reg) & BA_SSA_REGS : 0;
+}
+
+/* Whether the register at vals[idx] of im, its opndIdx'th operand, is only
+ * read, so that any register holding the same value can be used instead */
+bool IsSSASrcOpnd(struct ba_IM* im, u64 idx, u64 opndIdx) {
+	u64 op = im->vals[0];
+	if (!BA_SSA_ISREG(im->vals[idx])) {
+		return 0;
+	}
+	if (!opndIdx) {
+		return op == BA_IM_CMP || op == BA_IM_TEST || op == BA_IM_PUSH;
+	}
+	// Zeroing idioms
+	if ((op == BA_IM_XOR || op == BA_IM_SUB) &&
+		im->vals[1] == im->vals[idx])
+	{
+		return 0;
+	}
+	return op == BA_IM_MOV || op == BA_IM_ADD || op == BA_IM_SUB ||
+		op == BA_IM_AND || op == BA_IM_OR || op == BA_IM_XOR ||
+		op == BA_IM_CMP || op == BA_IM_TEST ||
+		(op == BA_IM_IMUL && im->count > 2) || BA_SSA_ISCMOV(op);
+}
+
+// ----- Values -----
+
+u64 SSANewValue(struct ba_SSA* ssa, u8 kind, u64 reg, u64 node) {
+	if (ssa->valueCnt == ssa->valueCap) {
+		ssa->valueCap <<= 1;
+		ssa->values = ba_Realloc(ssa->values,
+			ssa->valueCap * sizeof(*ssa->values));
+	}
+	u64 val = ssa->valueCnt++;
+	ssa->values[val] = (struct ba_SSAValue){ .kind = kind, .width = 64,
+		.reg = reg, .node = node, .src = val };
+	++ssaValueCnt;
+	return val;
+}
+
+// Value that val is a copy of, or is otherwise known to be equal to
+u64 ba_SSARoot(struct ba_SSA* ssa, u64 val) {
+	while (ssa->values[val].src != val) {
+		val = ssa->values[val].src;
+	}
+	return val;
+}
+
+// Whether lhs and rhs always hold the same number
+bool ba_SSAIsSame(struct ba_SSA* ssa, u64 lhs, u64 rhs) {
+	lhs = ba_SSARoot(ssa, lhs);
+	rhs = ba_SSARoot(ssa, rhs);
+	struct ba_SSAValue* lv = &ssa->values[lhs];
+	struct ba_SSAValue* rv = &ssa->values[rhs];
+	return lhs == rhs || (lv->kind == BA_SSA_CONST &&
+		rv->kind == BA_SSA_CONST && lv->imm == rv->imm);
+}
+
+// Defines the values written by inst, given what is in the registers
+void SSADefine(struct ba_SSA* ssa, struct ba_SSAInst* inst, u64 node,
+	u64* regs)
+{
+	struct ba_IM* im = inst->im;
+	u64 op = im->vals[0];
+	i64 dst = im->count >= 2 ? ba_IMRegNum(im->vals[1]) : -1;
+	for (u64 reg = 0; reg < 16; reg++) {
+		if (!(inst->defMask & (1llu << reg))) {
+			continue;
+		}
+		u64 val = SSANewValue(ssa, BA_SSA_DEF, reg, node);
+		struct ba_SSAValue* value = &ssa->values[val];
+		// Registers written implicitly only get new values
+		bool isDst = dst == (i64)reg;
+		if (isDst && BA_SSA_ISGPRB(im->vals[1])) {
+			value->width = 8;
+		}
+		else if (isDst && op == BA_IM_MOV && im->count == 3 &&
+			BA_SSA_ISREG(im->vals[2]))
+		{
+			value->kind = BA_SSA_COPY;
+			value->src = regs[im->vals[2] - BA_IM_RAX];
+		}
+		else if (isDst && op == BA_IM_MOV && im->count == 4 &&
+			im->vals[2] == BA_IM_IMM)
+		{
+			value->kind = BA_SSA_CONST;
+			value->imm = im->vals[3];
+		}
+		else if (isDst && (op == BA_IM_XOR || op == BA_IM_SUB) &&
+			im->count == 3 && im->vals[1] == im->vals[2])
+		{
+			value->kind = BA_SSA_CONST;
+		}
+		SSAPush(ssa->ops, val);
+		regs[reg] = val;
+	}
+}
+
+// ----- Construction -----
+
+// Reverse postorder of the nodes reachable from the root
+void SSAOrder(struct ba_SSA* ssa, u64* succStarts, u64* succs) {
+	u64 nodeCnt = ssa->root + 1;
+	bool* isSeen = ba_CAlloc(nodeCnt, sizeof(*isSeen));
+	u64* stk = ba_MAlloc(nodeCnt * sizeof(*stk));
+	u64* nexts = ba_MAlloc(nodeCnt * sizeof(*nexts));
+	u64 post = nodeCnt;
+	u64 stkCnt = 0;
+	stk[stkCnt++] = ssa->root;
+	nexts[ssa->root] = succStarts[ssa->root];
+	isSeen[ssa->root] = 1;
+	while (stkCnt) {
+		u64 node = stk[stkCnt-1];
+		if (nexts[node] == succStarts[node+1]) {
+			ssa->order[--post] = node;
+			--stkCnt;
+			continue;
+		}
+		u64 succ = succs[nexts[node]++];
+		if (!isSeen[succ]) {
+			isSeen[succ] = 1;
+			nexts[succ] = succStarts[succ];
+			stk[stkCnt++] = succ;
+		}
+	}
+	// Move the order to the start if some nodes weren't reached
+	ssa->orderCnt = nodeCnt - post;
+	memmove(ssa->order, ssa->order + post,
+		ssa->orderCnt * sizeof(*ssa->order));
+	free(nexts);
+	free(stk);
+	free(isSeen);
+}
+
+// Immediate dominators (Cooper, Harvey and Kennedy)
+void SSADominators(struct ba_SSA* ssa) {
+	u64 nodeCnt = ssa->root + 1;
+	i64* nums = ba_MAlloc(nodeCnt * sizeof(*nums));
+	for (u64 i = 0; i < nodeCnt; i++) {
+		nums[i] = -1;
+		ssa->idoms[i] = -1;
+	}
+	for (u64 i = 0; i < ssa->orderCnt; i++) {
+		nums[ssa->order[i]] = i;
+	}
+	ssa->idoms[ssa->root] = ssa->root;
+
+	bool isChanged = 1;
+	while (isChanged) {
+		isChanged = 0;
+		for (u64 i = 1; i < ssa->orderCnt; i++) {
+			u64 node = ssa->order[i];
+			i64 idom = -1;
+			for (u64 j = ssa->predStarts[node]; j < ssa->predStarts[node+1];
+				j++)
+			{
+				i64 pred = ssa->preds[j];
+				if (ssa->idoms[pred] < 0) {
+					continue;
+				}
+				if (idom < 0) {
+					idom = pred;
+					continue;
+				}
+				while (idom != pred) {
+					while (nums[idom] > nums[pred]) {
+						idom = ssa->idoms[idom];
+					}
+					while (nums[pred] > nums[idom]) {
+						pred = ssa->idoms[pred];
+					}
+				}
+			}
+			if (idom != ssa->idoms[node]) {
+				ssa->idoms[node] = idom;
+				isChanged = 1;
+			}
+		}
+	}
+	free(nums);
+}
+
+/* Places phis for each register at the iterated dominance frontier of the
+ * nodes that write it */
+void SSAPlacePhis(struct ba_SSA* ssa) {
+	u64 nodeCnt = ssa->root + 1;
+	u64* defMasks = ba_CAlloc(nodeCnt, sizeof(*defMasks));
+	defMasks[ssa->root] = BA_SSA_REGS;
+	struct ba_DFGraph* graph = ssa->graph;
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		for (u64 j = graph->blocks[i].start; j < graph->blocks[i].end; j++) {
+			defMasks[i] |= ssa->insts[j].defMask;
+		}
+	}
+
+	// Pairs of a node and a node in its dominance frontier
+	struct ba_DynArr64* frontiers = ba_NewDynArr64(0x100);
+	for (u64 i = 1; i < ssa->orderCnt; i++) {
+		u64 node = ssa->order[i];
+		if (ssa->predStarts[node+1] - ssa->predStarts[node] < 2) {
+			continue;
+		}
+		for (u64 j = ssa->predStarts[node]; j < ssa->predStarts[node+1];
+			j++)
+		{
+			for (i64 runner = ssa->preds[j];
+				ssa->idoms[runner] >= 0 && runner != ssa->idoms[node];
+				runner = ssa->idoms[runner])
+			{
+				SSAPush(frontiers, runner);
+				SSAPush(frontiers, node);
+			}
+		}
+	}
+
+	bool isChanged = 1;
+	while (isChanged) {
+		isChanged = 0;
+		for (u64 i = 0; i < frontiers->cnt; i += 2) {
+			u64 node = frontiers->arr[i];
+			u64 frontier = frontiers->arr[i+1];
+			u64 phis = ssa->phiMasks[frontier] |
+				defMasks[node] | ssa->phiMasks[node];
+			if (phis != ssa->phiMasks[frontier]) {
+				ssa->phiMasks[frontier] = phis;
+				isChanged = 1;
+			}
+		}
+	}
+
+	ba_DelDynArr64(frontiers);
+	free(defMasks);
+}
+
+/* Finds values that phis are equal to, where every pred gives the same value
+ * (or the phi itself) */
+void SSAResolvePhis(struct ba_SSA* ssa) {
+	bool isChanged = 1;
+	while (isChanged) {
+		isChanged = 0;
+		for (u64 val = 0; val < ssa->valueCnt; val++) {
+			struct ba_SSAValue* value = &ssa->values[val];
+			if (value->kind != BA_SSA_PHI || value->src != val) {
+				continue;
+			}
+			u64 predCnt = ssa->predStarts[value->node+1] -
+				ssa->predStarts[value->node];
+			i64 same = -1;
+			for (u64 i = 0; i < predCnt; i++) {
+				u64 arg = ba_SSARoot(ssa, ssa->args->arr[value->args+i]);
+				if (arg == val) {
+					continue;
+				}
+				if (same >= 0 && !ba_SSAIsSame(ssa, same, arg)) {
+					same = -1;
+					break;
+				}
+				same = arg;
+			}
+			if (same >= 0) {
+				value->src = same;
+				isChanged = 1;
+			}
+		}
+	}
+}
+
+struct ba_SSA* ba_NewSSA(struct ba_Ctr* ctr) {
+	struct ba_SSA* ssa = ba_CAlloc(1, sizeof(*ssa));
+	struct ba_DFGraph* graph = ba_NewDFGraph(ctr);
+	ssa->graph = graph;
+	ssa->root = graph->blockCnt;
+	u64 nodeCnt = ssa->root + 1;
+
+	// The root comes before the program and each func that is called
+	bool* isEntries = ba_CAlloc(nodeCnt, sizeof(*isEntries));
+	graph->blockCnt && (isEntries[graph->entry] = 1);
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		for (u64 j = block->start; block->isReachable && j < block->end; j++) {
+			struct ba_IM* im = graph->ims[j];
+			if (im->vals[0] == BA_IM_LABELCALL &&
+				im->vals[1] <= ctr->labelCnt &&
+				graph->labelBlocks[im->vals[1]] >= 0)
+			{
+				isEntries[graph->labelBlocks[im->vals[1]]] = 1;
+			}
+		}
+	}
+
+	// Successors and preds of each node
+	u64* succStarts = ba_CAlloc(nodeCnt + 1, sizeof(*succStarts));
+	ssa->predStarts = ba_CAlloc(nodeCnt + 1, sizeof(*ssa->predStarts));
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		for (u64 j = 0; block->isReachable && j < 2; j++) {
+			if (block->succs[j] >= 0) {
+				++succStarts[i+1];
+				++ssa->predStarts[block->succs[j]+1];
+			}
+		}
+		if (isEntries[i]) {
+			++succStarts[ssa->root+1];
+			++ssa->predStarts[i+1];
+		}
+	}
+	for (u64 i = 0; i < nodeCnt; i++) {
+		succStarts[i+1] += succStarts[i];
+		ssa->predStarts[i+1] += ssa->predStarts[i];
+	}
+	u64* succs = ba_MAlloc((succStarts[nodeCnt] + 1) * sizeof(*succs));
+	ssa->preds = ba_MAlloc((succStarts[nodeCnt] + 1) * sizeof(*ssa->preds));
+	u64* succCnts = ba_CAlloc(nodeCnt, sizeof(*succCnts));
+	u64* predCnts = ba_CAlloc(nodeCnt, sizeof(*predCnts));
+	for (u64 i = 0; i < graph->blockCnt; i++) {
+		struct ba_DFBlock* block = &graph->blocks[i];
+		for (u64 j = 0; block->isReachable && j < 2; j++) {
+			u64 succ = block->succs[j];
+			if (block->succs[j] >= 0) {
+				succs[succStarts[i] + succCnts[i]++] = succ;
+				ssa->preds[ssa->predStarts[succ] + predCnts[succ]++] = i;
+			}
+		}
+		if (isEntries[i]) {
+			succs[succStarts[ssa->root] + succCnts[ssa->root]++] = i;
+			ssa->preds[ssa->predStarts[i] + predCnts[i]++] = ssa->root;
+		}
+	}
+	free(predCnts);
+	free(succCnts);
+	free(isEntries);
+
+	ssa->order = ba_MAlloc(nodeCnt * sizeof(*ssa->order));
+	SSAOrder(ssa, succStarts, succs);
+	free(succs);
+	free(succStarts);
+	ssa->idoms = ba_MAlloc(nodeCnt * sizeof(*ssa->idoms));
+	SSADominators(ssa);
+
+	// Instructions, with the registers they use and define
+	ssa->insts = ba_CAlloc(graph->imCnt + 1, sizeof(*ssa->insts));
+	for (u64 i = 0; i < graph->imCnt; i++) {
+		struct ba_SSAInst* inst = &ssa->insts[i];
+		struct ba_IM* im = graph->ims[i];
+		inst->im = im;
+		inst->defMask = SSADefMask(im);
+		for (u64 reg = 0; reg < 16; reg++) {
+			(ba_IMRegUse(im, reg) == BA_DF_READ) &&
+				(inst->useMask |= 1llu << reg);
+		}
+		inst->useMask &= BA_SSA_REGS;
+		for (u64 j = 0; j < BA_IM_MAXVALS; j++) {
+			inst->opndVals[j] = -1;
+		}
+	}
+
+	ssa->phiMasks = ba_CAlloc(nodeCnt, sizeof(*ssa->phiMasks));
+	ssa->phiStarts = ba_CAlloc(nodeCnt, sizeof(*ssa->phiStarts));
+	SSAPlacePhis(ssa);
+
+	/* Rename: each node starts with the registers as at the end of its
+	 * immediate dominator, which reverse postorder visits first */
+	ssa->valueCap = 0x400;
+	ssa->values = ba_MAlloc(ssa->valueCap * sizeof(*ssa->values));
+	ssa->args = ba_NewDynArr64(0x400);
+	ssa->ops = ba_NewDynArr64(0x400);
+	ssa->outs = ba_MAlloc(nodeCnt * sizeof(*ssa->outs));
+	u64 regs[16] = { 0 };
+	for (u64 reg = 0; reg < 16; reg++) {
+		(BA_SSA_REGS & (1llu << reg)) &&
+			(regs[reg] = SSANewValue(ssa, BA_SSA_ENTRY, reg, ssa->root));
+	}
+	memcpy(ssa->outs[ssa->root], regs, sizeof(regs));
+
+	for (u64 i = 1; i < ssa->orderCnt; i++) {
+		u64 node = ssa->order[i];
+		memcpy(regs, ssa->outs[ssa->idoms[node]], sizeof(regs));
+		ssa->phiStarts[node] = ssa->valueCnt;
+		for (u64 reg = 0; reg < 16; reg++) {
+			if (!(ssa->phiMasks[node] & (1llu << reg))) {
+				continue;
+			}
+			regs[reg] = SSANewValue(ssa, BA_SSA_PHI, reg, node);
+			ssa->values[regs[reg]].args = ssa->args->cnt;
+			for (u64 j = ssa->predStarts[node]; j < ssa->predStarts[node+1];
+				j++)
+			{
+				SSAPush(ssa->args, 0);
+			}
+			++ssaPhiCnt;
+		}
+
+		struct ba_DFBlock* block = &graph->blocks[node];
+		for (u64 j = block->start; j < block->end; j++) {
+			struct ba_SSAInst* inst = &ssa->insts[j];
+			struct ba_IM* im = inst->im;
+			inst->ops = ssa->ops->cnt;
+			for (u64 reg = 0; reg < 16; reg++) {
+				(inst->useMask & (1llu << reg)) &&
+					(SSAPush(ssa->ops, regs[reg]), 1);
+			}
+			u64 opndIdx = 0;
+			for (u64 k = 1; k < im->count; k = SSANextOpnd(im, k)) {
+				IsSSASrcOpnd(im, k, opndIdx++) &&
+					(inst->opndVals[k] = regs[im->vals[k] - BA_IM_RAX]);
+			}
+			SSADefine(ssa, inst, node, regs);
+		}
+		memcpy(ssa->outs[node], regs, sizeof(regs));
+	}
+
+	// Phi args are the values at the end of each pred
+	for (u64 i = 1; i < ssa->orderCnt; i++) {
+		u64 node = ssa->order[i];
+		u64 phi = ssa->phiStarts[node];
+		for (u64 reg = 0; reg < 16; reg++) {
+			if (!(ssa->phiMasks[node] & (1llu << reg))) {
+				continue;
+			}
+			struct ba_SSAValue* value = &ssa->values[phi++];
+			for (u64 j = ssa->predStarts[node]; j < ssa->predStarts[node+1];
+				j++)
+			{
+				ssa->args->arr[value->args + j - ssa->predStarts[node]] =
+					ssa->outs[ssa->preds[j]][reg];
+			}
+		}
+	}
+	SSAResolvePhis(ssa);
+
+	return ssa;
+}
+
+void ba_DelSSA(struct ba_SSA* ssa) {
+	ba_DelDynArr64(ssa->ops);
+	ba_DelDynArr64(ssa->args);
+	free(ssa->values);
+	free(ssa->insts);
+	free(ssa->outs);
+	free(ssa->phiStarts);
+	free(ssa->phiMasks);
+	free(ssa->idoms);
+	free(ssa->order);
+	free(ssa->preds);
+	free(ssa->predStarts);
+	ba_DelDFGraph(ssa->graph);
+	free(ssa);
+}
+
+// ----- Instruction selection -----
+
+/* Sets regs to the values in the registers at the start of node, after its
+ * phis */
+void SSAStartNode(struct ba_SSA* ssa, u64 node, u64* regs) {
+	memcpy(regs, ssa->outs[ssa->idoms[node]], 16 * sizeof(*regs));
+	u64 phi = ssa->phiStarts[node];
+	for (u64 reg = 0; reg < 16; reg++) {
+		(ssa->phiMasks[node] & (1llu << reg)) && (regs[reg] = phi++);
+	}
+}
+
+// Moves regs past inst, unless it is dead
+void SSAStepInst(struct ba_SSA* ssa, struct ba_SSAInst* inst, u64* regs) {
+	if (inst->isDead) {
+		return;
+	}
+	u64 def = inst->ops + __builtin_popcountll(inst->useMask);
+	for (u64 reg = 0; reg < 16; reg++) {
+		(inst->defMask & (1llu << reg)) &&
+			(regs[reg] = ssa->ops->arr[def++]);
+	}
+}
+
+/* Writes the IR back as IM: dead instructions are removed, and each operand
+ * that may be any register holding its value reads the register that the
+ * value was written to if that still holds it, or else the register it read
+ * before */
+void ba_SSASelect(struct ba_Ctr* ctr, struct ba_SSA* ssa) {
+	u64 regs[16];
+	for (u64 i = 1; i < ssa->orderCnt; i++) {
+		u64 node = ssa->order[i];
+		struct ba_DFBlock* block = &ssa->graph->blocks[node];
+		SSAStartNode(ssa, node, regs);
+		for (u64 j = block->start; j < block->end; j++) {
+			struct ba_SSAInst* inst = &ssa->insts[j];
+			struct ba_IM* im = inst->im;
+			if (inst->isDead) {
+				im->count = 0;
+				continue;
+			}
+			for (u64 k = 1; k < im->count; k++) {
+				if (inst->opndVals[k] < 0) {
+					continue;
+				}
+				u64 val = inst->opndVals[k];
+				u64 reg = im->vals[k] - BA_IM_RAX;
+				u64 home = ssa->values[val].reg;
+				ba_SSAIsSame(ssa, regs[home], val) && (reg = home);
+				(BA_IM_RAX + reg != im->vals[k]) && ++ssaCopyCnt;
+				im->vals[k] = BA_IM_RAX + reg;
+			}
+			SSAStepInst(ssa, inst, regs);
+		}
+	}
+	ba_CompactIM(ctr);
+}
+
+// ----- Pass -----
+
+/* Removes moves of a value to a register that already holds it, and has
+ * operands that read a copy read what it was copied from, so that the copy
+ * may no longer be needed (see dce.c) */
+void ba_SSAOpt(struct ba_Ctr* ctr) {
+	struct ba_SSA* ssa = ba_NewSSA(ctr);
+	u64 regs[16];
+	for (u64 i = 1; i < ssa->orderCnt; i++) {
+		u64 node = ssa->order[i];
+		struct ba_DFBlock* block = &ssa->graph->blocks[node];
+		SSAStartNode(ssa, node, regs);
+		for (u64 j = block->start; j < block->end; j++) {
+			struct ba_SSAInst* inst = &ssa->insts[j];
+			struct ba_IM* im = inst->im;
+			// Moves to a register of what it already holds
+			if (im->vals[0] == BA_IM_MOV && BA_SSA_ISREG(im->vals[1])) {
+				u64 old = ba_SSARoot(ssa, regs[im->vals[1] - BA_IM_RAX]);
+				bool isConst = ssa->values[old].kind == BA_SSA_CONST;
+				(im->count == 3 && inst->opndVals[2] >= 0 &&
+					ba_SSAIsSame(ssa, old, inst->opndVals[2])) &&
+					(inst->isDead = 1);
+				(im->count == 4 && im->vals[2] == BA_IM_IMM && isConst &&
+					ssa->values[old].imm == im->vals[3]) &&
+					(inst->isDead = 1);
+			}
+			ssaMovCnt += inst->isDead;
+
+			for (u64 k = 1; k < im->count; k++) {
+				(inst->opndVals[k] >= 0) &&
+					(inst->opndVals[k] = ba_SSARoot(ssa, inst->opndVals[k]));
+			}
+			SSAStepInst(ssa, inst, regs);
+		}
+	}
+	ba_SSASelect(ctr, ssa);
+	ba_DelSSA(ssa);
+}
+
+void ba_SSAPrintStats(FILE* file) {
+	fprintf(file, "ssa: %-14s %llu\n", "values", ssaValueCnt);
+	fprintf(file, "ssa: %-14s %llu\n", "phis", ssaPhiCnt);
+	fprintf(file, "ssa: %-14s %llu\n", "moves", ssaMovCnt);
+	fprintf(file, "ssa: %-14s %llu\n", "copies", ssaCopyCnt);
+}
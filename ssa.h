@@ -0,0 +1,78 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__SSA_H
+#define BA__SSA_H
+
+#include "common/ctr.h"
+#include "dataflow.h"
+
+/* SSA form of the general-purpose registers, over the control flow graph of
+ * the whole program (dataflow.c). The parser emits IM, which is lifted into
+ * this IR once funcs are emplaced (ba_EmplaceIM): each write to a register
+ * defines a new value, phis merge values where blocks join, and each IM is an
+ * instruction that uses and defines values. Passes change the IR, then
+ * instruction selection (ba_SSASelect) writes it back as IM. Each value stays
+ * in the register it was written to, so leaving SSA needs no copies, and
+ * instruction selection only chooses, for each operand, a register that holds
+ * the value it uses. RSP and RBP are not followed. */
+
+enum {
+	BA_SSA_ENTRY = 0, // Unknown, at the start of the program or a func
+	BA_SSA_PHI,
+	BA_SSA_DEF, // Result of an instruction
+	BA_SSA_COPY, // Moved from another value
+	BA_SSA_CONST,
+};
+
+struct ba_SSAValue {
+	u8 kind;
+	u8 width; // Bits written: 64, or 8 if only the lowest byte
+	u8 reg;
+	u64 node;
+	// Value copied, or value a phi is known to be equal to (or the value)
+	u64 src;
+	u64 imm; // Value of a constant
+	u64 args; // Index in args of the value of a phi from each pred
+};
+
+struct ba_SSAInst {
+	struct ba_IM* im;
+	u64 useMask; // Registers read
+	u64 defMask; // Registers written
+	u64 ops; // Index in ops of the values used, then defined, by register
+	/* Value read by each register operand in vals that may be any register
+	 * holding the value, or -1 */
+	i64 opndVals[BA_IM_MAXVALS];
+	bool isDead;
+};
+
+/* Nodes are the blocks of the graph, and a root that comes before the start
+ * of the program and of each func, and defines their unknown values */
+struct ba_SSA {
+	struct ba_DFGraph* graph;
+	u64 root;
+	u64* order; // Reachable nodes in reverse postorder, the root first
+	u64 orderCnt;
+	i64* idoms; // Immediate dominator of each node, or -1
+	u64* predStarts; // Index in preds of each node's preds
+	u64* preds;
+	u64* phiMasks; // Registers with a phi at the start of each node
+	u64* phiStarts; // First phi value of each node, in register order
+	u64 (*outs)[16]; // Value in each register at the end of each node
+	struct ba_SSAInst* insts; // For each IM of the graph
+	struct ba_SSAValue* values;
+	u64 valueCnt;
+	u64 valueCap;
+	struct ba_DynArr64* args;
+	struct ba_DynArr64* ops;
+};
+
+struct ba_SSA* ba_NewSSA(struct ba_Ctr* ctr);
+void ba_DelSSA(struct ba_SSA* ssa);
+u64 ba_SSARoot(struct ba_SSA* ssa, u64 val);
+bool ba_SSAIsSame(struct ba_SSA* ssa, u64 lhs, u64 rhs);
+void ba_SSASelect(struct ba_Ctr* ctr, struct ba_SSA* ssa);
+void ba_SSAOpt(struct ba_Ctr* ctr);
+void ba_SSAPrintStats(FILE* file);
+
+#endif
@@ -0,0 +1,80 @@
+// See LICENSE for copyright/license information
+
+#include "tailcall.h"
+#include "lexer.h"
+#include "common/options.h"
+#include "common/symtable.h"
+
+u64 tailCallCnt = 0;
+
+/* Position (line in the upper 32 bits, column in the lower 32) of the "("
+ * of a call to func that makes up the whole of the exp about to be parsed,
+ * which must end in ";", or 0 if there is no such call */
+u64 ba_TailCallPos(struct ba_Ctr* ctr, struct ba_Func* func) {
+	if (ba_GetOptLevel() < BA_OPT_TAILCALLLEVEL ||
+		func->retType.type == BA_TYPE_ARR ||
+		BA_LEX_TYPE(ctr) != BA_TK_IDENTIFIER)
+	{
+		return 0;
+	}
+	struct ba_STVal* id = ba_STParentFind(ctr->currScope, 
+		/* stFoundInPtr = */ 0, BA_LEX_VAL(ctr));
+	if (!id || id->type.type != BA_TYPE_FUNC || id->type.extraInfo != func) {
+		return 0;
+	}
+
+	struct ba_TkBuf* tks = ctr->tks;
+	u64 lex = ba_TkNext(tks, ctr->lex);
+	ba_LexUpTo(ctr, lex);
+	if (tks->types[BA_TK_SLOT(tks, lex)] != '(') {
+		return 0;
+	}
+	u64 pos = tks->lineCols[BA_TK_SLOT(tks, lex)];
+
+	// Find the matching ")"
+	u64 paren = 1;
+	while (paren) {
+		lex = ba_TkNext(tks, lex);
+		ba_LexUpTo(ctr, lex);
+		u64 type = tks->types[BA_TK_SLOT(tks, lex)];
+		if (type == BA_TK_EOF || type == BA_TK_FILECHANGE) {
+			return 0;
+		}
+		paren += (type == '(') - (type == ')');
+	}
+	lex = ba_TkNext(tks, lex);
+	ba_LexUpTo(ctr, lex);
+	return tks->types[BA_TK_SLOT(tks, lex)] == ';' ? pos : 0;
+}
+
+// Whether the call to func at line:col is the one found by ba_TailCallPos
+bool ba_IsTailCall(struct ba_Ctr* ctr, struct ba_Func* func, u64 line, 
+	u64 col)
+{
+	return ctr->tailCallPos && ctr->tailCallPos == ((line << 32) | col) &&
+		func == ctr->currScope->func;
+}
+
+/* Once the args are in registers and on the stack, start the func again in 
+ * the same frame */
+void ba_TailCall(struct ba_Ctr* ctr, struct ba_Func* func) {
+	ba_StkTop(ctr->genImStk) && ++tailCallCnt;
+	/* Args on the stack replace the func's own, which are just above its 
+	 * frame, going through rax (never an arg register) */
+	u64 ofst = 0;
+	while (ofst < func->paramStackSize) {
+		u64 size = func->paramStackSize - ofst >= 8 ? 8 : 1;
+		u64 reg = ba_AdjRegSize(BA_IM_RAX, size);
+		ba_AddIM(ctr, 5, BA_IM_MOV, reg, BA_IM_ADRADD, BA_IM_RSP, ofst);
+		ba_AddIM(ctr, 5, BA_IM_MOV, BA_IM_ADRADD, BA_IM_RBP, 
+			func->contextSize + ofst, reg);
+		ofst += size;
+	}
+	// Written relative to RBP so the func can still be inlined
+	ba_AddIM(ctr, 5, BA_IM_LEA, BA_IM_RSP, BA_IM_ADRSUB, BA_IM_RBP, 0);
+	ba_AddIM(ctr, 2, BA_IM_LABELJMP, func->lblBody);
+}
+
+void ba_TailCallPrintStats(FILE* file) {
+	fprintf(file, "tailcall: %-9s %llu\n", "calls", tailCallCnt);
+}
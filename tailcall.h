@@ -0,0 +1,21 @@
+// See LICENSE for copyright/license information
+
+#ifndef BA__TAILCALL_H
+#define BA__TAILCALL_H
+
+#include "common/ctr.h"
+#include "common/func.h"
+
+/* Turns a func calling itself in tail position ("return F(...);") into a
+ * jump back to the start of its body, after its args have been put in
+ * registers and over the args it was passed on the stack, so that the call
+ * reuses the current stack frame. Funcs that return arrays are not 
+ * handled. */
+
+u64 ba_TailCallPos(struct ba_Ctr* ctr, struct ba_Func* func);
+bool ba_IsTailCall(struct ba_Ctr* ctr, struct ba_Func* func, u64 line, 
+	u64 col);
+void ba_TailCall(struct ba_Ctr* ctr, struct ba_Func* func);
+void ba_TailCallPrintStats(FILE* file);
+
+#endif